@@ -206,6 +206,36 @@
 #define DB_HEAP_CACHE_LIMIT		1
 #endif /* DB_HEAP_CACHE_LIMIT */
 
+/* The maximum number of B+-tree indexes. */
+#ifndef DB_BTREE_INDEX_LIMIT
+#define DB_BTREE_INDEX_LIMIT		1
+#endif /* DB_BTREE_INDEX_LIMIT */
+
+/* The maximum number of nodes in a B+-tree index, including the header. */
+#ifndef DB_BTREE_NODE_LIMIT
+#define DB_BTREE_NODE_LIMIT		256
+#endif /* DB_BTREE_NODE_LIMIT */
+
+/* The maximum number of nodes cached in the B+-tree index. */
+#ifndef DB_BTREE_CACHE_LIMIT
+#define DB_BTREE_CACHE_LIMIT		4
+#endif /* DB_BTREE_CACHE_LIMIT */
+
+/*----------------------------------------------------------------------------*/
+
+/* Join options. */
+
+/* The size of the RAM area in which the hash join keeps a block of
+   tuples from the smaller relation. Set it to 0 to disable hash joins. */
+#ifndef DB_JOIN_AREA_SIZE
+#define DB_JOIN_AREA_SIZE		512
+#endif /* DB_JOIN_AREA_SIZE */
+
+/* The number of hash buckets for the tuples in the join area. */
+#ifndef DB_JOIN_HASH_BUCKETS
+#define DB_JOIN_HASH_BUCKETS		16
+#endif /* DB_JOIN_HASH_BUCKETS */
+
 /*----------------------------------------------------------------------------*/
 
 /* LVM options. */
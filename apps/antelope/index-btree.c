@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *     A B+-tree index for flash memory.
+ *
+ *     The tree is stored in a single file that consists of fixed-size
+ *     nodes. Node 0 holds the tree header, and the other nodes are
+ *     allocated sequentially as the tree grows, so the file is only
+ *     ever extended at its end. Leaves hold (key, tuple id) pairs in
+ *     key order, and every node links to its right sibling, which
+ *     makes range queries a matter of finding the first leaf and
+ *     following the links.
+ *
+ *     Entry i of an internal node refers to a child whose keys are
+ *     in the range [key(i), key(i + 1)]; the key of the first entry
+ *     is not used for searching. Duplicate keys may therefore span
+ *     several leaves.
+ *
+ *     When a key is appended at the end of the rightmost node on a
+ *     level, the node is split so that it stays full and the new
+ *     node starts with the appended key alone. Loading an index
+ *     over a relation with increasing keys, e.g. a time series,
+ *     thus packs the leaves as densely as a bottom-up bulk load.
+ *
+ *     Recently used nodes are kept in a small cache. Modified nodes
+ *     are written through, so that the tree on storage is always
+ *     consistent after an operation has returned.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfs/cfs.h"
+#include "lib/memb.h"
+
+#include "db-options.h"
+#include "index.h"
+#include "result.h"
+#include "storage.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#define BTREE_FANOUT		16
+#define BTREE_MAX_HEIGHT	8
+
+#define HEADER_NODE		0
+#define NULL_NODE		0
+
+#if DB_BTREE_NODE_LIMIT > 65535
+#error "DB_BTREE_NODE_LIMIT must fit in a 16-bit node number."
+#endif
+
+typedef uint16_t btree_node_id_t;
+
+struct btree_entry {
+  long key;
+  /* A tuple ID in a leaf, or a child node in an internal node. */
+  tuple_id_t value;
+};
+
+struct btree_node {
+  uint8_t is_leaf;
+  uint8_t count;
+  btree_node_id_t next;
+  struct btree_entry entries[BTREE_FANOUT];
+};
+
+struct btree_header {
+  btree_node_id_t root;
+  btree_node_id_t node_count;
+  uint8_t height;
+};
+
+struct btree {
+  db_storage_id_t storage;
+  struct btree_header header;
+};
+typedef struct btree btree_t;
+
+struct node_cache {
+  btree_t *tree;
+  btree_node_id_t node_id;
+  unsigned long last_used;
+  struct btree_node node;
+};
+
+/* Keep a cache of nodes read from storage. */
+static struct node_cache node_cache[DB_BTREE_CACHE_LIMIT];
+static unsigned long cache_clock;
+MEMB(btrees, btree_t, DB_BTREE_INDEX_LIMIT);
+
+/* Scratch space for splitting a full node. */
+static struct btree_entry split_entries[BTREE_FANOUT + 1];
+static struct btree_node split_node;
+
+static struct btree_node *node_get(btree_t *, btree_node_id_t);
+static int node_put(btree_t *, btree_node_id_t, struct btree_node *);
+static void invalidate_cache(btree_t *);
+static int header_write(btree_t *);
+static btree_node_id_t find_leaf(btree_t *, long);
+static int insert_item(btree_t *, long, tuple_id_t);
+
+static db_result_t create(index_t *);
+static db_result_t destroy(index_t *);
+static db_result_t load(index_t *);
+static db_result_t release(index_t *);
+static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
+static db_result_t delete(index_t *, attribute_value_t *);
+static tuple_id_t get_next(index_iterator_t *);
+
+index_api_t index_btree = {
+  INDEX_BTREE,
+  INDEX_API_EXTERNAL | INDEX_API_RANGE_QUERIES,
+  create,
+  destroy,
+  load,
+  release,
+  insert,
+  delete,
+  get_next
+};
+
+static struct btree_node *
+node_get(btree_t *tree, btree_node_id_t node_id)
+{
+  struct node_cache *cache;
+  int i;
+
+  cache = &node_cache[0];
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    if(node_cache[i].tree == tree && node_cache[i].node_id == node_id) {
+      node_cache[i].last_used = ++cache_clock;
+      return &node_cache[i].node;
+    }
+    /* Remember the least recently used node as the replacement. */
+    if(node_cache[i].tree == NULL ||
+       (cache->tree != NULL && node_cache[i].last_used < cache->last_used)) {
+      cache = &node_cache[i];
+    }
+  }
+
+  /* All cached nodes are clean, so the replaced one can be dropped. */
+  cache->tree = NULL;
+  if(DB_ERROR(storage_read(tree->storage, &cache->node,
+                           (unsigned long)node_id * sizeof(struct btree_node),
+                           sizeof(struct btree_node)))) {
+    PRINTF("DB: Failed to read B+-tree node %u\n", (unsigned)node_id);
+    return NULL;
+  }
+
+  cache->tree = tree;
+  cache->node_id = node_id;
+  cache->last_used = ++cache_clock;
+
+  return &cache->node;
+}
+
+static int
+node_put(btree_t *tree, btree_node_id_t node_id, struct btree_node *node)
+{
+  int i;
+
+  if(DB_ERROR(storage_write(tree->storage, node,
+                            (unsigned long)node_id * sizeof(struct btree_node),
+                            sizeof(struct btree_node)))) {
+    PRINTF("DB: Failed to write B+-tree node %u\n", (unsigned)node_id);
+    invalidate_cache(tree);
+    return 0;
+  }
+
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    if(node_cache[i].tree == tree && node_cache[i].node_id == node_id) {
+      if(&node_cache[i].node != node) {
+        memcpy(&node_cache[i].node, node, sizeof(*node));
+      }
+      break;
+    }
+  }
+
+  return 1;
+}
+
+static void
+invalidate_cache(btree_t *tree)
+{
+  int i;
+
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    if(node_cache[i].tree == tree) {
+      node_cache[i].tree = NULL;
+    }
+  }
+}
+
+static int
+header_write(btree_t *tree)
+{
+  if(DB_ERROR(storage_write(tree->storage, &tree->header,
+                            HEADER_NODE, sizeof(tree->header)))) {
+    return 0;
+  }
+
+  return 1;
+}
+
+static btree_node_id_t
+allocate_node(btree_t *tree)
+{
+  if(tree->header.node_count >= DB_BTREE_NODE_LIMIT) {
+    PRINTF("DB: No more B+-tree nodes available\n");
+    return NULL_NODE;
+  }
+
+  /* Persist the node count before the node is used. */
+  tree->header.node_count++;
+  if(header_write(tree) == 0) {
+    tree->header.node_count--;
+    return NULL_NODE;
+  }
+
+  return tree->header.node_count - 1;
+}
+
+/* Find the leftmost leaf that may contain the key. */
+static btree_node_id_t
+find_leaf(btree_t *tree, long key)
+{
+  btree_node_id_t node_id;
+  struct btree_node *node;
+  int i;
+
+  for(node_id = tree->header.root;;) {
+    node = node_get(tree, node_id);
+    if(node == NULL) {
+      return NULL_NODE;
+    }
+    if(node->is_leaf) {
+      return node_id;
+    }
+
+    for(i = node->count - 1; i > 0 && node->entries[i].key >= key; i--);
+    node_id = (btree_node_id_t)node->entries[i].value;
+  }
+}
+
+static int
+insert_item(btree_t *tree, long key, tuple_id_t value)
+{
+  btree_node_id_t path[BTREE_MAX_HEIGHT];
+  uint8_t path_pos[BTREE_MAX_HEIGHT];
+  btree_node_id_t node_id;
+  btree_node_id_t new_id;
+  struct btree_node *node;
+  struct btree_entry entry;
+  int depth;
+  int pos;
+  int split;
+
+  /* Descend to the leaf, remembering the internal nodes on the way. */
+  depth = 0;
+  for(node_id = tree->header.root;;) {
+    node = node_get(tree, node_id);
+    if(node == NULL) {
+      return 0;
+    }
+    if(node->is_leaf) {
+      break;
+    }
+    if(depth == BTREE_MAX_HEIGHT - 1) {
+      PRINTF("DB: The B+-tree is too high\n");
+      return 0;
+    }
+
+    for(pos = node->count - 1; pos > 0 && node->entries[pos].key > key; pos--);
+    path[depth] = node_id;
+    path_pos[depth++] = pos;
+    node_id = (btree_node_id_t)node->entries[pos].value;
+  }
+
+  entry.key = key;
+  entry.value = value;
+
+  /* Insert the key after any equal keys in the leaf. */
+  for(pos = 0; pos < node->count && node->entries[pos].key <= key; pos++);
+
+  for(;;) {
+    if(node->count < BTREE_FANOUT) {
+      memmove(&node->entries[pos + 1], &node->entries[pos],
+              (node->count - pos) * sizeof(struct btree_entry));
+      node->entries[pos] = entry;
+      node->count++;
+      return node_put(tree, node_id, node);
+    }
+
+    new_id = allocate_node(tree);
+    if(new_id == NULL_NODE) {
+      return 0;
+    }
+
+    memcpy(split_entries, node->entries, pos * sizeof(struct btree_entry));
+    split_entries[pos] = entry;
+    memcpy(&split_entries[pos + 1], &node->entries[pos],
+           (BTREE_FANOUT - pos) * sizeof(struct btree_entry));
+
+    if(pos == BTREE_FANOUT && node->next == NULL_NODE) {
+      split = BTREE_FANOUT;
+    } else {
+      split = (BTREE_FANOUT + 1) / 2;
+    }
+
+    PRINTF("DB: Split B+-tree node %u at entry %d into node %u\n",
+           (unsigned)node_id, split, (unsigned)new_id);
+
+    split_node.is_leaf = node->is_leaf;
+    split_node.count = BTREE_FANOUT + 1 - split;
+    split_node.next = node->next;
+    memset(split_node.entries, 0, sizeof(split_node.entries));
+    memcpy(split_node.entries, &split_entries[split],
+           split_node.count * sizeof(struct btree_entry));
+
+    node->count = split;
+    node->next = new_id;
+    memcpy(node->entries, split_entries, split * sizeof(struct btree_entry));
+
+    /* Write the new node before linking to it. */
+    if(node_put(tree, new_id, &split_node) == 0 ||
+       node_put(tree, node_id, node) == 0) {
+      return 0;
+    }
+
+    entry.key = split_node.entries[0].key;
+    entry.value = new_id;
+
+    if(depth == 0) {
+      /* The root was split, so the tree grows by one level. */
+      if(tree->header.height == BTREE_MAX_HEIGHT) {
+        PRINTF("DB: The B+-tree is too high\n");
+        return 0;
+      }
+      node_id = allocate_node(tree);
+      if(node_id == NULL_NODE) {
+        return 0;
+      }
+
+      memset(&split_node, 0, sizeof(split_node));
+      split_node.count = 2;
+      split_node.entries[0].key = split_entries[0].key;
+      split_node.entries[0].value = tree->header.root;
+      split_node.entries[1] = entry;
+      if(node_put(tree, node_id, &split_node) == 0) {
+        return 0;
+      }
+
+      tree->header.root = node_id;
+      tree->header.height++;
+      return header_write(tree);
+    }
+
+    /* Link the new node into the parent right after the split one. */
+    node_id = path[--depth];
+    pos = path_pos[depth] + 1;
+    node = node_get(tree, node_id);
+    if(node == NULL) {
+      return 0;
+    }
+  }
+}
+
+static db_result_t
+create(index_t *index)
+{
+  char *filename;
+  btree_t *tree;
+  struct btree_node root;
+
+  filename = storage_generate_file("btree",
+                                   (unsigned long)DB_BTREE_NODE_LIMIT * sizeof(struct btree_node));
+  if(filename == NULL) {
+    PRINTF("DB: Failed to generate a B+-tree file\n");
+    return DB_INDEX_ERROR;
+  }
+
+  memcpy(index->descriptor_file, filename,
+         sizeof(index->descriptor_file));
+
+  PRINTF("DB: Generated the B+-tree file \"%s\" using %lu bytes of space\n",
+         index->descriptor_file,
+         (unsigned long)DB_BTREE_NODE_LIMIT * sizeof(struct btree_node));
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    cfs_remove(index->descriptor_file);
+    index->descriptor_file[0] = '\0';
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    goto error;
+  }
+
+  /* The tree starts out as a single empty leaf. */
+  tree->header.node_count = 1;
+  tree->header.root = allocate_node(tree);
+  tree->header.height = 1;
+
+  memset(&root, 0, sizeof(root));
+  root.is_leaf = 1;
+  if(node_put(tree, tree->header.root, &root) == 0 ||
+     header_write(tree) == 0) {
+    storage_close(tree->storage);
+    goto error;
+  }
+
+  PRINTF("DB: Created a B+-tree index\n");
+  return DB_OK;
+
+error:
+  memb_free(&btrees, tree);
+  index->opaque_data = NULL;
+  cfs_remove(index->descriptor_file);
+  index->descriptor_file[0] = '\0';
+  return DB_STORAGE_ERROR;
+}
+
+static db_result_t
+destroy(index_t *index)
+{
+  if(index->opaque_data != NULL) {
+    release(index);
+  }
+
+  if(cfs_remove(index->descriptor_file) < 0) {
+    return DB_STORAGE_ERROR;
+  }
+
+  return DB_OK;
+}
+
+static db_result_t
+load(index_t *index)
+{
+  btree_t *tree;
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    memb_free(&btrees, tree);
+    index->opaque_data = NULL;
+    return DB_STORAGE_ERROR;
+  }
+
+  if(DB_ERROR(storage_read(tree->storage, &tree->header,
+                           HEADER_NODE, sizeof(tree->header))) ||
+     tree->header.root == NULL_NODE ||
+     tree->header.root >= tree->header.node_count) {
+    PRINTF("DB: Invalid B+-tree header in %s\n", index->descriptor_file);
+    release(index);
+    return DB_STORAGE_ERROR;
+  }
+
+  PRINTF("DB: Loaded a B+-tree index of height %u from file %s\n",
+         (unsigned)tree->header.height, index->descriptor_file);
+
+  return DB_OK;
+}
+
+static db_result_t
+release(index_t *index)
+{
+  btree_t *tree;
+
+  tree = index->opaque_data;
+
+  invalidate_cache(tree);
+  storage_close(tree->storage);
+  memb_free(&btrees, tree);
+  index->opaque_data = NULL;
+  return DB_OK;
+}
+
+static db_result_t
+insert(index_t *index, attribute_value_t *key, tuple_id_t value)
+{
+  long long_key;
+
+  long_key = db_value_to_long(key);
+
+  if(insert_item(index->opaque_data, long_key, value) == 0) {
+    PRINTF("DB: Failed to insert key %ld into a B+-tree index\n", long_key);
+    return DB_INDEX_ERROR;
+  }
+  return DB_OK;
+}
+
+/*
+ * Remove one entry with the given key. Underfull nodes are not merged,
+ * as that would cost more flash writes than the space it saves.
+ */
+static db_result_t
+delete(index_t *index, attribute_value_t *value)
+{
+  btree_t *tree;
+  btree_node_id_t node_id;
+  struct btree_node *node;
+  long key;
+  int i;
+
+  tree = index->opaque_data;
+  key = db_value_to_long(value);
+
+  for(node_id = find_leaf(tree, key); node_id != NULL_NODE;
+      node_id = node->next) {
+    node = node_get(tree, node_id);
+    if(node == NULL) {
+      return DB_STORAGE_ERROR;
+    }
+
+    for(i = 0; i < node->count; i++) {
+      if(node->entries[i].key > key) {
+        return DB_INDEX_ERROR;
+      } else if(node->entries[i].key == key) {
+        node->count--;
+        memmove(&node->entries[i], &node->entries[i + 1],
+                (node->count - i) * sizeof(struct btree_entry));
+        memset(&node->entries[node->count], 0, sizeof(struct btree_entry));
+        return node_put(tree, node_id, node) ? DB_OK : DB_STORAGE_ERROR;
+      }
+    }
+  }
+
+  return DB_INDEX_ERROR;
+}
+
+static tuple_id_t
+get_next(index_iterator_t *iterator)
+{
+  struct iteration_cache {
+    index_iterator_t *index_iterator;
+    btree_node_id_t node_id;
+    uint8_t slot;
+    tuple_id_t found_items;
+  };
+  static struct iteration_cache cache;
+  btree_t *tree;
+  struct btree_node *node;
+  struct btree_entry *entry;
+  long min;
+  long max;
+
+  tree = iterator->index->opaque_data;
+  min = db_value_to_long(&iterator->min_value);
+  max = db_value_to_long(&iterator->max_value);
+
+  if(cache.index_iterator != iterator || iterator->next_item_no == 0 ||
+     cache.found_items != iterator->next_item_no) {
+    /* Start a new search, and skip the items that have already been
+       returned if another iterator has used the cache meanwhile. */
+    cache.index_iterator = iterator;
+    cache.node_id = find_leaf(tree, min);
+    cache.slot = 0;
+    cache.found_items = 0;
+  }
+
+  while(cache.node_id != NULL_NODE) {
+    node = node_get(tree, cache.node_id);
+    if(node == NULL) {
+      cache.node_id = NULL_NODE;
+      break;
+    }
+
+    while(cache.slot < node->count) {
+      entry = &node->entries[cache.slot++];
+      if(entry->key < min) {
+        continue;
+      }
+      if(entry->key > max) {
+        cache.node_id = NULL_NODE;
+        return INVALID_TUPLE;
+      }
+      if(cache.found_items++ == iterator->next_item_no) {
+        iterator->next_item_no++;
+        return entry->value;
+      }
+    }
+
+    cache.node_id = node->next;
+    cache.slot = 0;
+  }
+
+  return INVALID_TUPLE;
+}
@@ -79,6 +79,57 @@ struct source_map {
 };
 
 static struct source_map source_map[AQL_ATTRIBUTE_LIMIT];
+
+#define JOIN_METHOD_INDEX	0
+#define JOIN_METHOD_HASH	1
+#define JOIN_METHOD_MERGE	2
+
+#define JOIN_FLAG_LEFT		0x01
+#define JOIN_FLAG_KEY		0x02
+
+/*
+ * The join_state structure keeps the position of a hash join or a
+ * merge join between calls to relation_process_join(). The hash join
+ * loads blocks of tuples from the smaller ("build") relation into the
+ * join area and scans the other ("probe") relation once per block. The
+ * merge join uses the build fields for the left relation and the probe
+ * fields for the right relation.
+ */
+struct join_state {
+  relation_t *build_rel;
+  relation_t *probe_rel;
+  attribute_t *build_attr;
+  attribute_t *probe_attr;
+  unsigned char *build_row;
+  unsigned char *probe_row;
+  tuple_id_t build_id;
+  tuple_id_t probe_id;
+  tuple_id_t group_id;
+  long key;
+  unsigned entry_size;
+  uint16_t entry_limit;
+  uint16_t entry_count;
+  uint16_t entry;
+  uint8_t method;
+  uint8_t flags;
+};
+
+static struct join_state join;
+
+#if DB_JOIN_AREA_SIZE > 0
+struct join_entry {
+  long key;
+  /* The number of the next entry in the same bucket, or 0. */
+  uint16_t next;
+};
+
+#define JOIN_HASH(key)		((unsigned long)(key) % DB_JOIN_HASH_BUCKETS)
+#define JOIN_ENTRY(n)		((struct join_entry *) \
+				 ((unsigned char *)join_area + (n) * join.entry_size))
+
+static long join_area[(DB_JOIN_AREA_SIZE + sizeof(long) - 1) / sizeof(long)];
+static uint16_t join_buckets[DB_JOIN_HASH_BUCKETS];
+#endif /* DB_JOIN_AREA_SIZE > 0 */
 #endif /* DB_FEATURE_JOIN */
 
 static unsigned char row[DB_MAX_ATTRIBUTES_PER_RELATION * DB_MAX_ELEMENT_SIZE];
@@ -250,7 +301,10 @@ relation_load(char *name)
   list_add(relations, rel);
 
 end:
-  if(rel->dir == DB_STORAGE && DB_ERROR(storage_load(rel))) {
+  /* Open the tuple file only for the first reference, so that loading
+     a relation that is being processed does not leak a descriptor. */
+  if(rel->dir == DB_STORAGE && rel->references == 1 &&
+     DB_ERROR(storage_load(rel))) {
     relation_release(rel);
     return NULL;
   }
@@ -959,24 +1013,61 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
 }
 
 #if DB_FEATURE_JOIN
-db_result_t
-relation_process_join(void *handle_ptr)
+static db_result_t
+emit_join_row(db_handle_t *handle)
+{
+  unsigned char *join_next_attribute_ptr;
+  size_t element_size;
+  int i;
+
+  /* Use the source attribute map to fill in the physical representation
+     of the resulting tuple. */
+  join_next_attribute_ptr = join_row;
+
+  for(i = 0; i < handle->join_rel->attribute_count; i++) {
+    element_size = source_map[i].attr->element_size;
+
+    memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
+    join_next_attribute_ptr += element_size;
+  }
+
+  if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(handle->join_rel, join_row))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
+static db_result_t
+get_join_key(relation_t *rel, attribute_t *attr, unsigned char *row_ptr,
+             long *key)
+{
+  attribute_value_t value;
+
+  if(DB_ERROR(relation_get_value(rel, attr, row_ptr, &value))) {
+    PRINTF("DB: Failed to get a value of the attribute \"%s\" to join on\n",
+	attr->name);
+    return DB_IMPLEMENTATION_ERROR;
+  }
+
+  *key = db_value_to_long(&value);
+  return DB_OK;
+}
+
+static db_result_t
+index_join(db_handle_t *handle)
 {
-  db_handle_t *handle;
   db_result_t result;
   relation_t *left_rel;
   relation_t *right_rel;
-  relation_t *join_rel;
-  unsigned char *join_next_attribute_ptr;
-  size_t element_size;
   tuple_id_t right_tuple_id;
   attribute_value_t value;
-  int i;
 
-  handle = (db_handle_t *)handle_ptr;
   left_rel = handle->left_rel;
   right_rel = handle->right_rel;
-  join_rel = handle->join_rel;
 
   if(!(handle->flags & DB_HANDLE_FLAG_INDEX_STEP)) {
     goto inner_loop;
@@ -1030,29 +1121,168 @@ inner_loop:
         return DB_IMPLEMENTATION_ERROR;
       }
 
-      /* Use the source attribute map to fill in the physical representation
-	 of the resulting tuple. */
-      join_next_attribute_ptr = join_row;
+      return emit_join_row(handle);
+    }
+  }
+
+  return DB_OK;
+}
+
+#if DB_JOIN_AREA_SIZE > 0
+static db_result_t
+load_join_block(void)
+{
+  struct join_entry *entry;
+  db_result_t result;
+  long key;
 
-      for(i = 0; i < join_rel->attribute_count; i++) {
-	element_size = source_map[i].attr->element_size;
+  memset(join_buckets, 0, sizeof(join_buckets));
 
-	memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
-	join_next_attribute_ptr += element_size;
+  for(join.entry_count = 0; join.entry_count < join.entry_limit;) {
+    result = storage_get_row(join.build_rel, &join.build_id, join.build_row);
+    if(DB_ERROR(result)) {
+      return result;
+    } else if(result == DB_FINISHED) {
+      break;
+    }
+    join.build_id++;
+
+    if(DB_ERROR(get_join_key(join.build_rel, join.build_attr,
+                             join.build_row, &key))) {
+      return DB_IMPLEMENTATION_ERROR;
+    }
+
+    entry = JOIN_ENTRY(join.entry_count);
+    entry->key = key;
+    entry->next = join_buckets[JOIN_HASH(key)];
+    memcpy(entry + 1, join.build_row, join.build_rel->row_length);
+    join_buckets[JOIN_HASH(key)] = ++join.entry_count;
+  }
+
+  PRINTF("DB: Loaded %u tuples of relation %s into the join area\n",
+         (unsigned)join.entry_count, join.build_rel->name);
+
+  return join.entry_count > 0 ? DB_OK : DB_FINISHED;
+}
+
+static db_result_t
+hash_join(db_handle_t *handle)
+{
+  struct join_entry *entry;
+  db_result_t result;
+
+  for(;;) {
+    /* Emit the next tuple of the block that matches the probe tuple. */
+    while(join.entry != 0) {
+      entry = JOIN_ENTRY(join.entry - 1);
+      join.entry = entry->next;
+      if(entry->key == join.key) {
+        memcpy(join.build_row, entry + 1, join.build_rel->row_length);
+        return emit_join_row(handle);
       }
+    }
 
-      if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
-        if(DB_ERROR(storage_put_row(join_rel, join_row))) {
-          return DB_STORAGE_ERROR;
-        }
+    if(join.entry_count == 0) {
+      result = load_join_block();
+      if(result != DB_OK) {
+        return result;
       }
+      join.probe_id = 0;
+    }
 
-      handle->current_row++;
-      return DB_GOT_ROW;
+    result = storage_get_row(join.probe_rel, &join.probe_id, join.probe_row);
+    if(DB_ERROR(result)) {
+      return result;
+    } else if(result == DB_FINISHED) {
+      /* All probe tuples have been joined with this block. */
+      join.entry_count = 0;
+      continue;
     }
+    join.probe_id++;
+
+    if(DB_ERROR(get_join_key(join.probe_rel, join.probe_attr,
+                             join.probe_row, &join.key))) {
+      return DB_IMPLEMENTATION_ERROR;
+    }
+    join.entry = join_buckets[JOIN_HASH(join.key)];
   }
+}
+#endif /* DB_JOIN_AREA_SIZE > 0 */
 
-  return DB_OK;
+static db_result_t
+merge_join(db_handle_t *handle)
+{
+  db_result_t result;
+  long key;
+
+  for(;;) {
+    if(!(join.flags & JOIN_FLAG_LEFT)) {
+      result = storage_get_row(join.build_rel, &join.build_id, left_row);
+      if(result != DB_OK) {
+        return result;
+      }
+      join.build_id++;
+
+      if(DB_ERROR(get_join_key(join.build_rel, join.build_attr,
+                               left_row, &key))) {
+        return DB_IMPLEMENTATION_ERROR;
+      }
+
+      if((join.flags & JOIN_FLAG_KEY) && key == join.key) {
+        /* Join the same group of right tuples again. */
+        join.probe_id = join.group_id;
+      } else {
+        join.group_id = join.probe_id;
+      }
+      join.key = key;
+      join.flags |= JOIN_FLAG_LEFT | JOIN_FLAG_KEY;
+    }
+
+    result = storage_get_row(join.probe_rel, &join.probe_id, right_row);
+    if(DB_ERROR(result)) {
+      return result;
+    } else if(result == DB_FINISHED) {
+      if(join.group_id == join.probe_id) {
+        /* No right tuples remain for this or any larger key. */
+        return DB_FINISHED;
+      }
+      join.flags &= ~JOIN_FLAG_LEFT;
+      continue;
+    }
+
+    if(DB_ERROR(get_join_key(join.probe_rel, join.probe_attr,
+                             right_row, &key))) {
+      return DB_IMPLEMENTATION_ERROR;
+    }
+
+    if(key < join.key) {
+      join.group_id = ++join.probe_id;
+    } else if(key > join.key) {
+      join.flags &= ~JOIN_FLAG_LEFT;
+    } else {
+      join.probe_id++;
+      return emit_join_row(handle);
+    }
+  }
+}
+
+db_result_t
+relation_process_join(void *handle_ptr)
+{
+  db_handle_t *handle;
+
+  handle = (db_handle_t *)handle_ptr;
+
+  switch(join.method) {
+#if DB_JOIN_AREA_SIZE > 0
+  case JOIN_METHOD_HASH:
+    return hash_join(handle);
+#endif /* DB_JOIN_AREA_SIZE > 0 */
+  case JOIN_METHOD_MERGE:
+    return merge_join(handle);
+  default:
+    return index_join(handle);
+  }
 }
 
 static db_result_t
@@ -1107,6 +1337,135 @@ generate_join_result(db_handle_t *handle)
   return DB_OK;
 }
 
+/* A relation is sorted on an attribute that has an inline index. */
+static int
+join_sorted(attribute_t *attr)
+{
+  return index_exists(attr) && ((index_t *)attr->index)->type == INDEX_INLINE;
+}
+
+/* The join keys of an attribute can be compared as long integers. */
+static int
+join_numeric(attribute_t *attr)
+{
+  return attr->domain == DOMAIN_INT || attr->domain == DOMAIN_LONG;
+}
+
+/*
+ * Select the join method that reads the fewest tuples, given the
+ * cardinalities of the relations. An index nested-loop join reads
+ * each left tuple and looks up its key in the index of the right
+ * relation. A merge join reads both relations once, but requires that
+ * both are sorted on the join attribute. A hash join reads the smaller
+ * relation once and the larger relation once per block of the smaller
+ * relation that fits in the join area. The merge and hash joins are
+ * only possible if both join attributes are numeric.
+ */
+static db_result_t
+plan_join(db_handle_t *handle)
+{
+  tuple_id_t left_cardinality;
+  tuple_id_t right_cardinality;
+  tuple_id_t i;
+  unsigned long cost;
+  unsigned long best_cost;
+  unsigned long lookup_cost;
+  int numeric;
+#if DB_JOIN_AREA_SIZE > 0
+  unsigned long passes;
+  unsigned entry_size;
+  unsigned long entry_limit;
+  int build_left;
+#endif /* DB_JOIN_AREA_SIZE > 0 */
+
+  left_cardinality = relation_cardinality(handle->left_rel);
+  right_cardinality = relation_cardinality(handle->right_rel);
+  if(left_cardinality == INVALID_TUPLE || right_cardinality == INVALID_TUPLE) {
+    return DB_STORAGE_ERROR;
+  }
+
+  memset(&join, 0, sizeof(join));
+  best_cost = ULONG_MAX;
+  numeric = join_numeric(handle->left_join_attr) &&
+            join_numeric(handle->right_join_attr);
+
+  if(index_exists(handle->right_join_attr)) {
+    /* Assume that a lookup reads a logarithmic number of tuples. */
+    for(lookup_cost = 1, i = right_cardinality; i > 1; i >>= 1) {
+      lookup_cost++;
+    }
+    best_cost = left_cardinality + left_cardinality * lookup_cost;
+    join.method = JOIN_METHOD_INDEX;
+  }
+
+  if(numeric && join_sorted(handle->left_join_attr) &&
+     join_sorted(handle->right_join_attr)) {
+    cost = (unsigned long)left_cardinality + right_cardinality;
+    if(cost < best_cost) {
+      best_cost = cost;
+      join.method = JOIN_METHOD_MERGE;
+      join.build_rel = handle->left_rel;
+      join.build_attr = handle->left_join_attr;
+      join.probe_rel = handle->right_rel;
+      join.probe_attr = handle->right_join_attr;
+    }
+  }
+
+#if DB_JOIN_AREA_SIZE > 0
+  build_left = left_cardinality <= right_cardinality;
+  entry_size = sizeof(struct join_entry) +
+    (build_left ? handle->left_rel : handle->right_rel)->row_length;
+  entry_size = (entry_size + sizeof(long) - 1) & ~(sizeof(long) - 1);
+  entry_limit = DB_JOIN_AREA_SIZE / entry_size;
+  if(entry_limit > UINT16_MAX) {
+    entry_limit = UINT16_MAX;
+  }
+
+  if(numeric && entry_limit > 0) {
+    if(build_left) {
+      passes = (left_cardinality + entry_limit - 1) / entry_limit;
+      cost = left_cardinality + passes * right_cardinality;
+    } else {
+      passes = (right_cardinality + entry_limit - 1) / entry_limit;
+      cost = right_cardinality + passes * left_cardinality;
+    }
+
+    if(cost < best_cost) {
+      best_cost = cost;
+      join.method = JOIN_METHOD_HASH;
+      join.entry_size = entry_size;
+      join.entry_limit = entry_limit;
+      if(build_left) {
+        join.build_rel = handle->left_rel;
+        join.build_attr = handle->left_join_attr;
+        join.build_row = left_row;
+        join.probe_rel = handle->right_rel;
+        join.probe_attr = handle->right_join_attr;
+        join.probe_row = right_row;
+      } else {
+        join.build_rel = handle->right_rel;
+        join.build_attr = handle->right_join_attr;
+        join.build_row = right_row;
+        join.probe_rel = handle->left_rel;
+        join.probe_attr = handle->left_join_attr;
+        join.probe_row = left_row;
+      }
+    }
+  }
+#endif /* DB_JOIN_AREA_SIZE > 0 */
+
+  if(best_cost == ULONG_MAX) {
+    PRINTF("DB: The attribute to join on is not indexed\n");
+    return DB_INDEX_ERROR;
+  }
+
+  PRINTF("DB: Joining %lu and %lu tuples with method %u at an estimated cost of %lu\n",
+         (unsigned long)left_cardinality, (unsigned long)right_cardinality,
+         (unsigned)join.method, best_cost);
+
+  return DB_OK;
+}
+
 db_result_t
 relation_join(void *query_result, void *adt_ptr)
 {
@@ -1120,6 +1479,7 @@ relation_join(void *query_result, void *adt_ptr)
   int i;
   char *attribute_name;
   attribute_t *attr;
+  db_result_t result;
 
   adt = (aql_adt_t *)adt_ptr;
 
@@ -1158,9 +1518,9 @@ relation_join(void *query_result, void *adt_ptr)
     return DB_RELATIONAL_ERROR;
   }
 
-  if(!index_exists(handle->right_join_attr)) {
-    PRINTF("DB: The attribute to join on is not indexed\n");
-    return DB_INDEX_ERROR;
+  result = plan_join(handle);
+  if(DB_ERROR(result)) {
+    return result;
   }
 
   /*
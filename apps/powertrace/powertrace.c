@@ -191,6 +191,31 @@ powertrace_print(char *str)
   seqno++;
 }
 /*---------------------------------------------------------------------------*/
+#if ENERGEST_TRACE
+void
+powertrace_print_trace(char *str)
+{
+  struct energest_trace_entry e;
+  int n;
+
+  /* Tracing stays on while we drain the ring, so that transitions
+     caused by the output are recorded too. Read at most one ring's
+     worth of entries so that the loop ends even if printing adds new
+     ones; the rest are printed the next time. The uptime in the
+     header lets the decoder place the entries even if the rtimer has
+     wrapped more than once since the previous ones. */
+  printf("%s %lu ETH %d.%d %lu %u %lu %lu\n",
+         str, clock_time(), linkaddr_node_addr.u8[0], linkaddr_node_addr.u8[1],
+         (unsigned long)RTIMER_SECOND, (unsigned)(sizeof(rtimer_clock_t) * 8),
+         energest_trace_lost(), clock_seconds());
+  for(n = 0; n < ENERGEST_TRACE_SIZE && energest_trace_read(&e); n++) {
+    printf("%s ET %d.%d %lu %u %u %u\n",
+           str, linkaddr_node_addr.u8[0], linkaddr_node_addr.u8[1],
+           (unsigned long)e.time, e.type, e.on, e.arg);
+  }
+}
+#endif /* ENERGEST_TRACE */
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(powertrace_process, ev, data)
 {
   static struct etimer periodic;
@@ -208,6 +233,9 @@ PROCESS_THREAD(powertrace_process, ev, data)
     PROCESS_WAIT_UNTIL(etimer_expired(&periodic));
     etimer_reset(&periodic);
     powertrace_print("");
+#if ENERGEST_TRACE
+    powertrace_print_trace("");
+#endif /* ENERGEST_TRACE */
   }
 
   PROCESS_END();
@@ -54,4 +54,7 @@ void powertrace_sniff(powertrace_onoff_t onoff);
 
 void powertrace_print(char *str);
 
+/* Drain the energest trace ring (ENERGEST_CONF_TRACE) as text lines */
+void powertrace_print_trace(char *str);
+
 #endif /* POWERTRACE_H */
@@ -39,6 +39,9 @@
 
 #include "contiki.h"
 #include "shell-ps.h"
+#if PROCESS_PROFILE
+#include "sys/rtimer.h"
+#endif /* PROCESS_PROFILE */
 
 #include <stdio.h>
 #include <string.h>
@@ -65,9 +68,58 @@ PROCESS_THREAD(shell_ps_process, ev, data)
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
+#if PROCESS_PROFILE
+PROCESS(shell_pstat_process, "pstat");
+SHELL_COMMAND(pstat_command,
+	      "pstat",
+	      "pstat [reset|binary]: show per-process execution statistics",
+	      &shell_pstat_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(shell_pstat_process, ev, data)
+{
+  static struct process *p;
+  static uint8_t buf[PROCESS_PROFILE_RECORD_SIZE];
+  char line[80];
+  PROCESS_BEGIN();
+
+  if(data != NULL && strcmp(data, "reset") == 0) {
+    process_profile_reset();
+    PROCESS_EXIT();
+  }
+
+  if(data != NULL && strcmp(data, "binary") == 0) {
+    /* One header, then one record per process. */
+    shell_output(&pstat_command, buf, process_profile_header(buf), "", 0);
+    for(p = PROCESS_LIST(); p != NULL; p = p->next) {
+      shell_output(&pstat_command, buf, process_profile_record(p, buf),
+                   "", 0);
+      process_post(&shell_pstat_process, PROCESS_EVENT_CONTINUE, NULL);
+      PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
+    }
+    PROCESS_EXIT();
+  }
+
+  sprintf(line, "%lu rtimer ticks per second",
+           (unsigned long)RTIMER_SECOND);
+  shell_output_str(&pstat_command, "Processes (calls received posted ticks max max-event), ", line);
+  for(p = PROCESS_LIST(); p != NULL; p = p->next) {
+    sprintf(line, ": %lu %lu %lu %lu %lu %u",
+             p->profile.calls, p->profile.received, p->profile.posted,
+             p->profile.ticks, p->profile.max_ticks,
+             (unsigned)p->profile.max_event);
+    shell_output_str(&pstat_command, (char *)PROCESS_NAME_STRING(p), line);
+  }
+
+  PROCESS_END();
+}
+#endif /* PROCESS_PROFILE */
+/*---------------------------------------------------------------------------*/
 void
 shell_ps_init(void)
 {
   shell_register_command(&ps_command);
+#if PROCESS_PROFILE
+  shell_register_command(&pstat_command);
+#endif /* PROCESS_PROFILE */
 }
 /*---------------------------------------------------------------------------*/
@@ -55,6 +55,11 @@
 #endif
 
 #include "contiki-conf.h"
+#include "sys/cc.h"
+#include "sys/clock.h"
+#include "sys/process.h"
+#include "sys/etimer.h"
+#include "lib/hash-index.h"
 #include "cfs/cfs.h"
 #include "cfs-coffee-arch.h"
 #include "cfs/cfs-coffee.h"
@@ -84,6 +89,62 @@
 #define COFFEE_EXTENDED_WEAR_LEVELLING  1
 #endif
 
+/*
+ * Keep an in-RAM index of the file system, built by scanning the file
+ * headers once when Coffee is first used. It maps the name hashes of
+ * active files to their start pages, so that a file is found with a
+ * single header read, and it records the free pages at the end of
+ * each sector, so that free extents are found without reading headers.
+ * COFFEE_NAME_INDEX_SIZE is the number of name slots; files that do
+ * not fit in the index are found by scanning the storage as usual.
+ * Platforms set COFFEE_NAME_INDEX and COFFEE_NAME_INDEX_SIZE in
+ * cfs-coffee-arch.h, from COFFEE_CONF_NAME_INDEX and
+ * COFFEE_CONF_NAME_INDEX_SIZE.
+ */
+#ifndef COFFEE_NAME_INDEX
+#define COFFEE_NAME_INDEX  0
+#endif
+
+#ifndef COFFEE_NAME_INDEX_SIZE
+#define COFFEE_NAME_INDEX_SIZE  32
+#endif
+
+/*
+ * Collect garbage in a background process instead of in the file
+ * operations that remove files. The process erases at most one sector
+ * per step, with COFFEE_GC_INTERVAL clock ticks between the steps,
+ * until COFFEE_GC_WATERMARK sectors are completely free or no more
+ * sectors can be erased. A reservation that finds no free extent still
+ * collects garbage in the foreground. Platforms set COFFEE_GC_PROCESS,
+ * COFFEE_GC_WATERMARK and COFFEE_GC_INTERVAL in cfs-coffee-arch.h,
+ * from the corresponding COFFEE_CONF_ options.
+ */
+#ifndef COFFEE_GC_PROCESS
+#define COFFEE_GC_PROCESS  0
+#endif
+
+#ifndef COFFEE_GC_WATERMARK
+#define COFFEE_GC_WATERMARK  2
+#endif
+
+#ifndef COFFEE_GC_INTERVAL
+#define COFFEE_GC_INTERVAL  (CLOCK_SECOND / 8)
+#endif
+
+/*
+ * Cache COFFEE_PAGE_CACHE_SIZE storage pages in RAM, replacing the
+ * least recently used one. A miss on the page that follows the
+ * previously accessed page also reads the next page ahead. File data
+ * written by cfs_write() outside of the micro logs is kept in the
+ * cache and written back once per page, when the page is evicted or
+ * the file is closed. Headers and log records are written through
+ * immediately to keep their ordering on the storage. Platforms set
+ * the size in cfs-coffee-arch.h.
+ */
+#ifndef COFFEE_PAGE_CACHE_SIZE
+#define COFFEE_PAGE_CACHE_SIZE  0
+#endif
+
 #if COFFEE_START & (COFFEE_SECTOR_SIZE - 1)
 #error COFFEE_START must point to the first byte in a sector.
 #endif
@@ -111,6 +172,8 @@
 #define GC_GREEDY         0
 /* "Reluctant" garbage collection stops after erasing one sector. */
 #define GC_RELUCTANT      1
+/* A garbage collection step of the GC process erases at most one sector. */
+#define GC_STEP           2
 
 /* File descriptor macros. */
 #define FD_VALID(fd)      ((fd) >= 0 && (fd) < COFFEE_FD_SET_SIZE && \
@@ -158,6 +221,8 @@ struct sector_status {
   coffee_page_t active;
   coffee_page_t obsolete;
   coffee_page_t free;
+  /* Pages at the start that belong to an extent in an earlier sector. */
+  coffee_page_t covered;
 };
 
 /* The structure of cached file objects. */
@@ -190,6 +255,27 @@ struct file_header {
   char name[COFFEE_NAME_LENGTH];
 };
 
+#if COFFEE_PAGE_CACHE_SIZE
+/* A cached page. The bytes in [dirty_start, dirty_end) have not been
+   written back to the storage yet. */
+struct cache_page {
+  unsigned long used;
+  coffee_page_t page;
+  uint16_t dirty_start;
+  uint16_t dirty_end;
+  uint8_t valid;
+  uint8_t data[COFFEE_PAGE_SIZE];
+};
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+
+#if COFFEE_NAME_INDEX
+/* A name index slot. Empty slots have the page INVALID_PAGE. */
+struct name_slot {
+  uint16_t hash;
+  coffee_page_t page;
+};
+#endif /* COFFEE_NAME_INDEX */
+
 /* This is needed because of a buggy compiler. */
 struct log_param {
   cfs_offset_t offset;
@@ -205,19 +291,240 @@ static struct file coffee_files[COFFEE_MAX_OPEN_FILES];
 static struct file_desc coffee_fd_set[COFFEE_FD_SET_SIZE];
 static coffee_page_t next_free;
 static char gc_wait;
+static struct cfs_coffee_gc_stats gc_stats;
+static struct cfs_coffee_cache_stats cache_stats;
+
+#if COFFEE_PAGE_CACHE_SIZE
+static struct cache_page cache[COFFEE_PAGE_CACHE_SIZE];
+static unsigned long cache_clock;
+static coffee_page_t last_cached_page = INVALID_PAGE;
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+
+#if COFFEE_GC_PROCESS
+PROCESS(coffee_gc_process, "Coffee GC");
+#endif /* COFFEE_GC_PROCESS */
+
+#if COFFEE_NAME_INDEX
+/*
+ * The name index is an open-addressing hash table with linear probing,
+ * as in lib/hash-index.h. Its slots also hold the name hashes, so that
+ * a removal does not have to read the headers of the files it moves.
+ * Duplicates are allowed, since a file briefly exists twice while its
+ * log is merged. The free page counts mirror what the header scan in
+ * the original find_contiguous_pages() would find: a sector consists
+ * of allocated pages followed by free pages.
+ */
+static struct name_slot name_slots[COFFEE_NAME_INDEX_SIZE];
+static uint16_t name_count;
+static char index_ready;
+static char index_overflow;
+static coffee_page_t sector_free[COFFEE_SECTOR_COUNT];
+#endif /* COFFEE_NAME_INDEX */
+
+/*---------------------------------------------------------------------------*/
+#if COFFEE_PAGE_CACHE_SIZE
+static struct cache_page *
+cache_find(coffee_page_t page)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(cache[i].valid && cache[i].page == page) {
+      return &cache[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_write_back(struct cache_page *cp)
+{
+  if(cp->dirty_end > cp->dirty_start) {
+    COFFEE_WRITE(&cp->data[cp->dirty_start], cp->dirty_end - cp->dirty_start,
+                 (cfs_offset_t)cp->page * COFFEE_PAGE_SIZE + cp->dirty_start);
+    cache_stats.flash_writes++;
+    cp->dirty_start = cp->dirty_end = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct cache_page *
+cache_load(coffee_page_t page, int fill)
+{
+  struct cache_page *cp;
+  int i;
+
+  /* Take a free page or evict the least recently used one. */
+  cp = &cache[0];
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(!cache[i].valid) {
+      cp = &cache[i];
+      break;
+    }
+    if(cache[i].used < cp->used) {
+      cp = &cache[i];
+    }
+  }
+
+  if(cp->valid) {
+    cache_write_back(cp);
+  }
+
+  if(fill) {
+    COFFEE_READ(cp->data, COFFEE_PAGE_SIZE,
+                (cfs_offset_t)page * COFFEE_PAGE_SIZE);
+    cache_stats.flash_reads++;
+  }
+  cp->page = page;
+  cp->valid = 1;
+  cp->dirty_start = cp->dirty_end = 0;
+  cp->used = ++cache_clock;
+  return cp;
+}
+/*---------------------------------------------------------------------------*/
+static struct cache_page *
+cache_get(coffee_page_t page, int fill)
+{
+  struct cache_page *cp;
+
+  cp = cache_find(page);
+  if(cp != NULL) {
+    cache_stats.hits++;
+    cp->used = ++cache_clock;
+  } else {
+    cache_stats.misses++;
+    cp = cache_load(page, fill);
+    if(COFFEE_PAGE_CACHE_SIZE > 1 && fill &&
+       page == last_cached_page + 1 && page + 1 < COFFEE_PAGE_COUNT &&
+       cache_find(page + 1) == NULL) {
+      /* Sequential access: read the next page ahead. */
+      cache_load(page + 1, 1);
+      cache_stats.read_aheads++;
+      cp->used = ++cache_clock;
+    }
+  }
+  last_cached_page = page;
+  return cp;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cache_flush(coffee_page_t start, coffee_page_t pages)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(cache[i].valid && cache[i].page >= start &&
+       cache[i].page < start + pages) {
+      cache_write_back(&cache[i]);
+    }
+  }
+}
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+/*---------------------------------------------------------------------------*/
+static void
+storage_read(void *buf, unsigned size, cfs_offset_t offset)
+{
+#if COFFEE_PAGE_CACHE_SIZE
+  struct cache_page *cp;
+  unsigned start, n;
+
+  while(size > 0) {
+    start = offset % COFFEE_PAGE_SIZE;
+    n = MIN(size, COFFEE_PAGE_SIZE - start);
+    cp = cache_get(offset / COFFEE_PAGE_SIZE, 1);
+    memcpy(buf, &cp->data[start], n);
+    buf = (char *)buf + n;
+    offset += n;
+    size -= n;
+  }
+#else /* COFFEE_PAGE_CACHE_SIZE */
+  COFFEE_READ(buf, size, offset);
+  cache_stats.flash_reads++;
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+}
+/*---------------------------------------------------------------------------*/
+/* Write to the storage, or only to the cache if write_back is set. */
+static void
+storage_write(const void *buf, unsigned size, cfs_offset_t offset,
+              int write_back)
+{
+#if COFFEE_PAGE_CACHE_SIZE
+  struct cache_page *cp;
+  unsigned start, n;
+
+  while(size > 0) {
+    start = offset % COFFEE_PAGE_SIZE;
+    n = MIN(size, COFFEE_PAGE_SIZE - start);
+    cp = cache_find(offset / COFFEE_PAGE_SIZE);
+    if(write_back) {
+      /* A page that is overwritten completely need not be read. */
+      cp = cache_get(offset / COFFEE_PAGE_SIZE, n < COFFEE_PAGE_SIZE);
+      if(cp->dirty_end == cp->dirty_start) {
+        cp->dirty_start = start;
+        cp->dirty_end = start + n;
+      } else {
+        cp->dirty_start = MIN(cp->dirty_start, start);
+        cp->dirty_end = MAX(cp->dirty_end, start + n);
+      }
+      cache_stats.writes_buffered++;
+    } else {
+      COFFEE_WRITE(buf, n, offset);
+      cache_stats.flash_writes++;
+    }
+    if(cp != NULL) {
+      memcpy(&cp->data[start], buf, n);
+    }
+    buf = (const char *)buf + n;
+    offset += n;
+    size -= n;
+  }
+#else /* COFFEE_PAGE_CACHE_SIZE */
+  COFFEE_WRITE(buf, size, offset);
+  cache_stats.flash_writes++;
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+}
+/*---------------------------------------------------------------------------*/
+static void
+storage_erase(coffee_page_t sector)
+{
+#if COFFEE_PAGE_CACHE_SIZE
+  int i;
 
+  /* Drop the cached pages, including data that was not written back. */
+  for(i = 0; i < COFFEE_PAGE_CACHE_SIZE; i++) {
+    if(cache[i].valid &&
+       cache[i].page / COFFEE_PAGES_PER_SECTOR == sector) {
+      cache[i].valid = 0;
+    }
+  }
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+  COFFEE_ERASE(sector);
+}
 /*---------------------------------------------------------------------------*/
 static void
 write_header(struct file_header *hdr, coffee_page_t page)
 {
   hdr->flags |= HDR_FLAG_VALID;
-  COFFEE_WRITE(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+  storage_write(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE, 0);
 }
 /*---------------------------------------------------------------------------*/
 static void
 read_header(struct file_header *hdr, coffee_page_t page)
 {
-  COFFEE_READ(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+#if COFFEE_PAGE_CACHE_SIZE
+  struct cache_page *cp;
+
+  /* Headers are read from the cache if their page is there, but they
+     do not load pages, since file scans would flush the cache. */
+  cp = cache_find(page);
+  if(cp != NULL) {
+    memcpy(hdr, cp->data, sizeof(*hdr));
+    cache_stats.hits++;
+  } else
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+  {
+    COFFEE_READ(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+    cache_stats.flash_reads++;
+  }
   if(DEBUG && HDR_ACTIVE(*hdr) && !HDR_VALID(*hdr)) {
     PRINTF("Coffee: Invalid header at page %u!\n", (unsigned)page);
   }
@@ -229,6 +536,87 @@ absolute_offset(coffee_page_t page, cfs_offset_t offset)
   return page * COFFEE_PAGE_SIZE + sizeof(struct file_header) + offset;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_NAME_INDEX
+static uint16_t
+name_hash(const char *name)
+{
+  uint32_t h;
+
+  h = hash_index_fnv1a(HASH_INDEX_FNV1A_INIT, name, strlen(name));
+  return (uint16_t)(h ^ (h >> 16));
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_add(const char *name, coffee_page_t page)
+{
+  unsigned slot;
+  uint16_t hash;
+
+  /* Keep one slot empty so that every probe sequence ends. */
+  if(name_count >= COFFEE_NAME_INDEX_SIZE - 1) {
+    index_overflow = 1;
+    return;
+  }
+
+  hash = name_hash(name);
+  slot = hash % COFFEE_NAME_INDEX_SIZE;
+  while(name_slots[slot].page != INVALID_PAGE) {
+    slot = (slot + 1) % COFFEE_NAME_INDEX_SIZE;
+  }
+  name_slots[slot].hash = hash;
+  name_slots[slot].page = page;
+  name_count++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_remove(const char *name, coffee_page_t page)
+{
+  unsigned slot, next, home;
+
+  slot = name_hash(name) % COFFEE_NAME_INDEX_SIZE;
+  while(name_slots[slot].page != page) {
+    if(name_slots[slot].page == INVALID_PAGE) {
+      /* The file did not fit in the index. */
+      return;
+    }
+    slot = (slot + 1) % COFFEE_NAME_INDEX_SIZE;
+  }
+
+  /* Backward-shift deletion: move later entries of the probe sequence
+     into the hole, so that no tombstones are needed. */
+  name_slots[slot].page = INVALID_PAGE;
+  name_count--;
+  next = slot;
+  while(1) {
+    next = (next + 1) % COFFEE_NAME_INDEX_SIZE;
+    if(name_slots[next].page == INVALID_PAGE) {
+      break;
+    }
+    home = name_slots[next].hash % COFFEE_NAME_INDEX_SIZE;
+    if(hash_index_can_fill(slot, next, home)) {
+      name_slots[slot] = name_slots[next];
+      name_slots[next].page = INVALID_PAGE;
+      slot = next;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_allocate(coffee_page_t start, coffee_page_t pages)
+{
+  coffee_page_t sector, end, sector_end;
+
+  end = start + pages;
+  for(sector = start / COFFEE_PAGES_PER_SECTOR;
+      sector < COFFEE_SECTOR_COUNT &&
+      sector * COFFEE_PAGES_PER_SECTOR < end;
+      sector++) {
+    sector_end = (sector + 1) * COFFEE_PAGES_PER_SECTOR;
+    sector_free[sector] = end < sector_end ? sector_end - end : 0;
+  }
+}
+#endif /* COFFEE_NAME_INDEX */
+/*---------------------------------------------------------------------------*/
 static coffee_page_t
 get_sector_status(coffee_page_t sector, struct sector_status *stats)
 {
@@ -251,6 +639,7 @@ get_sector_status(coffee_page_t sector, struct sector_status *stats)
     skip_pages = 0;
     last_pages_are_active = 0;
   }
+  stats->covered = skip_pages;
 
   sector_start = sector * COFFEE_PAGES_PER_SECTOR;
   sector_end = sector_start + COFFEE_PAGES_PER_SECTOR;
@@ -348,21 +737,64 @@ isolate_pages(coffee_page_t start, coffee_page_t skip_pages)
          (unsigned)skip_pages, (int)start / COFFEE_PAGES_PER_SECTOR);
 }
 /*---------------------------------------------------------------------------*/
-static void
+#if COFFEE_NAME_INDEX
+static void index_recount(coffee_page_t sector);
+#endif /* COFFEE_NAME_INDEX */
+/*---------------------------------------------------------------------------*/
+static int
 collect_garbage(int mode)
 {
   coffee_page_t sector;
   struct sector_status stats;
   coffee_page_t first_page, isolation_count;
+  clock_time_t start, stall;
+  int erased;
+#if COFFEE_NAME_INDEX
+  coffee_page_t covered;
+  char extent_erased, last_erased, last_covered, recount;
+#endif /* COFFEE_NAME_INDEX */
 
   PRINTF("Coffee: Running the garbage collector in %s mode\n",
-         mode == GC_RELUCTANT ? "reluctant" : "greedy");
+         mode == GC_RELUCTANT ? "reluctant" :
+         mode == GC_STEP ? "step" : "greedy");
+
+  start = clock_time();
+  erased = 0;
+#if COFFEE_NAME_INDEX
+  extent_erased = last_erased = last_covered = recount = 0;
+#endif /* COFFEE_NAME_INDEX */
   /*
    * The garbage collector erases as many sectors as possible. A sector is
    * erasable if there are only free or obsolete pages in it.
    */
   for(sector = 0; sector < COFFEE_SECTOR_COUNT; sector++) {
     isolation_count = get_sector_status(sector, &stats);
+#if COFFEE_NAME_INDEX
+    /* Track whether the extent that covers the start of this sector
+       begins in a sector erased in this pass. The header scan then no
+       longer skips the covered pages. */
+    if(!last_covered) {
+      extent_erased = last_erased;
+    }
+    last_covered = stats.covered >= COFFEE_PAGES_PER_SECTOR;
+    last_erased = 0;
+
+    /* The header scan now enters this sector at its first page. If an
+       extent from the erased sector covers all of it, it is erased too. */
+    if(recount && !last_covered) {
+      index_recount(sector);
+    }
+    recount = 0;
+#endif /* COFFEE_NAME_INDEX */
+
+    /* A step ends after one erased sector, unless an extent from that
+       sector covers all of this one. Its first page then holds no
+       header, so it must be erased as well. */
+    if(mode == GC_STEP && erased > 0 &&
+       stats.covered < COFFEE_PAGES_PER_SECTOR) {
+      break;
+    }
+
     PRINTF("Coffee: Sector %u has %u active, %u obsolete, and %u free pages.\n",
            (unsigned)sector, (unsigned)stats.active,
            (unsigned)stats.obsolete, (unsigned)stats.free);
@@ -372,7 +804,7 @@ collect_garbage(int mode)
     }
 
     if((mode == GC_RELUCTANT && stats.free == 0) ||
-       (mode == GC_GREEDY && stats.obsolete > 0)) {
+       (mode != GC_RELUCTANT && stats.obsolete > 0)) {
       first_page = sector * COFFEE_PAGES_PER_SECTOR;
       if(first_page < next_free) {
         next_free = first_page;
@@ -382,15 +814,100 @@ collect_garbage(int mode)
         isolate_pages(first_page + COFFEE_PAGES_PER_SECTOR, isolation_count);
       }
 
-      COFFEE_ERASE(sector);
+      storage_erase(sector);
       PRINTF("Coffee: Erased sector %d!\n", sector);
+#if COFFEE_NAME_INDEX
+      /* An obsolete extent from an earlier sector may still cover the
+         start of the erased sector. If it covers all of it, the header
+         scan finds no free pages there, as before. */
+      last_erased = 1;
+      covered = extent_erased ? 0 : stats.covered;
+      if(index_ready && covered < COFFEE_PAGES_PER_SECTOR) {
+        sector_free[sector] = COFFEE_PAGES_PER_SECTOR - covered;
+        recount = 1;
+      }
+#endif /* COFFEE_NAME_INDEX */
+      erased++;
+      gc_stats.sectors_erased++;
+      gc_stats.pages_reclaimed += stats.obsolete;
 
       if(mode == GC_RELUCTANT && isolation_count > 0) {
         break;
       }
     }
   }
+
+#if COFFEE_NAME_INDEX
+  if(recount && sector + 1 < COFFEE_SECTOR_COUNT) {
+    index_recount(sector + 1);
+  }
+#endif /* COFFEE_NAME_INDEX */
+
+  if(mode == GC_STEP) {
+    gc_stats.background_steps++;
+  } else {
+    stall = clock_time() - start;
+    gc_stats.foreground_runs++;
+    gc_stats.stall_time += stall;
+    if(stall > gc_stats.max_stall_time) {
+      gc_stats.max_stall_time = stall;
+    }
+  }
+
+  return erased;
+}
+/*---------------------------------------------------------------------------*/
+#if COFFEE_GC_PROCESS
+static coffee_page_t
+free_sectors(void)
+{
+  coffee_page_t sector, count;
+  struct sector_status stats;
+
+  count = 0;
+  for(sector = 0; sector < COFFEE_SECTOR_COUNT; sector++) {
+#if COFFEE_NAME_INDEX
+    if(index_ready) {
+      count += sector_free[sector] == COFFEE_PAGES_PER_SECTOR;
+      continue;
+    }
+#endif /* COFFEE_NAME_INDEX */
+    get_sector_status(sector, &stats);
+    count += stats.free == COFFEE_PAGES_PER_SECTOR;
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+poll_gc(void)
+{
+  if(!process_is_running(&coffee_gc_process)) {
+    process_start(&coffee_gc_process, NULL);
+  }
+  process_poll(&coffee_gc_process);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coffee_gc_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    /* Files have been removed or space has been reserved. */
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    while(free_sectors() < COFFEE_GC_WATERMARK &&
+          collect_garbage(GC_STEP) > 0) {
+      gc_wait = 0;
+      etimer_set(&et, COFFEE_GC_INTERVAL);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    }
+  }
+
+  PROCESS_END();
 }
+#endif /* COFFEE_GC_PROCESS */
 /*---------------------------------------------------------------------------*/
 static coffee_page_t
 next_file(coffee_page_t page, struct file_header *hdr)
@@ -413,6 +930,87 @@ next_file(coffee_page_t page, struct file_header *hdr)
   return page + hdr->max_pages;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_NAME_INDEX
+/*
+ * Count the free pages of a sector again, the way the header scan in
+ * build_index() sees them when it enters the sector at its first page.
+ * This is the case for the sector after an erased one, where isolated
+ * pages may now precede the first file.
+ */
+static void
+index_recount(coffee_page_t sector)
+{
+  struct file_header hdr;
+  coffee_page_t page, end;
+
+  page = sector * COFFEE_PAGES_PER_SECTOR;
+  end = page + COFFEE_PAGES_PER_SECTOR;
+  sector_free[sector] = 0;
+
+  for(; page < end; page = next_file(page, &hdr)) {
+    read_header(&hdr, page);
+    if(HDR_FREE(hdr)) {
+      sector_free[sector] = end - page;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+build_index(void)
+{
+  struct file_header hdr;
+  coffee_page_t page;
+  unsigned slot;
+
+  if(index_ready) {
+    return;
+  }
+
+  for(slot = 0; slot < COFFEE_NAME_INDEX_SIZE; slot++) {
+    name_slots[slot].page = INVALID_PAGE;
+  }
+  name_count = 0;
+  index_overflow = 0;
+  memset(sector_free, 0, sizeof(sector_free));
+
+  for(page = 0; page < COFFEE_PAGE_COUNT; page = next_file(page, &hdr)) {
+    read_header(&hdr, page);
+    if(HDR_FREE(hdr)) {
+      sector_free[page / COFFEE_PAGES_PER_SECTOR] =
+        COFFEE_PAGES_PER_SECTOR - page % COFFEE_PAGES_PER_SECTOR;
+    } else if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
+      index_add(hdr.name, page);
+    }
+  }
+
+  index_ready = 1;
+  PRINTF("Coffee: Indexed %u files%s\n", (unsigned)name_count,
+         index_overflow ? " (index full)" : "");
+}
+/*---------------------------------------------------------------------------*/
+static coffee_page_t
+index_lookup(const char *name, struct file_header *hdr)
+{
+  unsigned slot;
+  uint16_t hash;
+
+  build_index();
+
+  hash = name_hash(name);
+  for(slot = hash % COFFEE_NAME_INDEX_SIZE;
+      name_slots[slot].page != INVALID_PAGE;
+      slot = (slot + 1) % COFFEE_NAME_INDEX_SIZE) {
+    if(name_slots[slot].hash == hash) {
+      read_header(hdr, name_slots[slot].page);
+      if(HDR_ACTIVE(*hdr) && !HDR_LOG(*hdr) && strcmp(name, hdr->name) == 0) {
+        return name_slots[slot].page;
+      }
+    }
+  }
+  return INVALID_PAGE;
+}
+#endif /* COFFEE_NAME_INDEX */
+/*---------------------------------------------------------------------------*/
 static struct file *
 load_file(coffee_page_t start, struct file_header *hdr)
 {
@@ -459,6 +1057,22 @@ find_file(const char *name)
   struct file_header hdr;
   coffee_page_t page;
 
+#if COFFEE_NAME_INDEX
+  page = index_lookup(name, &hdr);
+  if(page != INVALID_PAGE) {
+    for(i = 0; i < COFFEE_MAX_OPEN_FILES; i++) {
+      if(!FILE_FREE(&coffee_files[i]) && coffee_files[i].page == page) {
+        return &coffee_files[i];
+      }
+    }
+    return load_file(page, &hdr);
+  }
+
+  if(!index_overflow) {
+    return NULL;
+  }
+#endif /* COFFEE_NAME_INDEX */
+
   /* First check if the file metadata is cached. */
   for(i = 0; i < COFFEE_MAX_OPEN_FILES; i++) {
     if(FILE_FREE(&coffee_files[i])) {
@@ -500,8 +1114,15 @@ file_end(coffee_page_t start)
    * are zeroes, then these are skipped from the calculation.
    */
 
+#if COFFEE_PAGE_CACHE_SIZE
+  /* Scan the storage directly, so that a backward scan through a large
+     extent does not evict the cached pages. */
+  cache_flush(start, hdr.max_pages);
+#endif /* COFFEE_PAGE_CACHE_SIZE */
+
   for(page = hdr.max_pages - 1; page >= 0; page--) {
     COFFEE_READ(buf, sizeof(buf), (start + page) * COFFEE_PAGE_SIZE);
+    cache_stats.flash_reads++;
     for(i = COFFEE_PAGE_SIZE - 1; i >= 0; i--) {
       if(buf[i] != 0) {
         if(page == 0 && i < sizeof(hdr)) {
@@ -520,6 +1141,38 @@ static coffee_page_t
 find_contiguous_pages(coffee_page_t amount)
 {
   coffee_page_t page, start;
+#if COFFEE_NAME_INDEX
+  coffee_page_t sector;
+
+  build_index();
+
+  /* A free extent starts with the free pages at the end of a sector
+     and continues through the following completely free sectors. */
+  for(sector = 0; sector < COFFEE_SECTOR_COUNT; sector++) {
+    if(sector_free[sector] == 0) {
+      continue;
+    }
+    page = (sector + 1) * COFFEE_PAGES_PER_SECTOR;
+    start = page - sector_free[sector];
+    if(start + amount >= COFFEE_PAGE_COUNT) {
+      break;
+    }
+    while(start + amount > page &&
+          sector_free[page / COFFEE_PAGES_PER_SECTOR] ==
+          COFFEE_PAGES_PER_SECTOR) {
+      page += COFFEE_PAGES_PER_SECTOR;
+    }
+    if(start + amount <= page) {
+      if(start == next_free) {
+        next_free = start + amount;
+      }
+      return start;
+    }
+    /* Continue with the sector that ended the extent. */
+    sector = page / COFFEE_PAGES_PER_SECTOR - 1;
+  }
+  return INVALID_PAGE;
+#else /* COFFEE_NAME_INDEX */
   struct file_header hdr;
 
   start = INVALID_PAGE;
@@ -550,6 +1203,7 @@ find_contiguous_pages(coffee_page_t amount)
     }
   }
   return INVALID_PAGE;
+#endif /* COFFEE_NAME_INDEX */
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -573,6 +1227,16 @@ remove_by_page(coffee_page_t page, int remove_log,
   hdr.flags |= HDR_FLAG_OBSOLETE;
   write_header(&hdr, page);
 
+#if COFFEE_NAME_INDEX
+  if(index_ready && !HDR_LOG(hdr)) {
+    index_remove(hdr.name, page);
+    if(index_overflow && name_count < COFFEE_NAME_INDEX_SIZE / 2) {
+      /* Rebuild the full index to pick up the files that did not fit. */
+      index_ready = 0;
+    }
+  }
+#endif /* COFFEE_NAME_INDEX */
+
   gc_wait = 0;
 
   /* Close all file descriptors that reference the removed file. */
@@ -592,9 +1256,13 @@ remove_by_page(coffee_page_t page, int remove_log,
     }
   }
 
+#if COFFEE_GC_PROCESS
+  poll_gc();
+#else /* COFFEE_GC_PROCESS */
   if(!COFFEE_EXTENDED_WEAR_LEVELLING && gc_allowed) {
     collect_garbage(GC_RELUCTANT);
   }
+#endif /* COFFEE_GC_PROCESS */
 
   return 0;
 }
@@ -637,9 +1305,21 @@ reserve(const char *name, coffee_page_t pages,
   hdr.flags = HDR_FLAG_ALLOCATED | flags;
   write_header(&hdr, page);
 
+#if COFFEE_NAME_INDEX
+  index_allocate(page, pages);
+  if(!HDR_LOG(hdr)) {
+    index_add(hdr.name, page);
+  }
+#endif /* COFFEE_NAME_INDEX */
+
   PRINTF("Coffee: Reserved %u pages starting from %u for file %s\n",
          (unsigned)pages, (unsigned)page, name);
 
+#if COFFEE_GC_PROCESS
+  /* Make room for the next reservations while the storage is idle. */
+  poll_gc();
+#endif /* COFFEE_GC_PROCESS */
+
   file = load_file(page, &hdr);
   if(file != NULL) {
     file->end = 0;
@@ -703,7 +1383,7 @@ get_record_index(coffee_page_t log_page, uint16_t search_records,
       }
 
       base -= batch_size * sizeof(indices[0]);
-      COFFEE_READ(&indices, sizeof(indices[0]) * batch_size, base);
+      storage_read(&indices, sizeof(indices[0]) * batch_size, base);
 
       for(i = batch_size - 1; i >= 0; i--) {
         if(indices[i] - 1 == region) {
@@ -744,7 +1424,7 @@ read_log_page(struct file_header *hdr, int16_t record_count,
   base = absolute_offset(hdr->log_page, log_records * sizeof(region));
   base += (cfs_offset_t)match_index * log_record_size;
   base += lp->offset;
-  COFFEE_READ(lp->buf, lp->size, base);
+  storage_read(lp->buf, lp->size, base);
 
   return lp->size;
 }
@@ -814,7 +1494,7 @@ merge_log(coffee_page_t file_page, int extend)
       cfs_close(fd);
       return -1;
     } else if(n > 0) {
-      COFFEE_WRITE(buf, n, absolute_offset(new_file->page, offset));
+      storage_write(buf, n, absolute_offset(new_file->page, offset), 0);
       offset += n;
     }
   } while(n != 0);
@@ -871,8 +1551,8 @@ find_next_record(struct file *file, coffee_page_t log_page,
       batch_size = log_records - processed >= preferred_batch_size ?
         preferred_batch_size : log_records - processed;
 
-      COFFEE_READ(&indices, batch_size * sizeof(indices[0]),
-                  absolute_offset(log_page, processed * sizeof(indices[0])));
+      storage_read(&indices, batch_size * sizeof(indices[0]),
+                   absolute_offset(log_page, processed * sizeof(indices[0])));
       for(log_record = 0; log_record < batch_size; log_record++) {
         if(indices[log_record] == 0) {
           log_record += processed;
@@ -935,8 +1615,8 @@ write_log_page(struct file *file, struct log_param *lp)
 
     if((lp->offset > 0 || lp->size != log_record_size) &&
        read_log_page(&hdr, log_record, &lp_out) < 0) {
-      COFFEE_READ(copy_buf, sizeof(copy_buf),
-                  absolute_offset(file->page, offset));
+      storage_read(copy_buf, sizeof(copy_buf),
+                   absolute_offset(file->page, offset));
     }
 
     memcpy(&copy_buf[lp->offset], lp->buf, lp->size);
@@ -947,12 +1627,12 @@ write_log_page(struct file *file, struct log_param *lp)
      */
     offset = absolute_offset(log_page, 0);
     ++region;
-    COFFEE_WRITE(&region, sizeof(region),
-                 offset + log_record * sizeof(region));
+    storage_write(&region, sizeof(region),
+                  offset + log_record * sizeof(region), 0);
 
     offset += log_records * sizeof(region);
-    COFFEE_WRITE(copy_buf, sizeof(copy_buf),
-                 offset + log_record * log_record_size);
+    storage_write(copy_buf, sizeof(copy_buf),
+                  offset + log_record * log_record_size, 0);
     file->record_count = log_record + 1;
   }
 
@@ -1014,6 +1694,10 @@ void
 cfs_close(int fd)
 {
   if(FD_VALID(fd)) {
+#if COFFEE_PAGE_CACHE_SIZE
+    cache_flush(coffee_fd_set[fd].file->page,
+                coffee_fd_set[fd].file->max_pages);
+#endif /* COFFEE_PAGE_CACHE_SIZE */
     coffee_fd_set[fd].flags = COFFEE_FD_FREE;
     coffee_fd_set[fd].file->references--;
     coffee_fd_set[fd].file = NULL;
@@ -1105,7 +1789,7 @@ cfs_read(int fd, void *buf, unsigned size)
 
   /* If the file is not modified, read directly from the file extent. */
   if(!FILE_MODIFIED(file)) {
-    COFFEE_READ(buf, size, absolute_offset(file->page, fdp->offset));
+    storage_read(buf, size, absolute_offset(file->page, fdp->offset));
     fdp->offset += size;
     return size;
   }
@@ -1126,7 +1810,7 @@ cfs_read(int fd, void *buf, unsigned size)
 
     /* Read from the original file if we cannot find the data in the log. */
     if(r < 0) {
-      COFFEE_READ(buf, lp.size, absolute_offset(file->page, fdp->offset));
+      storage_read(buf, lp.size, absolute_offset(file->page, fdp->offset));
       r = lp.size;
     }
     fdp->offset += r;
@@ -1209,7 +1893,8 @@ cfs_write(int fd, const void *buf, unsigned size)
        * corresponding end offset in the original extent to ensure that
        * the correct file size is calculated when opening the file again.
        */
-      COFFEE_WRITE(dummy, 1, absolute_offset(file->page, fdp->offset - 1));
+      storage_write(dummy, 1,
+                    absolute_offset(file->page, fdp->offset - 1), 0);
     }
   } else {
 #endif /* COFFEE_MICRO_LOGS */
@@ -1217,7 +1902,7 @@ cfs_write(int fd, const void *buf, unsigned size)
       return -1;
     }
 
-    COFFEE_WRITE(buf, size, absolute_offset(file->page, fdp->offset));
+    storage_write(buf, size, absolute_offset(file->page, fdp->offset), 1);
     fdp->offset += size;
 #if COFFEE_MICRO_LOGS
   }
@@ -1253,7 +1938,9 @@ cfs_readdir(struct cfs_dir *dir, struct cfs_dirent *record)
   while(page < COFFEE_PAGE_COUNT) {
     read_header(&hdr, page);
     if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
-      memcpy(record->name, hdr.name, sizeof(record->name));
+      memset(record->name, 0, sizeof(record->name));
+      memcpy(record->name, hdr.name,
+             MIN(sizeof(record->name), sizeof(hdr.name)));
       record->name[sizeof(record->name) - 1] = '\0';
       record->size = file_end(page);
 
@@ -1321,6 +2008,18 @@ cfs_coffee_set_io_semantics(int fd, unsigned flags)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+void
+cfs_coffee_get_gc_stats(struct cfs_coffee_gc_stats *stats)
+{
+  memcpy(stats, &gc_stats, sizeof(*stats));
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_coffee_get_cache_stats(struct cfs_coffee_cache_stats *stats)
+{
+  memcpy(stats, &cache_stats, sizeof(*stats));
+}
+/*---------------------------------------------------------------------------*/
 int
 cfs_coffee_format(void)
 {
@@ -1329,7 +2028,7 @@ cfs_coffee_format(void)
   PRINTF("Coffee: Formatting %u sectors", (unsigned)COFFEE_SECTOR_COUNT);
 
   for(i = 0; i < COFFEE_SECTOR_COUNT; i++) {
-    COFFEE_ERASE(i);
+    storage_erase(i);
     PRINTF(".");
   }
 
@@ -1338,6 +2037,9 @@ cfs_coffee_format(void)
   memset(&coffee_fd_set, 0, sizeof(coffee_fd_set));
   next_free = 0;
   gc_wait = 1;
+#if COFFEE_NAME_INDEX
+  index_ready = 0;
+#endif /* COFFEE_NAME_INDEX */
 
   PRINTF(" done!\n");
 
@@ -140,6 +140,62 @@ int cfs_coffee_set_io_semantics(int fd, unsigned flags);
  */
 int cfs_coffee_format(void);
 
+/**
+ * Garbage collection statistics.
+ *
+ * Foreground garbage collection runs in the file operation that needs
+ * the space, or that removes a file, and delays it. The stall times
+ * are in clock ticks.
+ *
+ * \sa cfs_coffee_get_gc_stats()
+ */
+struct cfs_coffee_gc_stats {
+  unsigned long sectors_erased;
+  unsigned long pages_reclaimed;
+  unsigned long foreground_runs;
+  unsigned long stall_time;
+  unsigned long max_stall_time;
+  unsigned long background_steps;
+};
+
+/**
+ * \brief Get the garbage collection statistics.
+ * \param stats A pointer to a structure that is filled in.
+ *
+ * The statistics count from system start. When COFFEE_CONF_GC_PROCESS is
+ * set, garbage is collected by a background process in steps of at
+ * most one sector erasure, and the foreground runs only happen when a
+ * reservation finds no free space.
+ */
+void cfs_coffee_get_gc_stats(struct cfs_coffee_gc_stats *stats);
+
+/**
+ * Page cache statistics.
+ *
+ * The flash reads and writes count the operations on the underlying
+ * storage, also when the page cache is disabled.
+ *
+ * \sa cfs_coffee_get_cache_stats()
+ */
+struct cfs_coffee_cache_stats {
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long read_aheads;
+  unsigned long writes_buffered;
+  unsigned long flash_reads;
+  unsigned long flash_writes;
+};
+
+/**
+ * \brief Get the page cache statistics.
+ * \param stats A pointer to a structure that is filled in.
+ *
+ * With COFFEE_CONF_PAGE_CACHE_SIZE set, Coffee caches storage pages in
+ * RAM. File data written outside of the micro logs stays in the cache
+ * until the page is evicted or the file is closed with cfs_close().
+ */
+void cfs_coffee_get_cache_stats(struct cfs_coffee_cache_stats *stats);
+
 /** @} */
 /** @} */
 
@@ -30,7 +30,7 @@
  *
  */
 #include "dev/serial-line.h"
-#include <string.h> /* for memcpy() */
+#include <string.h> /* for memchr(), memmove() */
 
 #include "lib/ringbuf.h"
 
@@ -50,6 +50,7 @@
 
 static struct ringbuf rxbuf;
 static uint8_t rxbuf_data[BUFSIZE];
+static uint8_t overflow; /* Buffer overflow: ignore until END */
 
 PROCESS(serial_line_process, "Serial driver");
 
@@ -59,8 +60,6 @@ process_event_t serial_line_event_message;
 int
 serial_line_input_byte(unsigned char c)
 {
-  static uint8_t overflow = 0; /* Buffer overflow: ignore until END */
-  
   if(IGNORE_CHAR(c)) {
     return 0;
   }
@@ -84,45 +83,106 @@ serial_line_input_byte(unsigned char c)
   return 1;
 }
 /*---------------------------------------------------------------------------*/
+int
+serial_line_input_bytes(const unsigned char *data, int len)
+{
+  int i, n, put, added;
+
+  added = 0;
+  i = 0;
+  while(i < len) {
+    if(IGNORE_CHAR(data[i])) {
+      i++;
+    } else if(overflow) {
+      /* Only (try to) add terminator characters, otherwise skip */
+      if(data[i] == END && ringbuf_put(&rxbuf, END) != 0) {
+        overflow = 0;
+      }
+      added = 1;
+      i++;
+    } else {
+      /* Add the run of characters up to the next ignored one in one
+         go. If it does not fit, the character that did not fit and
+         the rest of the line are dropped. */
+      for(n = i; n < len && !IGNORE_CHAR(data[n]); n++);
+      put = ringbuf_put_bulk(&rxbuf, &data[i], n - i);
+      if(put < n - i) {
+        overflow = 1;
+        put++;
+      }
+      added = 1;
+      i += put;
+    }
+  }
+
+  if(added) {
+    /* Wake up consumer process */
+    process_poll(&serial_line_process);
+  }
+  return added;
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(serial_line_process, ev, data)
 {
   static char buf[BUFSIZE];
-  static int ptr;
+  static int ptr, scanned, line_len;
+  char *end;
+  int len;
 
   PROCESS_BEGIN();
 
   serial_line_event_message = process_alloc_event();
-  ptr = 0;
+  ptr = scanned = 0;
 
   while(1) {
-    /* Fill application buffer until newline or empty */
-    int c = ringbuf_get(&rxbuf);
-    
-    if(c == -1) {
-      /* Buffer empty, wait for poll */
-      PROCESS_YIELD();
-    } else {
-      if(c != END) {
-        if(ptr < BUFSIZE-1) {
-          buf[ptr++] = (uint8_t)c;
-        } else {
-          /* Ignore character (wait for EOL) */
-        }
+    /* Look for the end of the line among the new characters. */
+    end = memchr(&buf[scanned], END, ptr - scanned);
+    scanned = ptr;
+
+    if(end == NULL) {
+      if(ptr < BUFSIZE - 1) {
+        /* Fill application buffer with whatever is available */
+        len = ringbuf_get_bulk(&rxbuf, (uint8_t *)&buf[ptr],
+                               BUFSIZE - 1 - ptr);
+        ptr += len;
       } else {
-        /* Terminate */
-        buf[ptr++] = (uint8_t)'\0';
-
-        /* Broadcast event */
-        process_post(PROCESS_BROADCAST, serial_line_event_message, buf);
-
-        /* Wait until all processes have handled the serial line event */
-        if(PROCESS_ERR_OK ==
-          process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL)) {
-          PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
+        /* Line too long: ignore characters until EOL, using the
+           last byte of the buffer as scratch space */
+        len = ringbuf_get_bulk(&rxbuf, (uint8_t *)&buf[BUFSIZE - 1], 1);
+        if(len > 0 && buf[BUFSIZE - 1] == END) {
+          end = &buf[BUFSIZE - 1];
         }
-        ptr = 0;
       }
+      if(end == NULL) {
+        if(len == 0) {
+          /* Buffer empty, wait for poll */
+          PROCESS_YIELD();
+        }
+        continue;
+      }
+    }
+
+    /* Terminate */
+    *end = '\0';
+    line_len = end - buf + 1;
+
+    /* Broadcast event */
+    process_post(PROCESS_BROADCAST, serial_line_event_message, buf);
+
+    /* Wait until all processes have handled the serial line event */
+    if(PROCESS_ERR_OK ==
+      process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL)) {
+      PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
+    }
+
+    /* Keep the characters that followed the end of the line. */
+    if(line_len < ptr) {
+      ptr -= line_len;
+      memmove(buf, &buf[line_len], ptr);
+    } else {
+      ptr = 0;
     }
+    scanned = 0;
   }
 
   PROCESS_END();
@@ -69,6 +69,21 @@ extern process_event_t serial_line_event_message;
 
 int serial_line_input_byte(unsigned char c);
 
+/**
+ * Get a number of bytes of input from the serial driver.
+ *
+ * This function does the same as calling serial_line_input_byte()
+ * for each byte, but copies runs of bytes into the input buffer in
+ * one go. It is meant for drivers that receive data in batches, such
+ * as from a UART FIFO or DMA buffer.
+ *
+ * \param data The data that is received.
+ * \param len The number of bytes received.
+ *
+ * \return Non-zero if the CPU should be powered up, zero otherwise.
+ */
+int serial_line_input_bytes(const unsigned char *data, int len);
+
 void serial_line_init(void);
 
 PROCESS_NAME(serial_line_process);
@@ -457,3 +457,39 @@ slip_input_byte(unsigned char c)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+int
+slip_input_bytes(const unsigned char *data, int len)
+{
+  int i, n, room, wake;
+
+  wake = 0;
+  i = 0;
+  while(i < len) {
+#ifndef SLIP_CONF_MICROSOFT_CHAT
+    if(state == STATE_OK) {
+      /* Bytes that are neither SLIP_END nor SLIP_ESC need no
+         processing, so copy as many of them as fit before the end of
+         rxbuf or the start of the buffered packets. */
+      if(next_free >= begin) {
+        room = RX_BUFSIZE - next_free - (begin == 0);
+      } else {
+        room = begin - next_free - 1;
+      }
+      for(n = 0; n < room && i + n < len &&
+            data[i + n] != SLIP_END && data[i + n] != SLIP_ESC; n++);
+      if(n > 0) {
+        memcpy(&rxbuf[next_free], &data[i], n);
+        CC_MEMORY_BARRIER();
+        next_free = next_free + n == RX_BUFSIZE ? 0 : next_free + n;
+        i += n;
+        continue;
+      }
+    }
+#endif /* SLIP_CONF_MICROSOFT_CHAT */
+    /* Special bytes, escape sequences and overflow are handled one
+       byte at a time. */
+    wake |= slip_input_byte(data[i++]);
+  }
+  return wake;
+}
+/*---------------------------------------------------------------------------*/
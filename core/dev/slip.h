@@ -62,6 +62,22 @@ uint8_t slip_send(void);
  */
 int slip_input_byte(unsigned char c);
 
+/**
+ * Input a number of SLIP bytes.
+ *
+ * This function does the same as calling slip_input_byte() for each
+ * byte, but copies runs of ordinary bytes into the receive buffer
+ * with memcpy(). It is meant for drivers that receive data in
+ * batches, such as from a UART FIFO or DMA buffer, and can be called
+ * from an interrupt context.
+ *
+ * \param data The data that is to be passed to the SLIP driver
+ * \param len The number of bytes
+ *
+ * \return Non-zero if the CPU should be powered up, zero otherwise.
+ */
+int slip_input_bytes(const unsigned char *data, int len);
+
 uint8_t slip_write(const void *ptr, int len);
 
 /* Did we receive any bytes lately? */
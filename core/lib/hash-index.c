@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Open-addressing hash index of table entries.
+ */
+
+#include <string.h>
+#include "lib/hash-index.h"
+
+/*---------------------------------------------------------------------------*/
+uint32_t
+hash_index_fnv1a(uint32_t h, const void *data, unsigned len)
+{
+  const uint8_t *p = data;
+
+  while(len-- > 0) {
+    h = (h ^ *p++) * 16777619UL;
+  }
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+void
+hash_index_clear(struct hash_index *h)
+{
+  memset(h->slots, 0, h->size * sizeof(h->slots[0]));
+}
+/*---------------------------------------------------------------------------*/
+unsigned
+hash_index_find(const struct hash_index *h, unsigned home,
+                int (*match)(int index, const void *key), const void *key)
+{
+  unsigned slot;
+
+  slot = home;
+  while(h->slots[slot] != 0 && !match(h->slots[slot] - 1, key)) {
+    slot = (slot + 1) % h->size;
+  }
+  return slot;
+}
+/*---------------------------------------------------------------------------*/
+int
+hash_index_get(const struct hash_index *h, unsigned slot)
+{
+  return (int)h->slots[slot] - 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+hash_index_set(struct hash_index *h, unsigned slot, int index)
+{
+  h->slots[slot] = index + 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+hash_index_can_fill(unsigned hole, unsigned next, unsigned home)
+{
+  return (next > hole && (home <= hole || home > next)) ||
+         (next < hole && (home <= hole && home > next));
+}
+/*---------------------------------------------------------------------------*/
+void
+hash_index_remove(struct hash_index *h, unsigned slot)
+{
+  unsigned next;
+
+  if(h->slots[slot] == 0) {
+    return;
+  }
+  h->slots[slot] = 0;
+  next = slot;
+  while(1) {
+    next = (next + 1) % h->size;
+    if(h->slots[next] == 0) {
+      break;
+    }
+    if(hash_index_can_fill(slot, next, h->home(h->slots[next] - 1))) {
+      h->slots[slot] = h->slots[next];
+      h->slots[next] = 0;
+      slot = next;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Open-addressing hash index of table entries.
+ *
+ *         The index maps keys to the indices of entries in a table,
+ *         e.g. a MEMB, without storing the keys. It is an array of
+ *         16-bit slots with linear probing, in which a slot holds the
+ *         index of an entry plus one and zero marks an empty slot.
+ *         Entries are removed with backward-shift deletion, so no
+ *         tombstones are needed and lookups never slow down over
+ *         time. The user computes the home slot of a key, e.g. with
+ *         hash_index_fnv1a(), and compares keys through a callback.
+ *
+ *         The index must have more slots than the table has entries,
+ *         so that every probe sequence ends at an empty slot.
+ */
+
+#ifndef HASH_INDEX_H_
+#define HASH_INDEX_H_
+
+#include "contiki-conf.h"
+#include "sys/cc.h"
+
+struct hash_index {
+  uint16_t *slots;
+  unsigned size;
+  /* The home slot of the key of the entry with this index */
+  unsigned (*home)(int index);
+};
+
+/**
+ * Declare a hash index of size slots. home is a function that returns
+ * the home slot of the key of an entry, given its index.
+ */
+#define HASH_INDEX(name, size, home)                    \
+  static uint16_t CC_CONCAT(name, _slots)[size];        \
+  static struct hash_index name = { CC_CONCAT(name, _slots), size, home }
+
+#define HASH_INDEX_FNV1A_INIT 2166136261UL
+
+/**
+ * Add data to an FNV-1a hash, which spreads keys that only differ in
+ * their last bytes, as addresses usually do. Start from
+ * HASH_INDEX_FNV1A_INIT.
+ */
+uint32_t hash_index_fnv1a(uint32_t h, const void *data, unsigned len);
+
+/** Remove all entries. */
+void hash_index_clear(struct hash_index *h);
+
+/**
+ * Get the slot of the entry whose key matches, or of the empty slot
+ * where it would go. The probe starts at home, and match is called
+ * with the index of every entry on the way until it returns non-zero.
+ */
+unsigned hash_index_find(const struct hash_index *h, unsigned home,
+                         int (*match)(int index, const void *key),
+                         const void *key);
+
+/** Get the index of the entry in a slot, or -1 if the slot is empty. */
+int hash_index_get(const struct hash_index *h, unsigned slot);
+
+/** Store the entry with this index in a slot found with hash_index_find(). */
+void hash_index_set(struct hash_index *h, unsigned slot, int index);
+
+/** Empty a slot, and move later entries of its probe sequence into it. */
+void hash_index_remove(struct hash_index *h, unsigned slot);
+
+/**
+ * Tell whether the entry in slot next, whose home slot is home, may
+ * fill the hole left at slot hole by a removal, i.e. whether home is
+ * not in (hole, next]. For tables that store their own slots.
+ */
+int hash_index_can_fill(unsigned hole, unsigned next, unsigned home);
+
+#endif /* HASH_INDEX_H_ */
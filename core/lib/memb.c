@@ -47,12 +47,36 @@
 #include "contiki.h"
 #include "lib/memb.h"
 
+#if MEMB_FREELIST
+/* Pools that are not declared with MEMB() have no free stack and fall
+   back to scanning the reference count array. */
+#define FREELIST_USABLE(m) ((m)->free_stack != NULL)
+/*---------------------------------------------------------------------------*/
+static int
+block_index(struct memb *m, void *ptr)
+{
+  unsigned long offset;
+
+  if(!memb_inmemb(m, ptr)) {
+    return -1;
+  }
+  offset = (unsigned long)((char *)ptr - (char *)m->mem);
+  if(offset % m->size != 0) {
+    return -1;
+  }
+  return (int)(offset / m->size);
+}
+#endif /* MEMB_FREELIST */
 /*---------------------------------------------------------------------------*/
 void
 memb_init(struct memb *m)
 {
   memset(m->count, 0, m->num);
   memset(m->mem, 0, m->size * m->num);
+#if MEMB_FREELIST
+  m->free_count = 0;
+  m->fresh = 0;
+#endif /* MEMB_FREELIST */
 }
 /*---------------------------------------------------------------------------*/
 void *
@@ -60,6 +84,22 @@ memb_alloc(struct memb *m)
 {
   int i;
 
+#if MEMB_FREELIST
+  if(FREELIST_USABLE(m)) {
+    if(m->free_count > 0) {
+      /* Reuse the most recently freed block. */
+      i = m->free_stack[--m->free_count];
+    } else if(m->fresh < m->num) {
+      /* Hand out a block that has never been used. */
+      i = m->fresh++;
+    } else {
+      return NULL;
+    }
+    m->count[i] = 1;
+    return (void *)((char *)m->mem + (i * m->size));
+  }
+#endif /* MEMB_FREELIST */
+
   for(i = 0; i < m->num; ++i) {
     if(m->count[i] == 0) {
       /* If this block was unused, we increase the reference count to
@@ -81,6 +121,24 @@ memb_free(struct memb *m, void *ptr)
   int i;
   char *ptr2;
 
+#if MEMB_FREELIST
+  if(FREELIST_USABLE(m)) {
+    i = block_index(m, ptr);
+    if(i < 0) {
+      return -1;
+    }
+    /* Only push the block when its last reference goes away, which
+       also keeps a double free from corrupting the stack. */
+    if(m->count[i] > 0) {
+      --(m->count[i]);
+      if(m->count[i] == 0) {
+        m->free_stack[m->free_count++] = i;
+      }
+    }
+    return m->count[i];
+  }
+#endif /* MEMB_FREELIST */
+
   /* Walk through the list of blocks and try to find the block to
      which the pointer "ptr" points to. */
   ptr2 = (char *)m->mem;
@@ -113,6 +171,12 @@ memb_numfree(struct memb *m)
   int i;
   int num_free = 0;
 
+#if MEMB_FREELIST
+  if(FREELIST_USABLE(m)) {
+    return m->num - m->fresh + m->free_count;
+  }
+#endif /* MEMB_FREELIST */
+
   for(i = 0; i < m->num; ++i) {
     if(m->count[i] == 0) {
       ++num_free;
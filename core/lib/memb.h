@@ -65,6 +65,24 @@
 
 #include "sys/cc.h"
 
+/**
+ * \brief Enable the free-list allocation mode.
+ *
+ * By default, memb_alloc(), memb_free() and memb_numfree() scan the
+ * reference count array of the pool, which costs O(num) per call.
+ * With MEMB_CONF_FREELIST set to 1, the indices of freed blocks are
+ * instead kept on a stack next to the reference count array, so that
+ * all three operations run in constant time. The price is one
+ * unsigned short per block and two counters per pool. The blocks
+ * themselves are never written by memb, so a freed block keeps its
+ * contents until it is allocated again, as in the default mode.
+ */
+#ifdef MEMB_CONF_FREELIST
+#define MEMB_FREELIST MEMB_CONF_FREELIST
+#else
+#define MEMB_FREELIST 0
+#endif
+
 /**
  * Declare a memory block.
  *
@@ -86,18 +104,38 @@ MEMB(connections, struct connection, 16);
  * \param num The total number of memory chunks in the block.
  *
  */
+#if MEMB_FREELIST
+#define MEMB(name, structure, num) \
+        static char CC_CONCAT(name,_memb_count)[num]; \
+        static structure CC_CONCAT(name,_memb_mem)[num]; \
+        static unsigned short CC_CONCAT(name,_memb_free)[num]; \
+        static struct memb name = {sizeof(structure), num, \
+                                          CC_CONCAT(name,_memb_count), \
+                                          (void *)CC_CONCAT(name,_memb_mem), \
+                                          CC_CONCAT(name,_memb_free)}
+#else /* MEMB_FREELIST */
 #define MEMB(name, structure, num) \
         static char CC_CONCAT(name,_memb_count)[num]; \
         static structure CC_CONCAT(name,_memb_mem)[num]; \
         static struct memb name = {sizeof(structure), num, \
                                           CC_CONCAT(name,_memb_count), \
                                           (void *)CC_CONCAT(name,_memb_mem)}
+#endif /* MEMB_FREELIST */
 
 struct memb {
   unsigned short size;
   unsigned short num;
   char *count;
   void *mem;
+#if MEMB_FREELIST
+  /* Stack of the indices of freed blocks, with free_count entries.
+     Blocks at index "fresh" and above have never been handed out and
+     are not on the stack, which lets a zero-initialized pool work
+     without a memb_init() call. */
+  unsigned short *free_stack;
+  unsigned short free_count;
+  unsigned short fresh;
+#endif /* MEMB_FREELIST */
 };
 
 /**
@@ -55,9 +55,98 @@
 #define MMEM_SIZE 4096
 #endif
 
-LIST(mmemlist);
 unsigned int avail_memory;
+
+#if MMEM_BUDDY
+/* A free block stores its own free list links and size class. */
+struct free_block {
+  struct free_block *next;
+  struct free_block *prev;
+  unsigned char order;
+};
+
+/* The smallest size class must be able to hold a struct free_block. */
+#define MIN_ORDER (sizeof(struct free_block) <= 8 ? 3 : \
+                   sizeof(struct free_block) <= 16 ? 4 : 5)
+#define NUM_ORDERS (sizeof(unsigned int) * 8)
+#define BLOCK_SIZE(order) ((unsigned int)1 << (order))
+
+/* The union only serves to align the heap for struct free_block. */
+static union {
+  char bytes[MMEM_SIZE];
+  struct free_block align;
+} heap;
+#define memory heap.bytes
+
+static struct free_block *free_lists[NUM_ORDERS];
+
+/* One bit per smallest block, set if a free block starts there. */
+static unsigned char free_map[MMEM_SIZE / 64 + 1];
+#else /* MMEM_BUDDY */
+LIST(mmemlist);
 static char memory[MMEM_SIZE];
+#endif /* MMEM_BUDDY */
+
+#if MMEM_STATS
+static struct mmem_stats stats;
+/* Number of bytes that can be handed out, which in buddy mode may be
+   slightly less than MMEM_SIZE. */
+static unsigned int capacity;
+#endif /* MMEM_STATS */
+
+#if MMEM_BUDDY
+/*---------------------------------------------------------------------------*/
+static unsigned char
+order_of(unsigned int size)
+{
+  unsigned char order;
+
+  for(order = MIN_ORDER; BLOCK_SIZE(order) < size; order++);
+  return order;
+}
+/*---------------------------------------------------------------------------*/
+static int
+starts_free_block(unsigned int offset)
+{
+  offset >>= MIN_ORDER;
+  return (free_map[offset >> 3] & (1 << (offset & 7))) != 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+free_push(unsigned int offset, unsigned char order)
+{
+  struct free_block *b = (struct free_block *)&memory[offset];
+  unsigned int bit = offset >> MIN_ORDER;
+
+  b->order = order;
+  b->prev = NULL;
+  b->next = free_lists[order];
+  if(b->next != NULL) {
+    b->next->prev = b;
+  }
+  free_lists[order] = b;
+  free_map[bit >> 3] |= 1 << (bit & 7);
+  avail_memory += BLOCK_SIZE(order);
+}
+/*---------------------------------------------------------------------------*/
+static void
+free_unlink(struct free_block *b)
+{
+  unsigned int bit = ((char *)b - memory) >> MIN_ORDER;
+
+  if(b->prev != NULL) {
+    b->prev->next = b->next;
+  } else {
+    free_lists[b->order] = b->next;
+  }
+  if(b->next != NULL) {
+    b->next->prev = b->prev;
+  }
+  free_map[bit >> 3] &= ~(1 << (bit & 7));
+  avail_memory -= BLOCK_SIZE(b->order);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* MMEM_BUDDY */
 
 /*---------------------------------------------------------------------------*/
 /**
@@ -82,8 +171,47 @@ static char memory[MMEM_SIZE];
 int
 mmem_alloc(struct mmem *m, unsigned int size)
 {
+#if MMEM_BUDDY
+  struct free_block *b;
+  unsigned char order, i;
+
+  if(size > MMEM_SIZE) {
+#if MMEM_STATS
+    stats.failed_allocs++;
+#endif /* MMEM_STATS */
+    return 0;
+  }
+
+  /* Find the smallest free block that is large enough, and split it
+     until it matches the size class of the request. The upper halves
+     go back to the free lists. */
+  order = order_of(size);
+  for(i = order; i < NUM_ORDERS && free_lists[i] == NULL; i++);
+  if(i == NUM_ORDERS) {
+#if MMEM_STATS
+    stats.failed_allocs++;
+#endif /* MMEM_STATS */
+    return 0;
+  }
+
+  b = free_lists[i];
+  free_unlink(b);
+  while(i > order) {
+    i--;
+    free_push((char *)b - memory + BLOCK_SIZE(i), i);
+  }
+
+  m->ptr = b;
+  m->size = size;
+#if MMEM_STATS
+  stats.wasted += BLOCK_SIZE(order) - size;
+#endif /* MMEM_STATS */
+#else /* MMEM_BUDDY */
   /* Check if we have enough memory left for this allocation. */
   if(avail_memory < size) {
+#if MMEM_STATS
+    stats.failed_allocs++;
+#endif /* MMEM_STATS */
     return 0;
   }
 
@@ -100,6 +228,14 @@ mmem_alloc(struct mmem *m, unsigned int size)
 
   /* Decrease the amount of available memory. */
   avail_memory -= size;
+#endif /* MMEM_BUDDY */
+
+#if MMEM_STATS
+  stats.used = capacity - avail_memory;
+  if(stats.used > stats.peak_used) {
+    stats.peak_used = stats.used;
+  }
+#endif /* MMEM_STATS */
 
   /* Return non-zero to indicate that we were able to allocate
      memory. */
@@ -118,6 +254,35 @@ mmem_alloc(struct mmem *m, unsigned int size)
 void
 mmem_free(struct mmem *m)
 {
+#if MMEM_BUDDY
+  struct free_block *buddy;
+  unsigned int offset;
+  unsigned char order;
+
+  order = order_of(m->size);
+  offset = (char *)m->ptr - memory;
+#if MMEM_STATS
+  stats.wasted -= BLOCK_SIZE(order) - m->size;
+#endif /* MMEM_STATS */
+
+  /* Merge the block with its buddy for as long as the buddy is free
+     and of the same size class. */
+  while(order + 1 < NUM_ORDERS) {
+    unsigned int buddy_offset = offset ^ BLOCK_SIZE(order);
+    if(buddy_offset + BLOCK_SIZE(order) > MMEM_SIZE ||
+       !starts_free_block(buddy_offset)) {
+      break;
+    }
+    buddy = (struct free_block *)&memory[buddy_offset];
+    if(buddy->order != order) {
+      break;
+    }
+    free_unlink(buddy);
+    offset &= ~BLOCK_SIZE(order);
+    order++;
+  }
+  free_push(offset, order);
+#else /* MMEM_BUDDY */
   struct mmem *n;
 
   if(m->next != NULL) {
@@ -125,6 +290,10 @@ mmem_free(struct mmem *m)
        by moving it downwards. */
     memmove(m->ptr, m->next->ptr,
 	    &memory[MMEM_SIZE - avail_memory] - (char *)m->next->ptr);
+#if MMEM_STATS
+    stats.bytes_moved +=
+      &memory[MMEM_SIZE - avail_memory] - (char *)m->next->ptr;
+#endif /* MMEM_STATS */
     
     /* Update all the memory pointers that points to memory that is
        after the allocation that is to be removed. */
@@ -137,6 +306,11 @@ mmem_free(struct mmem *m)
 
   /* Remove the memory block from the list. */
   list_remove(mmemlist, m);
+#endif /* MMEM_BUDDY */
+
+#if MMEM_STATS
+  stats.used = capacity - avail_memory;
+#endif /* MMEM_STATS */
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -155,10 +329,66 @@ mmem_init(void)
   if(inited) {
     return;
   }
+#if MMEM_BUDDY
+  {
+    unsigned int offset;
+    unsigned char order;
+
+    /* Cover the heap with the largest aligned blocks that fit. A
+       heap that is not a power of two in size is split into several
+       top-level blocks; any remainder smaller than the smallest size
+       class is left unused. */
+    avail_memory = 0;
+    offset = 0;
+    for(order = NUM_ORDERS; order > MIN_ORDER; order--) {
+      if(BLOCK_SIZE(order - 1) <= MMEM_SIZE - offset) {
+        free_push(offset, order - 1);
+        offset += BLOCK_SIZE(order - 1);
+      }
+    }
+  }
+#else /* MMEM_BUDDY */
   list_init(mmemlist);
   avail_memory = MMEM_SIZE;
+#endif /* MMEM_BUDDY */
+#if MMEM_STATS
+  capacity = avail_memory;
+#endif /* MMEM_STATS */
   inited = 1;
 }
 /*---------------------------------------------------------------------------*/
+#if MMEM_STATS
+/**
+ * \brief      Get the allocator statistics
+ * \param s    A pointer to a struct mmem_stats that is filled in
+ *
+ *             This function copies the current statistics of the
+ *             managed memory module into the given structure. In
+ *             buddy mode, no memory is ever moved so bytes_moved
+ *             stays zero; in the default mode, no requests are
+ *             rounded up so wasted stays zero.
+ */
+void
+mmem_get_stats(struct mmem_stats *s)
+{
+#if MMEM_BUDDY
+  unsigned char order;
+#endif /* MMEM_BUDDY */
+
+  *s = stats;
+#if MMEM_BUDDY
+  s->largest_free = 0;
+  for(order = NUM_ORDERS; order > MIN_ORDER; order--) {
+    if(free_lists[order - 1] != NULL) {
+      s->largest_free = BLOCK_SIZE(order - 1);
+      break;
+    }
+  }
+#else /* MMEM_BUDDY */
+  s->largest_free = avail_memory;
+#endif /* MMEM_BUDDY */
+}
+/*---------------------------------------------------------------------------*/
+#endif /* MMEM_STATS */
 
 /** @} */
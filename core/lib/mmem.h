@@ -44,6 +44,10 @@
  * stays in place. Therefore, a level of indirection is used: access
  * to allocated memory must always be done using a special macro.
  *
+ * Optionally, the heap can instead be managed by a buddy allocator
+ * (see MMEM_CONF_BUDDY) that never moves memory and frees in bounded
+ * time, at the cost of rounding and fragmentation.
+ *
  * \note This module has not been heavily tested.
  * @{
  */
@@ -59,6 +63,41 @@
 #ifndef MMEM_H_
 #define MMEM_H_
 
+#include "contiki-conf.h"
+
+/**
+ * \brief Enable the buddy allocation mode.
+ *
+ * By default, mmem_free() compacts the heap by moving every block
+ * that was allocated after the freed one, so freeing costs time
+ * proportional to the amount of memory that is in use. With
+ * MMEM_CONF_BUDDY set to 1, the heap is instead managed as a binary
+ * buddy allocator with one free list per power-of-two size class.
+ * Blocks never move and both mmem_alloc() and mmem_free() run in time
+ * proportional to the number of size classes. The price is that
+ * requests are rounded up to the next power of two, and that
+ * freed memory may be fragmented. Access through MMEM_PTR() works
+ * in both modes.
+ */
+#ifdef MMEM_CONF_BUDDY
+#define MMEM_BUDDY MMEM_CONF_BUDDY
+#else
+#define MMEM_BUDDY 0
+#endif
+
+/**
+ * \brief Keep allocator statistics.
+ *
+ * With MMEM_CONF_STATS set to 1, the allocator keeps the counters in
+ * struct mmem_stats up to date. They can be read with
+ * mmem_get_stats().
+ */
+#ifdef MMEM_CONF_STATS
+#define MMEM_STATS MMEM_CONF_STATS
+#else
+#define MMEM_STATS 0
+#endif
+
 /*---------------------------------------------------------------------------*/
 /**
  * \brief      Get a pointer to the managed memory
@@ -87,6 +126,29 @@ int  mmem_alloc(struct mmem *m, unsigned int size);
 void mmem_free(struct mmem *);
 void mmem_init(void);
 
+#if MMEM_STATS
+struct mmem_stats {
+  /** Bytes currently handed out, including rounding in buddy mode. */
+  unsigned int used;
+  /** Highest value that "used" has reached. */
+  unsigned int peak_used;
+  /** Bytes lost to rounding up requests to a size class. */
+  unsigned int wasted;
+  /** Size of the largest block that can currently be allocated. */
+  unsigned int largest_free;
+  /** Number of mmem_alloc() calls that failed. */
+  unsigned int failed_allocs;
+  /** Total number of bytes moved by compaction in mmem_free(). */
+  unsigned long bytes_moved;
+};
+
+/**
+ * \brief      Get the allocator statistics
+ * \param s    A pointer to a struct mmem_stats that is filled in
+ */
+void mmem_get_stats(struct mmem_stats *s);
+#endif /* MMEM_STATS */
+
 #endif /* MMEM_H_ */
 
 /** @} */
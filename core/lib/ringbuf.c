@@ -39,6 +39,7 @@
 
 #include "lib/ringbuf.h"
 #include <sys/cc.h>
+#include <string.h>
 /*---------------------------------------------------------------------------*/
 void
 ringbuf_init(struct ringbuf *r, uint8_t *dataptr, uint8_t size)
@@ -72,6 +73,7 @@ ringbuf_put(struct ringbuf *r, uint8_t c)
    * better safe than sorry.
    */
   CC_ACCESS_NOW(uint8_t, r->data[r->put_ptr]) = c;
+  CC_MEMORY_BARRIER();
   CC_ACCESS_NOW(uint8_t, r->put_ptr) = (r->put_ptr + 1) & r->mask;
   return 1;
 }
@@ -101,7 +103,9 @@ ringbuf_get(struct ringbuf *r)
      * because the register used for mask can be reused to save c
      * (on some architectures).
      */
+    CC_MEMORY_BARRIER();
     c = CC_ACCESS_NOW(uint8_t, r->data[r->get_ptr]);
+    CC_MEMORY_BARRIER();
     CC_ACCESS_NOW(uint8_t, r->get_ptr) = (r->get_ptr + 1) & r->mask;
     return c;
   } else {
@@ -110,6 +114,69 @@ ringbuf_get(struct ringbuf *r)
 }
 /*---------------------------------------------------------------------------*/
 int
+ringbuf_put_bulk(struct ringbuf *r, const uint8_t *data, int len)
+{
+  uint8_t put_ptr;
+  int space, first;
+
+  /* Only the writer changes ->put_ptr, so only ->get_ptr needs to be
+     read with care. */
+  put_ptr = r->put_ptr;
+  space = r->mask - ((put_ptr - CC_ACCESS_NOW(uint8_t, r->get_ptr)) & r->mask);
+  if(len > space) {
+    len = space;
+  }
+  if(len <= 0) {
+    return 0;
+  }
+
+  /* Copy up to the end of the array, and the rest to the start. */
+  first = r->mask + 1 - put_ptr;
+  if(first > len) {
+    first = len;
+  }
+  memcpy(&r->data[put_ptr], data, first);
+  memcpy(r->data, data + first, len - first);
+
+  /* The data must be in place before the reader can see it. */
+  CC_MEMORY_BARRIER();
+  CC_ACCESS_NOW(uint8_t, r->put_ptr) = (put_ptr + len) & r->mask;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbuf_get_bulk(struct ringbuf *r, uint8_t *data, int len)
+{
+  uint8_t get_ptr;
+  int available, first;
+
+  /* Only the reader changes ->get_ptr, so only ->put_ptr needs to be
+     read with care. */
+  get_ptr = r->get_ptr;
+  available = (CC_ACCESS_NOW(uint8_t, r->put_ptr) - get_ptr) & r->mask;
+  if(len > available) {
+    len = available;
+  }
+  if(len <= 0) {
+    return 0;
+  }
+
+  /* Do not read the data before the index that published it. */
+  CC_MEMORY_BARRIER();
+  first = r->mask + 1 - get_ptr;
+  if(first > len) {
+    first = len;
+  }
+  memcpy(data, &r->data[get_ptr], first);
+  memcpy(data + first, r->data, len - first);
+
+  /* The data must be copied out before the writer may overwrite it. */
+  CC_MEMORY_BARRIER();
+  CC_ACCESS_NOW(uint8_t, r->get_ptr) = (get_ptr + len) & r->mask;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
 ringbuf_size(struct ringbuf *r)
 {
   return r->mask + 1;
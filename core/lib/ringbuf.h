@@ -115,6 +115,38 @@ int     ringbuf_put(struct ringbuf *r, uint8_t c);
  */
 int     ringbuf_get(struct ringbuf *r);
 
+/**
+ * \brief      Insert a number of bytes into the ring buffer
+ * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
+ * \param data A pointer to the bytes to be written to the buffer
+ * \param len  The number of bytes to write
+ * \return     The number of bytes that were written, which is less
+ *             than len if the buffer became full.
+ *
+ *             This function copies as many bytes as fit into the ring
+ *             buffer with at most two memcpy() calls, and makes them
+ *             visible to the reader all at once. Like ringbuf_put(),
+ *             it may be called from an interrupt handler, as long as
+ *             there is only one writer.
+ *
+ */
+int     ringbuf_put_bulk(struct ringbuf *r, const uint8_t *data, int len);
+
+/**
+ * \brief      Get a number of bytes from the ring buffer
+ * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
+ * \param data A pointer to where the bytes should be copied
+ * \param len  The maximum number of bytes to get
+ * \return     The number of bytes that were copied, zero if the buffer was empty.
+ *
+ *             This function removes up to len bytes from the ring
+ *             buffer with at most two memcpy() calls. Like
+ *             ringbuf_get(), it may be called from an interrupt
+ *             handler, as long as there is only one reader.
+ *
+ */
+int     ringbuf_get_bulk(struct ringbuf *r, uint8_t *data, int len);
+
 /**
  * \brief      Get the size of a ring buffer
  * \param r    A pointer to a struct ringbuf to hold the state of the ring buffer
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2017, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         A single-producer single-consumer ring buffer of fixed-size
+ *         elements, with bulk operations. Like core/lib/ringbuf, but
+ *         for elements of any size, and unlike core/lib/ringbufindex
+ *         the elements are copied in and out by the module.
+ */
+
+#include <string.h>
+#include "lib/ringbufelem.h"
+#include "sys/cc.h"
+
+/*---------------------------------------------------------------------------*/
+void
+ringbufelem_init(struct ringbufelem *r, void *data,
+                 uint16_t elem_size, uint8_t num_elements)
+{
+  r->data = data;
+  r->elem_size = elem_size;
+  r->mask = num_elements - 1;
+  r->put_ptr = 0;
+  r->get_ptr = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Copy count elements between the ring at index and buf, wrapping
+   around the end of the storage if needed. */
+static void
+copy(struct ringbufelem *r, uint8_t index, uint8_t *buf, int count,
+     int to_ring)
+{
+  int first;
+
+  first = r->mask + 1 - index;
+  if(first > count) {
+    first = count;
+  }
+  if(to_ring) {
+    memcpy(&r->data[index * r->elem_size], buf, first * r->elem_size);
+    memcpy(r->data, buf + first * r->elem_size,
+           (count - first) * r->elem_size);
+  } else {
+    memcpy(buf, &r->data[index * r->elem_size], first * r->elem_size);
+    memcpy(buf + first * r->elem_size, r->data,
+           (count - first) * r->elem_size);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbufelem_put_bulk(struct ringbufelem *r, const void *elems, int count)
+{
+  uint8_t put_ptr;
+  int space;
+
+  /* Only the writer changes ->put_ptr. */
+  put_ptr = r->put_ptr;
+  space = r->mask - ((put_ptr - CC_ACCESS_NOW(uint8_t, r->get_ptr)) & r->mask);
+  if(count > space) {
+    count = space;
+  }
+  if(count <= 0) {
+    return 0;
+  }
+
+  copy(r, put_ptr, (uint8_t *)elems, count, 1);
+
+  /* The elements must be in place before the reader can see them. */
+  CC_MEMORY_BARRIER();
+  CC_ACCESS_NOW(uint8_t, r->put_ptr) = (put_ptr + count) & r->mask;
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbufelem_get_bulk(struct ringbufelem *r, void *elems, int count)
+{
+  uint8_t get_ptr;
+  int available;
+
+  /* Only the reader changes ->get_ptr. */
+  get_ptr = r->get_ptr;
+  available = (CC_ACCESS_NOW(uint8_t, r->put_ptr) - get_ptr) & r->mask;
+  if(count > available) {
+    count = available;
+  }
+  if(count <= 0) {
+    return 0;
+  }
+
+  /* Do not read the elements before the index that published them. */
+  CC_MEMORY_BARRIER();
+  copy(r, get_ptr, elems, count, 0);
+
+  /* The elements must be copied out before the writer may reuse the
+     slots. */
+  CC_MEMORY_BARRIER();
+  CC_ACCESS_NOW(uint8_t, r->get_ptr) = (get_ptr + count) & r->mask;
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbufelem_put(struct ringbufelem *r, const void *elem)
+{
+  return ringbufelem_put_bulk(r, elem, 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbufelem_get(struct ringbufelem *r, void *elem)
+{
+  return ringbufelem_get_bulk(r, elem, 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbufelem_size(const struct ringbufelem *r)
+{
+  return r->mask + 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+ringbufelem_elements(const struct ringbufelem *r)
+{
+  return (r->put_ptr - r->get_ptr) & r->mask;
+}
+/*---------------------------------------------------------------------------*/
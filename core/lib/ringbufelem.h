@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Header file for the ringbufelem library, a single-producer
+ *         single-consumer ring buffer of fixed-size elements.
+ */
+
+#ifndef RINGBUFELEM_H_
+#define RINGBUFELEM_H_
+
+#include "contiki-conf.h"
+
+/**
+ * \brief Structure that holds the state of an element ring buffer.
+ *
+ * The element storage is an external array of num_elements elements
+ * of elem_size bytes each, where num_elements is a power of two of at
+ * most 128. One element of the array is always kept free. Elements
+ * are copied in and out, so that one writer, e.g. an interrupt
+ * handler, and one reader, e.g. a process, may use the ring at the
+ * same time without locking, also on multi-core hosts.
+ */
+struct ringbufelem {
+  uint8_t *data;
+  uint16_t elem_size;
+  uint8_t mask;
+  /* These must be 8-bit quantities to avoid race conditions. */
+  uint8_t put_ptr, get_ptr;
+};
+
+/**
+ * \brief Initialize an element ring buffer
+ * \param r Pointer to ringbufelem
+ * \param data Pointer to the element storage
+ * \param elem_size Size of an element in bytes
+ * \param num_elements Number of elements in the storage, a power of two
+ */
+void ringbufelem_init(struct ringbufelem *r, void *data,
+                      uint16_t elem_size, uint8_t num_elements);
+
+/**
+ * \brief Copy one element into the ring buffer
+ * \param r Pointer to ringbufelem
+ * \param elem Pointer to the element
+ * \return 1 in case of success, 0 if the ring buffer was full
+ */
+int ringbufelem_put(struct ringbufelem *r, const void *elem);
+
+/**
+ * \brief Copy one element out of the ring buffer and remove it
+ * \param r Pointer to ringbufelem
+ * \param elem Pointer to where the element is copied
+ * \return 1 in case of success, 0 if the ring buffer was empty
+ */
+int ringbufelem_get(struct ringbufelem *r, void *elem);
+
+/**
+ * \brief Copy up to count elements into the ring buffer
+ * \param r Pointer to ringbufelem
+ * \param elems Pointer to an array of elements
+ * \param count Number of elements in the array
+ * \return The number of elements that were put
+ */
+int ringbufelem_put_bulk(struct ringbufelem *r, const void *elems, int count);
+
+/**
+ * \brief Copy up to count elements out of the ring buffer and remove them
+ * \param r Pointer to ringbufelem
+ * \param elems Pointer to an array with room for count elements
+ * \param count Maximum number of elements to get
+ * \return The number of elements that were copied
+ */
+int ringbufelem_get_bulk(struct ringbufelem *r, void *elems, int count);
+
+/**
+ * \brief Return the number of elements the ring buffer can hold
+ * \param r Pointer to ringbufelem
+ * \return The number of elements
+ */
+int ringbufelem_size(const struct ringbufelem *r);
+
+/**
+ * \brief Return the number of elements currently in the ring buffer
+ * \param r Pointer to ringbufelem
+ * \return The number of elements
+ */
+int ringbufelem_elements(const struct ringbufelem *r);
+
+#endif /* RINGBUFELEM_H_ */
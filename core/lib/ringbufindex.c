@@ -44,6 +44,7 @@
 
 #include <string.h>
 #include "lib/ringbufindex.h"
+#include "sys/cc.h"
 
 /* Initialize a ring buffer. The size must be a power of two */
 void
@@ -69,7 +70,9 @@ ringbufindex_put(struct ringbufindex *r)
   if(((r->put_ptr - r->get_ptr) & r->mask) == r->mask) {
     return 0;
   }
-  r->put_ptr = (r->put_ptr + 1) & r->mask;
+  /* The element must be written before it is published. */
+  CC_MEMORY_BARRIER();
+  CC_ACCESS_NOW(uint8_t, r->put_ptr) = (r->put_ptr + 1) & r->mask;
   return 1;
 }
 /* Check if there is space to put an element.
@@ -103,7 +106,9 @@ ringbufindex_get(struct ringbufindex *r)
    */
   if(((r->put_ptr - r->get_ptr) & r->mask) > 0) {
     get_ptr = r->get_ptr;
-    r->get_ptr = (r->get_ptr + 1) & r->mask;
+    /* The element must be read before its slot is handed back. */
+    CC_MEMORY_BARRIER();
+    CC_ACCESS_NOW(uint8_t, r->get_ptr) = (r->get_ptr + 1) & r->mask;
     return get_ptr;
   } else {
     return -1;
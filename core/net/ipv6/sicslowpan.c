@@ -251,6 +251,39 @@ static uint16_t my_tag;
 /* Assuming that the worst growth for uncompression is 38 bytes */
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
 
+/* REASS_DIRECT gives each reassembly context a buffer of its own, the
+ * size of a full IPv6 datagram, into which every fragment is written
+ * at its offset as it arrives. The shared pool of fragment buffers is
+ * then not used, and a bitmap of the received 8-byte blocks makes
+ * duplicate fragments harmless. The completed datagram is copied once
+ * into uip_buf.
+ **/
+#ifdef SICSLOWPAN_CONF_REASS_DIRECT
+#define SICSLOWPAN_REASS_DIRECT SICSLOWPAN_CONF_REASS_DIRECT
+#else
+#define SICSLOWPAN_REASS_DIRECT 0
+#endif
+
+/* FRAG_FORWARDING lets a router relay the fragments of a datagram that
+ * is not addressed to it one by one, as they arrive, instead of
+ * reassembling the whole datagram first (a virtual reassembly
+ * buffer). The first fragment is uncompressed to find the next hop and
+ * compressed again for the next link; the following fragments only get
+ * a new datagram tag. Datagrams that carry a Hop-by-Hop or Routing
+ * header, or whose next hop is not yet in the neighbor cache, are
+ * reassembled as before.
+ **/
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING SICSLOWPAN_CONF_FRAG_FORWARDING
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+#if SICSLOWPAN_REASS_DIRECT
+#define SICSLOWPAN_REASS_BUF_SIZE (UIP_BUFSIZE - UIP_LLH_LEN)
+#define SICSLOWPAN_REASS_BLOCKS ((SICSLOWPAN_REASS_BUF_SIZE + 7) / 8)
+#endif /* SICSLOWPAN_REASS_DIRECT */
+
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
   /** When reassembling, the source address of the fragments being merged */
@@ -266,15 +299,68 @@ struct sicslowpan_frag_info {
   /** Reassembly %process %timer. */
   struct timer reass_timer;
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  /** Non-zero if the fragments are forwarded rather than reassembled */
+  uint8_t forward;
+  /** When forwarding, the tag used towards the next hop */
+  uint16_t forward_tag;
+  /** When forwarding, the link-layer address of the next hop */
+  linkaddr_t next_hop;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   /** Fragment size of first fragment */
   uint16_t first_frag_len;
+#if SICSLOWPAN_REASS_DIRECT
+  /** One bit per 8-byte block of the datagram received so far */
+  uint8_t received[(SICSLOWPAN_REASS_BLOCKS + 7) / 8];
+  /** The datagram, with each fragment at its offset. The uncompressed
+   first fragment is written at the start. */
+  uint8_t first_frag[SICSLOWPAN_REASS_BUF_SIZE];
+#else /* SICSLOWPAN_REASS_DIRECT */
   /** First fragment - needs a larger buffer since the size is uncompressed size
    and we need to know total size to know when we have received last fragment. */
   uint8_t first_frag[SICSLOWPAN_FIRST_FRAGMENT_SIZE];
+#endif /* SICSLOWPAN_REASS_DIRECT */
 };
 
 static struct sicslowpan_frag_info frag_info[SICSLOWPAN_REASS_CONTEXTS];
 
+#if SICSLOWPAN_REASS_DIRECT
+/*---------------------------------------------------------------------------*/
+/* Mark the bytes [offset, offset + len) of a context as received and
+   return how many of them had not been received before */
+static uint16_t
+mark_received(uint8_t index, uint16_t offset, uint16_t len)
+{
+  uint16_t block;
+  uint16_t block_len;
+  uint16_t end;
+  uint16_t new_len;
+  uint8_t *received;
+
+  received = frag_info[index].received;
+  end = offset + len;
+  new_len = 0;
+  for(block = offset >> 3; (block << 3) < end; block++) {
+    if((received[block >> 3] & (1 << (block & 7))) == 0) {
+      received[block >> 3] |= 1 << (block & 7);
+      block_len = end - (block << 3);
+      new_len += block_len < 8 ? block_len : 8;
+    }
+  }
+  return new_len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+clear_fragments(uint8_t frag_info_index)
+{
+  frag_info[frag_info_index].len = 0;
+  memset(frag_info[frag_info_index].received, 0,
+         sizeof(frag_info[frag_info_index].received));
+  return 1;
+}
+#else /* SICSLOWPAN_REASS_DIRECT */
+
 struct sicslowpan_frag_buf {
   /* the index of the frag_info */
   uint8_t index;
@@ -303,6 +389,7 @@ clear_fragments(uint8_t frag_info_index)
   }
   return clear_count;
 }
+#endif /* SICSLOWPAN_REASS_DIRECT */
 /*---------------------------------------------------------------------------*/
 static int
 timeout_fragments(int not_context)
@@ -318,6 +405,33 @@ timeout_fragments(int not_context)
   }
   return count;
 }
+#if SICSLOWPAN_REASS_DIRECT
+/*---------------------------------------------------------------------------*/
+static int
+store_fragment(uint8_t index, uint8_t offset)
+{
+  uint16_t start;
+  uint16_t len;
+
+  start = (uint16_t)offset << 3;
+  len = packetbuf_datalen() - packetbuf_hdr_len;
+  if(start >= frag_info[index].len) {
+    PRINTF("Fragment offset %u beyond datagram size %u\n",
+           start, frag_info[index].len);
+    return -1;
+  }
+  /* Ignore any extraneous bytes at the end of the last fragment */
+  if(start + len > frag_info[index].len) {
+    len = frag_info[index].len - start;
+  }
+  memcpy(frag_info[index].first_frag + start,
+         packetbuf_ptr + packetbuf_hdr_len, len);
+  PRINTF("Fragsize: %d\n", len);
+
+  /* Return the number of bytes that this fragment added */
+  return mark_received(index, start, len);
+}
+#else /* SICSLOWPAN_REASS_DIRECT */
 /*---------------------------------------------------------------------------*/
 static int
 store_fragment(uint8_t index, uint8_t offset)
@@ -340,6 +454,7 @@ store_fragment(uint8_t index, uint8_t offset)
   /* failed */
   return -1;
 }
+#endif /* SICSLOWPAN_REASS_DIRECT */
 /*---------------------------------------------------------------------------*/
 /* add a new fragment to the buffer */
 static int8_t
@@ -370,9 +485,20 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
       return -1;
     }
 
+#if SICSLOWPAN_REASS_DIRECT
+    if(frag_size > SICSLOWPAN_REASS_BUF_SIZE) {
+      PRINTF("*** Datagram too large to reassemble - tag: %d size: %d\n",
+             tag, frag_size);
+      return -1;
+    }
+#endif /* SICSLOWPAN_REASS_DIRECT */
+
     /* Found a free fragment info to store data in */
     frag_info[found].len = frag_size;
     frag_info[found].tag = tag;
+#if SICSLOWPAN_FRAG_FORWARDING
+    frag_info[found].forward = 0;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     linkaddr_copy(&frag_info[found].sender,
                   packetbuf_addr(PACKETBUF_ADDR_SENDER));
     timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
@@ -397,6 +523,13 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
     return -1;
   }
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(frag_info[i].forward) {
+    /* The fragment is relayed by the caller, not stored */
+    return i;
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   /* i is the index of the reassembly context */
   len = store_fragment(i, offset);
   if(len < 0 && timeout_fragments(i) > 0) {
@@ -418,6 +551,11 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 static void
 copy_frags2uip(int context)
 {
+#if SICSLOWPAN_REASS_DIRECT
+  /* The fragments are already in place */
+  memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)frag_info[context].first_frag,
+         frag_info[context].len);
+#else /* SICSLOWPAN_REASS_DIRECT */
   int i;
 
   /* Copy from the fragment context info buffer first */
@@ -430,6 +568,7 @@ copy_frags2uip(int context)
 	     (uint8_t *)frag_buf[i].data, frag_buf[i].len);
     }
   }
+#endif /* SICSLOWPAN_REASS_DIRECT */
   /* deallocate all the fragments for this context */
   clear_fragments(context);
 }
@@ -532,6 +671,10 @@ const uint8_t llprefix[] = {0xfe, 0x80};
 /* TTL uncompression values */
 static const uint8_t ttl_values[] = {0, 1, 64, 255};
 
+/* Inline length of traffic class and flow label, indexed by the TF
+   bits: all inline, ECN + flow label, ECN + DSCP, all elided */
+static const uint8_t tf_inline_len[] = {4, 3, 1, 0};
+
 /*--------------------------------------------------------------------*/
 /** \name IPHC related functions
  * @{                                                                 */
@@ -668,7 +811,8 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
 static void
 compress_hdr_iphc(linkaddr_t *link_destaddr)
 {
-  uint8_t tmp, iphc0, iphc1;
+  uint8_t tmp, tf, iphc0, iphc1;
+  struct sicslowpan_addr_context *src_context, *dest_context;
 #if DEBUG
   { uint16_t ndx;
     PRINTF("before compression (%d): ", UIP_IP_BUF->len[1]);
@@ -699,11 +843,13 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
    */
 
 
-  /* check if dest context exists (for allocating third byte) */
-  /* TODO: fix this so that it remembers the looked up values for
-     avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  /*
+   * Look up the contexts of both addresses once. The CID byte is
+   * needed if either of them matches a context.
+   */
+  src_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr);
+  dest_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr);
+  if(src_context != NULL || dest_context != NULL) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -713,8 +859,8 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   /*
    * Traffic class, flow label
    * If flow label is 0, compress it. If traffic class is 0, compress it
-   * We have to process both in the same time as the offset of traffic class
-   * depends on the presence of version and flow label
+   * The TF bits select one of four layouts, whose inline lengths are
+   * given by tf_inline_len[].
    */
 
   /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
@@ -722,37 +868,31 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   tmp = (UIP_IP_BUF->vtc << 4) | (UIP_IP_BUF->tcflow >> 4);
   tmp = ((tmp & 0x03) << 6) | (tmp >> 2);
 
-  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) &&
-     (UIP_IP_BUF->flow == 0)) {
-    /* flow label can be compressed */
-    iphc0 |= SICSLOWPAN_IPHC_FL_C;
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
-      /* compress (elide) all */
-      iphc0 |= SICSLOWPAN_IPHC_TC_C;
-    } else {
-      /* compress only the flow label */
-     *hc06_ptr = tmp;
-      hc06_ptr += 1;
-    }
-  } else {
-    /* Flow label cannot be compressed */
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
-      /* compress only traffic class */
-      iphc0 |= SICSLOWPAN_IPHC_TC_C;
-      *hc06_ptr = (tmp & 0xc0) |
-        (UIP_IP_BUF->tcflow & 0x0F);
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->flow, 2);
-      hc06_ptr += 3;
-    } else {
-      /* compress nothing */
-      memcpy(hc06_ptr, &UIP_IP_BUF->vtc, 4);
-      /* but replace the top byte with the new ECN | DSCP format*/
-      *hc06_ptr = tmp;
-      hc06_ptr += 4;
-   }
+  tf = 0;
+  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) && (UIP_IP_BUF->flow == 0)) {
+    tf |= SICSLOWPAN_IPHC_FL_C >> 3;
+  }
+  if(((UIP_IP_BUF->vtc & 0x0F) == 0) && ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+    tf |= SICSLOWPAN_IPHC_TC_C >> 3;
+  }
+  iphc0 |= tf << 3;
+  switch(tf) {
+  case 0:
+    /* compress nothing, but replace the top byte with ECN | DSCP */
+    hc06_ptr[0] = tmp;
+    memcpy(hc06_ptr + 1, &UIP_IP_BUF->tcflow, 3);
+    break;
+  case 1:
+    /* compress only traffic class, ECN is kept */
+    hc06_ptr[0] = (tmp & 0xc0) | (UIP_IP_BUF->tcflow & 0x0F);
+    memcpy(hc06_ptr + 1, &UIP_IP_BUF->flow, 2);
+    break;
+  case 2:
+    /* compress only the flow label */
+    hc06_ptr[0] = tmp;
+    break;
   }
+  hc06_ptr += tf_inline_len[tf];
 
   /* Note that the payload length is always compressed */
 
@@ -796,13 +936,12 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
-     != NULL) {
+  } else if(src_context != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
-           context->number);
+           src_context->number);
     iphc1 |= SICSLOWPAN_IPHC_CID | SICSLOWPAN_IPHC_SAC;
-    PACKETBUF_IPHC_BUF[2] |= context->number << 4;
+    PACKETBUF_IPHC_BUF[2] |= src_context->number << 4;
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
@@ -850,10 +989,10 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if(dest_context != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
-      PACKETBUF_IPHC_BUF[2] |= context->number;
+      PACKETBUF_IPHC_BUF[2] |= dest_context->number;
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
@@ -955,7 +1094,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 static void
 uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
 {
-  uint8_t tmp, iphc0, iphc1;
+  uint8_t tmp, tf, fl, iphc0, iphc1;
   /* at least two byte will be used for the encoding */
   hc06_ptr = packetbuf_ptr + packetbuf_hdr_len + 2;
 
@@ -969,44 +1108,37 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
   }
 
   /* Traffic class and flow label */
-    if((iphc0 & SICSLOWPAN_IPHC_FL_C) == 0) {
-      /* Flow label are carried inline */
-      if((iphc0 & SICSLOWPAN_IPHC_TC_C) == 0) {
-        /* Traffic class is carried inline */
-        memcpy(&SICSLOWPAN_IP_BUF(buf)->tcflow, hc06_ptr + 1, 3);
-        tmp = *hc06_ptr;
-        hc06_ptr += 4;
-        /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
-        /* set version, pick highest DSCP bits and set in vtc */
-        SICSLOWPAN_IP_BUF(buf)->vtc = 0x60 | ((tmp >> 2) & 0x0f);
-        /* ECN rolled down two steps + lowest DSCP bits at top two bits */
-        SICSLOWPAN_IP_BUF(buf)->tcflow = ((tmp >> 2) & 0x30) | (tmp << 6) |
-	  (SICSLOWPAN_IP_BUF(buf)->tcflow & 0x0f);
-      } else {
-        /* Traffic class is compressed (set version and no TC)*/
-        SICSLOWPAN_IP_BUF(buf)->vtc = 0x60;
-        /* highest flow label bits + ECN bits */
-        SICSLOWPAN_IP_BUF(buf)->tcflow = (*hc06_ptr & 0x0F) |
-          ((*hc06_ptr >> 2) & 0x30);
-        memcpy(&SICSLOWPAN_IP_BUF(buf)->flow, hc06_ptr + 1, 2);
-        hc06_ptr += 3;
-      }
-    } else {
-      /* Version is always 6! */
-      /* Version and flow label are compressed */
-      if((iphc0 & SICSLOWPAN_IPHC_TC_C) == 0) {
-        /* Traffic class is inline */
-	SICSLOWPAN_IP_BUF(buf)->vtc = 0x60 | ((*hc06_ptr >> 2) & 0x0f);
-          SICSLOWPAN_IP_BUF(buf)->tcflow = ((*hc06_ptr << 6) & 0xC0) | ((*hc06_ptr >> 2) & 0x30);
-          SICSLOWPAN_IP_BUF(buf)->flow = 0;
-          hc06_ptr += 1;
-      } else {
-        /* Traffic class is compressed */
-        SICSLOWPAN_IP_BUF(buf)->vtc = 0x60;
-        SICSLOWPAN_IP_BUF(buf)->tcflow = 0;
-        SICSLOWPAN_IP_BUF(buf)->flow = 0;
-      }
-    }
+  /* Gather ECN | DSCP, the top flow label bits and the rest of the
+     flow label from whichever of them are carried inline */
+  tf = (iphc0 >> 3) & 0x03;
+  switch(tf) {
+  case 0:
+    tmp = hc06_ptr[0];
+    fl = hc06_ptr[1] & 0x0f;
+    memcpy(&SICSLOWPAN_IP_BUF(buf)->flow, hc06_ptr + 2, 2);
+    break;
+  case 1:
+    tmp = hc06_ptr[0] & 0xc0;
+    fl = hc06_ptr[0] & 0x0f;
+    memcpy(&SICSLOWPAN_IP_BUF(buf)->flow, hc06_ptr + 1, 2);
+    break;
+  case 2:
+    tmp = hc06_ptr[0];
+    fl = 0;
+    SICSLOWPAN_IP_BUF(buf)->flow = 0;
+    break;
+  default:
+    tmp = 0;
+    fl = 0;
+    SICSLOWPAN_IP_BUF(buf)->flow = 0;
+    break;
+  }
+  hc06_ptr += tf_inline_len[tf];
+  /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
+  /* Version is always 6! Pick the highest DSCP bits for vtc */
+  SICSLOWPAN_IP_BUF(buf)->vtc = 0x60 | ((tmp >> 2) & 0x0f);
+  /* ECN rolled down two steps + lowest DSCP bits at top two bits */
+  SICSLOWPAN_IP_BUF(buf)->tcflow = ((tmp >> 2) & 0x30) | (tmp << 6) | fl;
 
   /* Next Header */
   if((iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
@@ -1294,6 +1426,12 @@ output(const uip_lladdr_t *localdest)
     set_packet_attrs();
   }
 
+  /* Let the MAC layer tell ICMPv6 messages, e.g. RPL and ND, from data.
+     Type 0 is reserved, and marks other packets. */
+  packetbuf_set_attr(PACKETBUF_ATTR_ICMP6_TYPE,
+                     UIP_IP_BUF->proto == UIP_PROTO_ICMP6 ?
+                     UIP_ICMP_BUF->type : 0);
+
 #if PACKETBUF_WITH_PACKET_TYPE
 #define TCP_FIN 0x01
 #define TCP_ACK 0x10
@@ -1401,9 +1539,9 @@ output(const uip_lladdr_t *localdest)
     packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
     packetbuf_payload_len = (max_payload - packetbuf_hdr_len) & 0xfffffff8;
     PRINTFO("(len %d, tag %d)\n", packetbuf_payload_len, frag_tag);
-    memcpy(packetbuf_ptr + packetbuf_hdr_len,
-           (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, packetbuf_payload_len);
-    packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
+    packetbuf_set_datalen(packetbuf_hdr_len);
+    packetbuf_append_reference((uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
+                               packetbuf_payload_len);
     q = queuebuf_new_from_packetbuf();
     if(q == NULL) {
       PRINTFO("could not allocate queuebuf for first fragment, dropping packet\n");
@@ -1447,9 +1585,9 @@ output(const uip_lladdr_t *localdest)
       }
       PRINTFO("(offset %d, len %d, tag %d)\n",
              processed_ip_out_len >> 3, packetbuf_payload_len, frag_tag);
-      memcpy(packetbuf_ptr + packetbuf_hdr_len,
-             (uint8_t *)UIP_IP_BUF + processed_ip_out_len, packetbuf_payload_len);
-      packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
+      packetbuf_set_datalen(packetbuf_hdr_len);
+      packetbuf_append_reference((uint8_t *)UIP_IP_BUF + processed_ip_out_len,
+                                 packetbuf_payload_len);
       q = queuebuf_new_from_packetbuf();
       if(q == NULL) {
         PRINTFO("could not allocate queuebuf, dropping fragment\n");
@@ -1477,16 +1615,186 @@ output(const uip_lladdr_t *localdest)
 
     /*
      * The packet does not need to be fragmented
-     * copy "payload" and send
+     * reference "payload" and send
      */
-    memcpy(packetbuf_ptr + packetbuf_hdr_len, (uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
-           uip_len - uncomp_hdr_len);
-    packetbuf_set_datalen(uip_len - uncomp_hdr_len + packetbuf_hdr_len);
+    packetbuf_set_datalen(packetbuf_hdr_len);
+    packetbuf_append_reference((uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
+                               uip_len - uncomp_hdr_len);
     send_packet(&dest);
   }
   return 1;
 }
 
+#if SICSLOWPAN_CONF_FRAG && SICSLOWPAN_FRAG_FORWARDING
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Try to relay the first fragment of a datagram to its next hop
+ * \param context The reassembly context holding the uncompressed
+ * first fragment
+ * \return 1 if the fragment was sent on, 0 if the datagram should be
+ * reassembled locally
+ *
+ * On success the context is switched to forwarding, so that the
+ * following fragments are relayed by forward_fragment() as they
+ * arrive. The datagram keeps its size and fragment offsets; only the
+ * header compression of the first fragment and the tag change.
+ */
+static int
+forward_first_fragment(int8_t context)
+{
+  struct sicslowpan_frag_info *info;
+  struct uip_ip_hdr *ip;
+  uip_ipaddr_t *nexthop;
+  uip_ds6_route_t *route;
+  const uip_lladdr_t *lladdr;
+  linkaddr_t dest;
+  int framer_hdrlen;
+  uint16_t payload_len;
+
+  info = &frag_info[context];
+  ip = (struct uip_ip_hdr *)info->first_frag;
+
+  /* Datagrams for us, multicast, datagrams whose extension headers
+     must be processed at every hop and expiring datagrams all go
+     through the IP layer. */
+  if(uip_is_addr_mcast(&ip->destipaddr) ||
+     uip_ds6_is_my_addr(&ip->destipaddr) ||
+     ip->proto == UIP_PROTO_HBHO || ip->proto == UIP_PROTO_ROUTING ||
+     ip->ttl <= 1) {
+    return 0;
+  }
+
+  if(uip_ds6_is_addr_onlink(&ip->destipaddr)) {
+    nexthop = &ip->destipaddr;
+  } else {
+    route = uip_ds6_route_lookup(&ip->destipaddr);
+    if(route != NULL) {
+      nexthop = uip_ds6_route_nexthop(route);
+    } else {
+      nexthop = uip_ds6_defrt_choose();
+    }
+  }
+  if(nexthop == NULL) {
+    return 0;
+  }
+  lladdr = uip_ds6_nbr_lladdr_from_ipaddr(nexthop);
+  if(lladdr == NULL) {
+    /* Neighbor discovery is needed first */
+    return 0;
+  }
+  linkaddr_copy(&dest, (const linkaddr_t *)lladdr);
+  if(linkaddr_cmp(&dest, &info->sender)) {
+    return 0;
+  }
+
+  /* Compress the header again, for the next link */
+  memcpy((uint8_t *)UIP_IP_BUF, info->first_frag, info->first_frag_len);
+  UIP_IP_BUF->ttl--;
+
+  uncomp_hdr_len = 0;
+  packetbuf_hdr_len = 0;
+  packetbuf_clear();
+  packetbuf_ptr = packetbuf_dataptr();
+
+  if(info->len >= COMPRESSION_THRESHOLD) {
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
+    compress_hdr_ipv6(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+    compress_hdr_iphc(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
+  } else {
+    compress_hdr_ipv6(&dest);
+  }
+  if(uncomp_hdr_len > info->first_frag_len) {
+    return 0;
+  }
+  payload_len = info->first_frag_len - uncomp_hdr_len;
+
+  /* The fragment offsets are fixed by the originator, so the first
+     fragment must still fit in one frame with its new header. */
+#ifndef SICSLOWPAN_USE_FIXED_HDRLEN
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
+  framer_hdrlen = NETSTACK_FRAMER.length();
+  if(framer_hdrlen < 0) {
+    framer_hdrlen = SICSLOWPAN_FIXED_HDRLEN;
+  }
+#else /* SICSLOWPAN_USE_FIXED_HDRLEN */
+  framer_hdrlen = SICSLOWPAN_FIXED_HDRLEN;
+#endif /* SICSLOWPAN_USE_FIXED_HDRLEN */
+  if(SICSLOWPAN_FRAG1_HDR_LEN + packetbuf_hdr_len + payload_len >
+     MAC_MAX_PAYLOAD - framer_hdrlen) {
+    PRINTFO("sicslowpan forward: first fragment too large, reassembling\n");
+    return 0;
+  }
+
+  memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr,
+          packetbuf_hdr_len);
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | info->len));
+  info->forward_tag = my_tag++;
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, info->forward_tag);
+  packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+  packetbuf_set_datalen(packetbuf_hdr_len);
+  packetbuf_append_reference((uint8_t *)UIP_IP_BUF + uncomp_hdr_len, payload_len);
+
+  info->forward = 1;
+  linkaddr_copy(&info->next_hop, &dest);
+  PRINTFO("sicslowpan forward: first fragment (size %d, tag %d -> %d)\n",
+          info->len, info->tag, info->forward_tag);
+  send_packet(&dest);
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Relay a subsequent fragment of a datagram being forwarded
+ * \param context The context of the datagram
+ * \param offset The offset of the fragment, in units of 8 bytes
+ *
+ * The fragment is sent on from packetbuf as it is, with the tag of
+ * the outgoing datagram. The context is freed once the whole
+ * datagram has passed.
+ */
+static void
+forward_fragment(int8_t context, uint8_t offset)
+{
+  struct sicslowpan_frag_info *info;
+  uint16_t start;
+  uint16_t len;
+
+  info = &frag_info[context];
+  start = (uint16_t)offset << 3;
+  if(packetbuf_datalen() < packetbuf_hdr_len || start >= info->len) {
+    return;
+  }
+  len = packetbuf_datalen() - packetbuf_hdr_len;
+  if(start + len > info->len) {
+    len = info->len - start;
+  }
+#if SICSLOWPAN_REASS_DIRECT
+  /* Do not relay duplicates */
+  len = mark_received(context, start, len);
+  if(len == 0) {
+    return;
+  }
+#endif /* SICSLOWPAN_REASS_DIRECT */
+  info->reassembled_len += len;
+
+  /* Reuse the received frame: drop the MAC header and its attributes */
+  packetbuf_compact();
+  packetbuf_attr_clear();
+  packetbuf_ptr = packetbuf_dataptr();
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, info->forward_tag);
+  PRINTFO("sicslowpan forward: fragment (offset %d, tag %d -> %d)\n",
+          offset, info->tag, info->forward_tag);
+  send_packet(&info->next_hop);
+
+  if(info->reassembled_len >= info->len) {
+    clear_fragments(context);
+  }
+}
+#endif /* SICSLOWPAN_CONF_FRAG && SICSLOWPAN_FRAG_FORWARDING */
+
 /*--------------------------------------------------------------------*/
 /** \brief Process a received 6lowpan packet.
  *
@@ -1591,6 +1899,13 @@ input(void)
         return;
       }
 
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(frag_info[frag_context].forward) {
+        forward_fragment(frag_context, frag_offset);
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
       /* Ok - add_fragment will store the fragment automatically - so
          we should not store more */
       buffer = NULL;
@@ -1678,8 +1993,18 @@ input(void)
   if(frag_size > 0) {
     /* Add the size of the header only for the first fragment. */
     if(first_fragment != 0) {
+#if SICSLOWPAN_REASS_DIRECT
+      frag_info[frag_context].reassembled_len =
+        mark_received(frag_context, 0, uncomp_hdr_len + packetbuf_payload_len);
+#else /* SICSLOWPAN_REASS_DIRECT */
       frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
+#endif /* SICSLOWPAN_REASS_DIRECT */
       frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(forward_first_fragment(frag_context)) {
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     }
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
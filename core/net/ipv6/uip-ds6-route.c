@@ -43,6 +43,7 @@
 
 #include "lib/list.h"
 #include "lib/memb.h"
+#include "lib/hash-index.h"
 #include "net/nbr-table.h"
 
 #include <string.h>
@@ -75,6 +76,24 @@ MEMB(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
 static int num_routes = 0;
 static void rm_routelist_callback(nbr_table_item_t *ptr);
 
+#if UIP_DS6_ROUTE_WITH_HASH
+#if UIP_DS6_ROUTE_HASH_SIZE <= UIP_DS6_ROUTE_NB
+#error "UIP_DS6_ROUTE_HASH_SIZE must be larger than UIP_DS6_ROUTE_NB"
+#endif /* UIP_DS6_ROUTE_HASH_SIZE <= UIP_DS6_ROUTE_NB */
+/* Hash index from address to the index of a host route in routememb */
+static unsigned hash_home(int index);
+HASH_INDEX(route_hash, UIP_DS6_ROUTE_HASH_SIZE, hash_home);
+
+/* Routes shorter than /128, sorted by decreasing prefix length so
+   that the first match is the longest one. */
+static uip_ds6_route_t *prefix_routes[UIP_DS6_ROUTE_PREFIX_NB];
+static int num_prefix_routes;
+
+/* Prefix routes that did not fit in prefix_routes. While there are
+   any, lookups walk the routelist instead. */
+static int num_unindexed_routes;
+#endif /* UIP_DS6_ROUTE_WITH_HASH */
+
 #endif /* (UIP_CONF_MAX_ROUTES != 0) */
 
 /* Default routes are held on the defaultrouterlist and their
@@ -162,6 +181,11 @@ uip_ds6_route_init(void)
 #if (UIP_CONF_MAX_ROUTES != 0)
   memb_init(&routememb);
   list_init(routelist);
+#if UIP_DS6_ROUTE_WITH_HASH
+  hash_index_clear(&route_hash);
+  num_prefix_routes = 0;
+  num_unindexed_routes = 0;
+#endif /* UIP_DS6_ROUTE_WITH_HASH */
   nbr_table_register(nbr_routes,
                      (nbr_table_callback *)rm_routelist_callback);
 #endif /* (UIP_CONF_MAX_ROUTES != 0) */
@@ -249,20 +273,16 @@ uip_ds6_route_num_routes(void)
   return 0;
 #endif /* (UIP_CONF_MAX_ROUTES != 0) */
 }
+#if (UIP_CONF_MAX_ROUTES != 0)
 /*---------------------------------------------------------------------------*/
-uip_ds6_route_t *
-uip_ds6_route_lookup(uip_ipaddr_t *addr)
+/* Find the longest matching route by walking the whole routelist */
+static uip_ds6_route_t *
+list_lookup(uip_ipaddr_t *addr)
 {
-#if (UIP_CONF_MAX_ROUTES != 0)
   uip_ds6_route_t *r;
   uip_ds6_route_t *found_route;
   uint8_t longestmatch;
 
-  PRINTF("uip-ds6-route: Looking up route for ");
-  PRINT6ADDR(addr);
-  PRINTF("\n");
-
-
   found_route = NULL;
   longestmatch = 0;
   for(r = uip_ds6_route_head();
@@ -278,6 +298,124 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
       }
     }
   }
+  return found_route;
+}
+#if UIP_DS6_ROUTE_WITH_HASH
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+route_from_index(int index)
+{
+  return (uip_ds6_route_t *)routememb.mem + index;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_ipaddr(const uip_ipaddr_t *addr)
+{
+  return hash_index_fnv1a(HASH_INDEX_FNV1A_INIT, addr, sizeof(uip_ipaddr_t))
+      % UIP_DS6_ROUTE_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_home(int index)
+{
+  return hash_ipaddr(&route_from_index(index)->ipaddr);
+}
+/*---------------------------------------------------------------------------*/
+static int
+hash_match(int index, const void *addr)
+{
+  return uip_ipaddr_cmp((const uip_ipaddr_t *)addr,
+                        &route_from_index(index)->ipaddr);
+}
+/*---------------------------------------------------------------------------*/
+/* Get the hash slot of a host route, or of the empty slot where it
+   would go */
+static unsigned
+hash_find(const uip_ipaddr_t *addr)
+{
+  return hash_index_find(&route_hash, hash_ipaddr(addr), hash_match, addr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_add(uip_ds6_route_t *r)
+{
+  int i;
+
+  if(r->length == 128) {
+    hash_index_set(&route_hash, hash_find(&r->ipaddr), r - route_from_index(0));
+  } else if(num_prefix_routes < UIP_DS6_ROUTE_PREFIX_NB) {
+    for(i = num_prefix_routes;
+        i > 0 && prefix_routes[i - 1]->length < r->length; i--) {
+      prefix_routes[i] = prefix_routes[i - 1];
+    }
+    prefix_routes[i] = r;
+    num_prefix_routes++;
+  } else {
+    num_unindexed_routes++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_rm(uip_ds6_route_t *r)
+{
+  int i;
+
+  if(r->length == 128) {
+    hash_index_remove(&route_hash, hash_find(&r->ipaddr));
+    return;
+  }
+  for(i = 0; i < num_prefix_routes; i++) {
+    if(prefix_routes[i] == r) {
+      num_prefix_routes--;
+      for(; i < num_prefix_routes; i++) {
+        prefix_routes[i] = prefix_routes[i + 1];
+      }
+      return;
+    }
+  }
+  num_unindexed_routes--;
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+index_lookup(uip_ipaddr_t *addr)
+{
+  int index;
+  int i;
+
+  index = hash_index_get(&route_hash, hash_find(addr));
+  if(index != -1) {
+    return route_from_index(index);
+  }
+  for(i = 0; i < num_prefix_routes; i++) {
+    if(uip_ipaddr_prefixcmp(addr, &prefix_routes[i]->ipaddr,
+                            prefix_routes[i]->length)) {
+      return prefix_routes[i];
+    }
+  }
+  return NULL;
+}
+#endif /* UIP_DS6_ROUTE_WITH_HASH */
+#endif /* (UIP_CONF_MAX_ROUTES != 0) */
+/*---------------------------------------------------------------------------*/
+uip_ds6_route_t *
+uip_ds6_route_lookup(uip_ipaddr_t *addr)
+{
+#if (UIP_CONF_MAX_ROUTES != 0)
+  uip_ds6_route_t *found_route;
+
+  PRINTF("uip-ds6-route: Looking up route for ");
+  PRINT6ADDR(addr);
+  PRINTF("\n");
+
+#if UIP_DS6_ROUTE_WITH_HASH
+  if(num_unindexed_routes == 0) {
+    found_route = index_lookup(addr);
+  } else {
+    found_route = list_lookup(addr);
+  }
+#else /* UIP_DS6_ROUTE_WITH_HASH */
+  found_route = list_lookup(addr);
+#endif /* UIP_DS6_ROUTE_WITH_HASH */
 
   if(found_route != NULL) {
     PRINTF("uip-ds6-route: Found route: ");
@@ -289,6 +427,9 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     PRINTF("uip-ds6-route: No route found\n");
   }
 
+#if !UIP_DS6_ROUTE_WITH_HASH || UIP_DS6_ROUTE_REMOVE_LEAST_RECENTLY_USED
+  /* With the hash index, the list order only matters when evicting
+     the least recently used route, and keeping it costs a list walk. */
   if(found_route != NULL && found_route != list_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
@@ -298,6 +439,7 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     list_remove(routelist, found_route);
     list_push(routelist, found_route);
   }
+#endif /* !UIP_DS6_ROUTE_WITH_HASH || UIP_DS6_ROUTE_REMOVE_LEAST_RECENTLY_USED */
 
   return found_route;
 #else /* (UIP_CONF_MAX_ROUTES != 0) */
@@ -436,6 +578,9 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
 
   uip_ipaddr_copy(&(r->ipaddr), ipaddr);
   r->length = length;
+#if UIP_DS6_ROUTE_WITH_HASH
+  index_add(r);
+#endif /* UIP_DS6_ROUTE_WITH_HASH */
 
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   memset(&r->state, 0, sizeof(UIP_DS6_ROUTE_STATE_TYPE));
@@ -479,6 +624,9 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
 
     /* Remove the route from the route list */
     list_remove(routelist, route);
+#if UIP_DS6_ROUTE_WITH_HASH
+    index_rm(route);
+#endif /* UIP_DS6_ROUTE_WITH_HASH */
 
     /* Find the corresponding neighbor_route and remove it. */
     for(neighbor_route = list_head(route->neighbor_routes->route_list);
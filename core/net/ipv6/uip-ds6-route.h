@@ -88,6 +88,33 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define UIP_DS6_ROUTE_NB 4
 #endif /* UIP_CONF_MAX_ROUTES */
 
+/* Index host (/128) routes in a hash table, and keep shorter prefixes
+ * on a small array sorted by length, so that uip_ds6_route_lookup()
+ * does not walk the whole routing table. Meant for storing-mode RPL
+ * roots with large routing tables. Costs UIP_DS6_ROUTE_HASH_SIZE
+ * 16-bit words plus UIP_DS6_ROUTE_PREFIX_NB pointers of RAM. */
+#ifdef UIP_DS6_ROUTE_CONF_WITH_HASH
+#define UIP_DS6_ROUTE_WITH_HASH UIP_DS6_ROUTE_CONF_WITH_HASH
+#else /* UIP_DS6_ROUTE_CONF_WITH_HASH */
+#define UIP_DS6_ROUTE_WITH_HASH 0
+#endif /* UIP_DS6_ROUTE_CONF_WITH_HASH */
+
+/* Number of slots in the hash index, should be about twice
+ * UIP_DS6_ROUTE_NB to keep probe sequences short */
+#ifdef UIP_DS6_ROUTE_CONF_HASH_SIZE
+#define UIP_DS6_ROUTE_HASH_SIZE UIP_DS6_ROUTE_CONF_HASH_SIZE
+#else /* UIP_DS6_ROUTE_CONF_HASH_SIZE */
+#define UIP_DS6_ROUTE_HASH_SIZE (2 * UIP_DS6_ROUTE_NB)
+#endif /* UIP_DS6_ROUTE_CONF_HASH_SIZE */
+
+/* Number of routes shorter than /128 that are indexed. Lookups fall
+ * back to a walk of the routing table while there are more. */
+#ifdef UIP_DS6_ROUTE_CONF_PREFIX_NB
+#define UIP_DS6_ROUTE_PREFIX_NB UIP_DS6_ROUTE_CONF_PREFIX_NB
+#else /* UIP_DS6_ROUTE_CONF_PREFIX_NB */
+#define UIP_DS6_ROUTE_PREFIX_NB 8
+#endif /* UIP_DS6_ROUTE_CONF_PREFIX_NB */
+
 /** \brief define some additional RPL related route state and
  *  neighbor callback for RPL - if not a DS6_ROUTE_STATE is already set */
 #ifndef UIP_DS6_ROUTE_STATE_TYPE
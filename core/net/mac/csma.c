@@ -43,6 +43,7 @@
 
 #include "sys/ctimer.h"
 #include "sys/clock.h"
+#include "sys/energest.h"
 
 #include "lib/random.h"
 
@@ -172,6 +173,8 @@ transmit_packet_list(void *ptr)
     if(q != NULL) {
       PRINTF("csma: preparing number %d %p, queue len %d\n", n->transmissions, q,
           list_length(n->queued_packet_list));
+      ENERGEST_TRACE_MARK(ENERGEST_TRACE_MARK_TX_START,
+                          queuebuf_attr(q->buf, PACKETBUF_ATTR_MAC_SEQNO));
       /* Send packets in the neighbor's list */
       NETSTACK_RDC.send_list(packet_sent, n, q);
     }
@@ -252,6 +255,9 @@ tx_done(int status, struct rdc_buf_list *q, struct neighbor_queue *n)
     break;
   }
 
+  ENERGEST_TRACE_MARK(ENERGEST_TRACE_MARK_TX_DONE,
+                      (queuebuf_attr(q->buf, PACKETBUF_ATTR_MAC_SEQNO) & 0xff) |
+                      (status << 8));
   free_packet(n, q, status);
   mac_call_sent_callback(sent, cptr, status, ntx);
 }
@@ -448,6 +454,8 @@ send_packet(mac_callback_t sent, void *ptr)
 static void
 input_packet(void)
 {
+  ENERGEST_TRACE_MARK(ENERGEST_TRACE_MARK_RX,
+                      packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO));
   NETSTACK_LLSEC.input();
 }
 /*---------------------------------------------------------------------------*/
@@ -184,6 +184,17 @@
 #define TSCH_HW_FRAME_FILTERING 1
 #endif /* TSCH_CONF_HW_FRAME_FILTERING */
 
+/* Max number of consecutive timeslots used for a burst of unicast packets to
+ * the same neighbor. When more packets are queued for the neighbor, the sender
+ * sets the frame pending bit, and both nodes keep using the same link and
+ * channel in the next timeslot. Burst slots take precedence over any link
+ * scheduled in the following timeslots. 0 disables bursts. */
+#ifdef TSCH_CONF_BURST_MAX_LEN
+#define TSCH_BURST_MAX_LEN TSCH_CONF_BURST_MAX_LEN
+#else /* TSCH_CONF_BURST_MAX_LEN */
+#define TSCH_BURST_MAX_LEN 0
+#endif /* TSCH_CONF_BURST_MAX_LEN */
+
 /* Keep radio always on within TSCH timeslot (1) or turn it off between packet and ACK? (0) */
 #ifdef TSCH_CONF_RADIO_ON_DURING_TIMESLOT
 #define TSCH_RADIO_ON_DURING_TIMESLOT TSCH_CONF_RADIO_ON_DURING_TIMESLOT
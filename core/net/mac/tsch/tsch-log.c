@@ -34,7 +34,9 @@
  * \file
  *         Log functions for TSCH, meant for logging from interrupt
  *         during a timeslot operation. Saves ASN, slot and link information
- *         and adds the log to a ringbuf for later printout.
+ *         and adds the log to a ringbuf for later printout. In binary mode,
+ *         Tx and Rx logs are instead stored as compact records and streamed
+ *         in SLIP frames.
  * \author
  *         Simon Duquennoy <simonduq@sics.se>
  *
@@ -50,6 +52,9 @@
 #include "net/mac/tsch/tsch-schedule.h"
 #include "net/mac/tsch/tsch-slot-operation.h"
 #include "lib/ringbufindex.h"
+#if TSCH_LOG_BINARY
+#include "lib/crc16.h"
+#endif /* TSCH_LOG_BINARY */
 
 #if TSCH_LOG_LEVEL >= 1
 #define DEBUG DEBUG_PRINT
@@ -70,6 +75,203 @@ static struct ringbufindex log_ringbuf;
 static struct tsch_log_t log_array[TSCH_LOG_QUEUE_LEN];
 static int log_dropped = 0;
 
+#if TSCH_LOG_BINARY
+
+#if (TSCH_LOG_BINARY_QUEUE_LEN & (TSCH_LOG_BINARY_QUEUE_LEN - 1)) != 0 || TSCH_LOG_BINARY_QUEUE_LEN > 128
+#error TSCH_LOG_BINARY_QUEUE_LEN must be power of two, at most 128
+#endif
+
+/* Binary stream format. Each SLIP frame holds:
+ * - magic 'T' 'L', version, node ID, number of records, number of
+ *   records dropped so far (16-bit little endian)
+ * - the records
+ * - CRC-16 (as in lib/crc16) of all the above (16-bit little endian)
+ * Each record is TSCH_LOG_RECORD_LEN bytes:
+ * 0: type (1: tx, 2: rx) | flags (0x10: unicast, 0x20: data, 0x40: secured, 0x80: drift used)
+ * 1-4: ASN ls4b (little endian), 5: ASN ms1b
+ * 6: slotframe handle, 7-8: timeslot (little endian), 9: channel
+ *    (0xff, 0xffff, 0 if no link)
+ * 10: peer ID (dest for tx, src for rx), 11: MAC seqno
+ * 12: tx: MAC tx status << 4 | number of transmissions, rx: 0
+ * 13: rx: RSSI (signed), tx: 0
+ * 14: frame length, 15: drift used, in usec (signed, saturated)
+ */
+#define TSCH_LOG_MAGIC_0 'T'
+#define TSCH_LOG_MAGIC_1 'L'
+#define TSCH_LOG_VERSION 1
+#define TSCH_LOG_RECORD_LEN 16
+#define TSCH_LOG_RECORD_TX 1
+#define TSCH_LOG_RECORD_RX 2
+#define TSCH_LOG_FLAG_UNICAST 0x10
+#define TSCH_LOG_FLAG_DATA 0x20
+#define TSCH_LOG_FLAG_SECURED 0x40
+#define TSCH_LOG_FLAG_DRIFT_USED 0x80
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+/* Single producer (slot operation), single consumer (tsch_log_process_pending) */
+static struct ringbufindex record_ringbuf;
+static uint8_t record_array[TSCH_LOG_BINARY_QUEUE_LEN][TSCH_LOG_RECORD_LEN];
+static uint16_t records_dropped = 0;
+/* Tx and Rx logs are prepared here, and stored as records on commit */
+static struct tsch_log_t record_log;
+static clock_time_t last_flush;
+/* Wakes up the log process when a partial batch is due */
+static struct ctimer flush_timer;
+
+/*---------------------------------------------------------------------------*/
+static int8_t
+saturate_int8(int32_t v)
+{
+  return v > 127 ? 127 : (v < -128 ? -128 : v);
+}
+/*---------------------------------------------------------------------------*/
+/* Store a Tx or Rx log as a binary record */
+static void
+add_record(const struct tsch_log_t *log)
+{
+  int16_t index = ringbufindex_peek_put(&record_ringbuf);
+  uint8_t *r;
+  int peer;
+  uint8_t flags;
+
+  if(index == -1) {
+    records_dropped++;
+    return;
+  }
+  r = record_array[index];
+
+  if(log->type == tsch_log_tx) {
+    flags = TSCH_LOG_RECORD_TX;
+    flags |= log->tx.dest != 0 ? TSCH_LOG_FLAG_UNICAST : 0;
+    flags |= log->tx.is_data ? TSCH_LOG_FLAG_DATA : 0;
+    flags |= log->tx.sec_level ? TSCH_LOG_FLAG_SECURED : 0;
+    flags |= log->tx.drift_used ? TSCH_LOG_FLAG_DRIFT_USED : 0;
+    peer = log->tx.dest;
+    r[11] = log->tx.seqno;
+    r[12] = (log->tx.mac_tx_status << 4) | MIN(log->tx.num_tx, 15);
+    r[13] = 0;
+    r[14] = log->tx.datalen;
+    r[15] = log->tx.drift_used ? saturate_int8(RTIMERTICKS_TO_US(log->tx.drift)) : 0;
+  } else {
+    flags = TSCH_LOG_RECORD_RX;
+    flags |= log->rx.is_unicast ? TSCH_LOG_FLAG_UNICAST : 0;
+    flags |= log->rx.is_data ? TSCH_LOG_FLAG_DATA : 0;
+    flags |= log->rx.sec_level ? TSCH_LOG_FLAG_SECURED : 0;
+    flags |= log->rx.drift_used ? TSCH_LOG_FLAG_DRIFT_USED : 0;
+    peer = log->rx.src;
+    r[11] = log->rx.seqno;
+    r[12] = 0;
+    r[13] = saturate_int8(log->rx.rssi);
+    r[14] = log->rx.datalen;
+    r[15] = log->rx.drift_used ? saturate_int8(RTIMERTICKS_TO_US(log->rx.drift)) : 0;
+  }
+
+  r[0] = flags;
+  r[1] = log->asn.ls4b & 0xff;
+  r[2] = (log->asn.ls4b >> 8) & 0xff;
+  r[3] = (log->asn.ls4b >> 16) & 0xff;
+  r[4] = (log->asn.ls4b >> 24) & 0xff;
+  r[5] = log->asn.ms1b;
+  if(log->link != NULL) {
+    r[6] = log->link->slotframe_handle;
+    r[7] = log->link->timeslot & 0xff;
+    r[8] = log->link->timeslot >> 8;
+    r[9] = tsch_calculate_channel((struct tsch_asn_t *)&log->asn, log->link->channel_offset);
+  } else {
+    r[6] = 0xff;
+    r[7] = 0xff;
+    r[8] = 0xff;
+    r[9] = 0;
+  }
+  r[10] = peer;
+
+  ringbufindex_put(&record_ringbuf);
+  /* Wake up the log process, which sends full batches and schedules
+   * the flush of partial ones */
+  process_poll(&tsch_pending_events_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Write a SLIP-escaped byte, and add it to the frame CRC */
+static void
+write_byte(uint8_t c, unsigned short *crc)
+{
+  *crc = crc16_add(c, *crc);
+  if(c == SLIP_END) {
+    TSCH_LOG_BINARY_WRITEB(SLIP_ESC);
+    c = SLIP_ESC_END;
+  } else if(c == SLIP_ESC) {
+    TSCH_LOG_BINARY_WRITEB(SLIP_ESC);
+    c = SLIP_ESC_ESC;
+  }
+  TSCH_LOG_BINARY_WRITEB(c);
+}
+/*---------------------------------------------------------------------------*/
+/* Send up to TSCH_LOG_BINARY_BATCH pending records in a SLIP frame */
+static void
+send_records(void)
+{
+  const linkaddr_t *node_addr = &linkaddr_node_addr;
+  unsigned short crc = 0;
+  unsigned short frame_crc;
+  int count = MIN(ringbufindex_elements(&record_ringbuf), TSCH_LOG_BINARY_BATCH);
+  int i, j;
+
+  TSCH_LOG_BINARY_WRITEB(SLIP_END);
+  write_byte(TSCH_LOG_MAGIC_0, &crc);
+  write_byte(TSCH_LOG_MAGIC_1, &crc);
+  write_byte(TSCH_LOG_VERSION, &crc);
+  write_byte(TSCH_LOG_ID_FROM_LINKADDR(node_addr), &crc);
+  write_byte(count, &crc);
+  write_byte(records_dropped & 0xff, &crc);
+  write_byte(records_dropped >> 8, &crc);
+  for(i = 0; i < count; i++) {
+    uint8_t *r = record_array[ringbufindex_peek_get(&record_ringbuf)];
+    for(j = 0; j < TSCH_LOG_RECORD_LEN; j++) {
+      write_byte(r[j], &crc);
+    }
+    ringbufindex_get(&record_ringbuf);
+  }
+  frame_crc = crc;
+  write_byte(frame_crc & 0xff, &crc);
+  write_byte(frame_crc >> 8, &crc);
+  TSCH_LOG_BINARY_WRITEB(SLIP_END);
+
+  last_flush = clock_time();
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush_timer_callback(void *ptr)
+{
+  process_poll(&tsch_pending_events_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Stream full batches, and partial ones every TSCH_LOG_BINARY_FLUSH_INTERVAL */
+static void
+process_pending_records(void)
+{
+  clock_time_t elapsed;
+
+  while(ringbufindex_elements(&record_ringbuf) >= TSCH_LOG_BINARY_BATCH) {
+    send_records();
+  }
+  if(!ringbufindex_empty(&record_ringbuf)) {
+    elapsed = clock_time() - last_flush;
+    if(elapsed >= TSCH_LOG_BINARY_FLUSH_INTERVAL) {
+      send_records();
+    } else {
+      /* Come back when the partial batch is due, even if no more
+       * records are added until then */
+      ctimer_set(&flush_timer, TSCH_LOG_BINARY_FLUSH_INTERVAL - elapsed,
+                 flush_timer_callback, NULL);
+    }
+  }
+}
+#endif /* TSCH_LOG_BINARY */
+
 /*---------------------------------------------------------------------------*/
 /* Process pending log messages */
 void
@@ -82,6 +284,9 @@ tsch_log_process_pending(void)
     printf("TSCH:! logs dropped %u\n", log_dropped);
     last_log_dropped = log_dropped;
   }
+#if TSCH_LOG_BINARY
+  process_pending_records();
+#endif /* TSCH_LOG_BINARY */
   while((log_index = ringbufindex_peek_get(&log_ringbuf)) != -1) {
     struct tsch_log_t *log = &log_array[log_index];
     if(log->link == NULL) {
@@ -118,33 +323,64 @@ tsch_log_process_pending(void)
       case tsch_log_message:
         printf("%s\n", log->message);
         break;
+      case tsch_log_drop:
+        printf("!queue drop class %u to %d, queue %u, pool free %u, total %u\n",
+            log->drop.traffic_class, log->drop.dest,
+            log->drop.queue_len, log->drop.pool_free,
+            log->drop.drop_count);
+        break;
     }
     /* Remove input from ringbuf */
     ringbufindex_get(&log_ringbuf);
   }
 }
 /*---------------------------------------------------------------------------*/
-/* Prepare addition of a new log.
+/* Prepare addition of a new log of the given type.
  * Returns pointer to log structure if success, NULL otherwise */
 struct tsch_log_t *
-tsch_log_prepare_add(void)
+tsch_log_prepare_add(int type)
 {
-  int log_index = ringbufindex_peek_put(&log_ringbuf);
-  if(log_index != -1) {
-    struct tsch_log_t *log = &log_array[log_index];
+  struct tsch_log_t *log = NULL;
+  int log_index;
+
+#if TSCH_LOG_BINARY
+  if(type == tsch_log_tx || type == tsch_log_rx) {
+    /* Stored in the binary ring on commit, so reserve a slot there */
+    if(ringbufindex_peek_put(&record_ringbuf) != -1) {
+      log = &record_log;
+    } else {
+      records_dropped++;
+    }
+  } else {
+#endif /* TSCH_LOG_BINARY */
+    log_index = ringbufindex_peek_put(&log_ringbuf);
+    if(log_index != -1) {
+      log = &log_array[log_index];
+    } else {
+      log_dropped++;
+    }
+#if TSCH_LOG_BINARY
+  }
+#endif /* TSCH_LOG_BINARY */
+
+  if(log != NULL) {
+    log->type = type;
     log->asn = tsch_current_asn;
     log->link = current_link;
-    return log;
-  } else {
-    log_dropped++;
-    return NULL;
   }
+  return log;
 }
 /*---------------------------------------------------------------------------*/
 /* Actually add the previously prepared log */
 void
-tsch_log_commit(void)
+tsch_log_commit(struct tsch_log_t *log)
 {
+#if TSCH_LOG_BINARY
+  if(log == &record_log) {
+    add_record(log);
+    return;
+  }
+#endif /* TSCH_LOG_BINARY */
   ringbufindex_put(&log_ringbuf);
   process_poll(&tsch_pending_events_process);
 }
@@ -154,6 +390,10 @@ void
 tsch_log_init(void)
 {
   ringbufindex_init(&log_ringbuf, TSCH_LOG_QUEUE_LEN);
+#if TSCH_LOG_BINARY
+  ringbufindex_init(&record_ringbuf, TSCH_LOG_BINARY_QUEUE_LEN);
+  last_flush = clock_time();
+#endif /* TSCH_LOG_BINARY */
 }
 
 #endif /* TSCH_LOG_LEVEL */
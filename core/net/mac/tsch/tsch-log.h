@@ -65,6 +65,44 @@
 #define TSCH_LOG_LEVEL 2
 #endif /* TSCH_LOG_CONF_LEVEL */
 
+/* Binary log mode: Tx and Rx logs are stored as compact records in a separate
+ * ring, and streamed in SLIP frames rather than printed. Other logs are
+ * still printed. Decode the stream with tools/tsch-log/tsch-log-decode */
+#ifdef TSCH_LOG_CONF_BINARY
+#define TSCH_LOG_BINARY TSCH_LOG_CONF_BINARY
+#else /* TSCH_LOG_CONF_BINARY */
+#define TSCH_LOG_BINARY 0
+#endif /* TSCH_LOG_CONF_BINARY */
+
+/* The length of the binary record ring. Must be a power of two */
+#ifdef TSCH_LOG_CONF_BINARY_QUEUE_LEN
+#define TSCH_LOG_BINARY_QUEUE_LEN TSCH_LOG_CONF_BINARY_QUEUE_LEN
+#else /* TSCH_LOG_CONF_BINARY_QUEUE_LEN */
+#define TSCH_LOG_BINARY_QUEUE_LEN 64
+#endif /* TSCH_LOG_CONF_BINARY_QUEUE_LEN */
+
+/* The max number of records per SLIP frame */
+#ifdef TSCH_LOG_CONF_BINARY_BATCH
+#define TSCH_LOG_BINARY_BATCH TSCH_LOG_CONF_BINARY_BATCH
+#else /* TSCH_LOG_CONF_BINARY_BATCH */
+#define TSCH_LOG_BINARY_BATCH 8
+#endif /* TSCH_LOG_CONF_BINARY_BATCH */
+
+/* Send a partial batch when the last frame is older than this */
+#ifdef TSCH_LOG_CONF_BINARY_FLUSH_INTERVAL
+#define TSCH_LOG_BINARY_FLUSH_INTERVAL TSCH_LOG_CONF_BINARY_FLUSH_INTERVAL
+#else /* TSCH_LOG_CONF_BINARY_FLUSH_INTERVAL */
+#define TSCH_LOG_BINARY_FLUSH_INTERVAL CLOCK_SECOND
+#endif /* TSCH_LOG_CONF_BINARY_FLUSH_INTERVAL */
+
+/* Write a byte of the binary stream, e.g. slip_arch_writeb on
+ * platforms where the UART is shared with SLIP */
+#ifdef TSCH_LOG_CONF_BINARY_WRITEB
+#define TSCH_LOG_BINARY_WRITEB(c) TSCH_LOG_CONF_BINARY_WRITEB(c)
+#else /* TSCH_LOG_CONF_BINARY_WRITEB */
+#define TSCH_LOG_BINARY_WRITEB(c) putchar(c)
+#endif /* TSCH_LOG_CONF_BINARY_WRITEB */
+
 #if TSCH_LOG_LEVEL < 2 /* For log level 0 or 1, the logging functions do nothing */
 
 #define tsch_log_init()
@@ -79,7 +117,8 @@
 struct tsch_log_t {
   enum { tsch_log_tx,
          tsch_log_rx,
-         tsch_log_message
+         tsch_log_message,
+         tsch_log_drop
   } type;
   struct tsch_asn_t asn;
   struct tsch_link *link;
@@ -90,6 +129,7 @@ struct tsch_log_t {
       int dest;
       int drift;
       uint8_t num_tx;
+      uint8_t seqno;
       uint8_t datalen;
       uint8_t is_data;
       uint8_t sec_level;
@@ -99,22 +139,31 @@ struct tsch_log_t {
       int src;
       int drift;
       int estimated_drift;
+      int16_t rssi;
+      uint8_t seqno;
       uint8_t datalen;
       uint8_t is_unicast;
       uint8_t is_data;
       uint8_t sec_level;
       uint8_t drift_used;
     } rx;
+    struct {
+      int dest;
+      uint16_t drop_count;
+      uint8_t traffic_class;
+      uint8_t queue_len;
+      uint8_t pool_free;
+    } drop;
   };
 };
 
 /********** Functions *********/
 
-/* Prepare addition of a new log.
+/* Prepare addition of a new log of the given type.
  * Returns pointer to log structure if success, NULL otherwise */
-struct tsch_log_t *tsch_log_prepare_add(void);
+struct tsch_log_t *tsch_log_prepare_add(int type);
 /* Actually add the previously prepared log */
-void tsch_log_commit(void);
+void tsch_log_commit(struct tsch_log_t *log);
 /* Initialize log module */
 void tsch_log_init(void);
 /* Process pending log messages */
@@ -125,11 +174,10 @@ void tsch_log_process_pending(void);
 /* Use this macro to add a log to the queue (will be printed out
  * later, after leaving interrupt context) */
 #define TSCH_LOG_ADD(log_type, init_code) do { \
-    struct tsch_log_t *log = tsch_log_prepare_add(); \
+    struct tsch_log_t *log = tsch_log_prepare_add(log_type); \
     if(log != NULL) { \
-      log->type = (log_type); \
       init_code; \
-      tsch_log_commit(); \
+      tsch_log_commit(log); \
     } \
 } while(0);
 
@@ -296,6 +296,31 @@ tsch_packet_update_eb(uint8_t *buf, int buf_size, uint8_t tsch_sync_ie_offset)
   return 1;
 }
 /*---------------------------------------------------------------------------*/
+/* Set frame pending bit in a packet (whose header was already built) */
+void
+tsch_packet_set_frame_pending(uint8_t *buf, int buf_size)
+{
+  if(buf_size > 0) {
+    buf[0] |= (1 << 4);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Clear frame pending bit in a packet (whose header was already built) */
+void
+tsch_packet_clear_frame_pending(uint8_t *buf, int buf_size)
+{
+  if(buf_size > 0) {
+    buf[0] &= ~(1 << 4);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Get frame pending bit from a packet */
+int
+tsch_packet_get_frame_pending(uint8_t *buf, int buf_size)
+{
+  return buf_size > 0 && ((buf[0] >> 4) & 1);
+}
+/*---------------------------------------------------------------------------*/
 /* Parse a IEEE 802.15.4e TSCH Enhanced Beacon (EB) */
 int
 tsch_packet_parse_eb(struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic)
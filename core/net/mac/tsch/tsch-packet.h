@@ -81,5 +81,11 @@ int tsch_packet_create_eb(uint8_t *hdr_len, uint8_t *tsch_sync_ie_ptr);
 int tsch_packet_update_eb(uint8_t *buf, int buf_size, uint8_t tsch_sync_ie_offset);
 /* Parse EB and extract ASN and join priority */
 int tsch_packet_parse_eb(struct ieee802154_ies *ies, uint8_t *hdrlen, int frame_without_mic);
+/* Set frame pending bit in a packet (whose header was already built) */
+void tsch_packet_set_frame_pending(uint8_t *buf, int buf_size);
+/* Clear frame pending bit in a packet (whose header was already built) */
+void tsch_packet_clear_frame_pending(uint8_t *buf, int buf_size);
+/* Get frame pending bit from a packet */
+int tsch_packet_get_frame_pending(uint8_t *buf, int buf_size);
 
 #endif /* __TSCH_PACKET_H__ */
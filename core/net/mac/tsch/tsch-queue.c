@@ -54,6 +54,9 @@
 #include "net/mac/tsch/tsch-schedule.h"
 #include "net/mac/tsch/tsch-slot-operation.h"
 #include "net/mac/tsch/tsch-log.h"
+#if TSCH_QUEUE_WITH_PRIORITIES && NETSTACK_CONF_WITH_IPV6
+#include "net/ipv6/uip-icmp6.h"
+#endif /* TSCH_QUEUE_WITH_PRIORITIES && NETSTACK_CONF_WITH_IPV6 */
 #include <string.h>
 
 #if TSCH_LOG_LEVEL >= 1
@@ -68,6 +71,10 @@
 #error TSCH_QUEUE_NUM_PER_NEIGHBOR must be power of two
 #endif
 
+#if TSCH_QUEUE_CONTROL_RESERVE >= QUEUEBUF_NUM
+#error TSCH_QUEUE_CONTROL_RESERVE must be smaller than QUEUEBUF_NUM
+#endif
+
 /* We have as many packets are there are queuebuf in the system */
 MEMB(packet_memb, struct tsch_packet, QUEUEBUF_NUM);
 MEMB(neighbor_memb, struct tsch_neighbor, TSCH_QUEUE_MAX_NEIGHBOR_QUEUES);
@@ -77,6 +84,9 @@ LIST(neighbor_list);
 struct tsch_neighbor *n_broadcast;
 struct tsch_neighbor *n_eb;
 
+/* Number of packets dropped at enqueue time, per traffic class */
+static uint16_t drop_count[TSCH_QUEUE_NUM_CLASSES];
+
 /*---------------------------------------------------------------------------*/
 /* Add a TSCH neighbor */
 struct tsch_neighbor *
@@ -91,8 +101,11 @@ tsch_queue_add_nbr(const linkaddr_t *addr)
       n = memb_alloc(&neighbor_memb);
       if(n != NULL) {
         /* Initialize neighbor entry */
+        int i;
         memset(n, 0, sizeof(struct tsch_neighbor));
-        ringbufindex_init(&n->tx_ringbuf, TSCH_QUEUE_NUM_PER_NEIGHBOR);
+        for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+          ringbufindex_init(&n->tx_ringbuf[i], TSCH_QUEUE_NUM_PER_NEIGHBOR);
+        }
         linkaddr_copy(&n->addr, addr);
         n->is_broadcast = linkaddr_cmp(addr, &tsch_eb_address)
           || linkaddr_cmp(addr, &tsch_broadcast_address);
@@ -227,6 +240,56 @@ tsch_queue_remove_nbr(struct tsch_neighbor *n)
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Traffic class of the packet in packetbuf, to be sent to addr */
+static uint8_t
+get_traffic_class(const linkaddr_t *addr)
+{
+#if TSCH_QUEUE_WITH_PRIORITIES
+  /* EBs and keepalives (empty frames) */
+  if(linkaddr_cmp(addr, &tsch_eb_address) || packetbuf_datalen() == 0) {
+    return TSCH_QUEUE_CLASS_CONTROL;
+  }
+#if NETSTACK_CONF_WITH_IPV6
+  /* ICMPv6 other than echo, i.e. RPL and ND. sicslowpan sets the ICMPv6
+   * type of every packet it sends, or 0 if it is not ICMPv6 */
+  {
+    uint8_t icmp6_type = packetbuf_attr(PACKETBUF_ATTR_ICMP6_TYPE);
+    if(icmp6_type != 0
+       && icmp6_type != ICMP6_ECHO_REQUEST && icmp6_type != ICMP6_ECHO_REPLY) {
+      return TSCH_QUEUE_CLASS_CONTROL;
+    }
+  }
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+#endif /* TSCH_QUEUE_WITH_PRIORITIES */
+  return TSCH_QUEUE_CLASS_DATA;
+}
+/*---------------------------------------------------------------------------*/
+/* Is there room in the shared packet pool for a new packet of a given
+ * class to neighbor n? */
+static int
+pool_has_room(const struct tsch_neighbor *n, uint8_t traffic_class)
+{
+  int num_free = memb_numfree(&packet_memb);
+#if TSCH_QUEUE_WITH_PRIORITIES
+  if(traffic_class == TSCH_QUEUE_CLASS_CONTROL) {
+    return num_free > 0;
+  }
+  /* Leave the reserved packets to control traffic */
+  num_free -= TSCH_QUEUE_CONTROL_RESERVE;
+#endif /* TSCH_QUEUE_WITH_PRIORITIES */
+  if(num_free <= 0) {
+    return 0;
+  }
+#if TSCH_QUEUE_NBR_SOFT_LIMIT
+  /* Above its soft limit, a neighbor may only use the first half of the pool */
+  if(ringbufindex_elements(&n->tx_ringbuf[traffic_class]) >= TSCH_QUEUE_NBR_SOFT_LIMIT
+     && num_free <= (QUEUEBUF_NUM - TSCH_QUEUE_CONTROL_RESERVE) / 2) {
+    return 0;
+  }
+#endif /* TSCH_QUEUE_NBR_SOFT_LIMIT */
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 /* Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic) */
 struct tsch_packet *
 tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
@@ -234,11 +297,12 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
   struct tsch_neighbor *n = NULL;
   int16_t put_index = -1;
   struct tsch_packet *p = NULL;
+  uint8_t traffic_class = get_traffic_class(addr);
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      put_index = ringbufindex_peek_put(&n->tx_ringbuf);
-      if(put_index != -1) {
+      put_index = ringbufindex_peek_put(&n->tx_ringbuf[traffic_class]);
+      if(put_index != -1 && pool_has_room(n, traffic_class)) {
         p = memb_alloc(&packet_memb);
         if(p != NULL) {
           /* Enqueue packet */
@@ -251,11 +315,12 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
             p->ptr = ptr;
             p->ret = MAC_TX_DEFERRED;
             p->transmissions = 0;
+            p->traffic_class = traffic_class;
             /* Add to ringbuf (actual add committed through atomic operation) */
-            n->tx_array[put_index] = p;
-            ringbufindex_put(&n->tx_ringbuf);
-            PRINTF("TSCH-queue: packet is added put_index=%u, packet=%p\n",
-                   put_index, p);
+            n->tx_array[traffic_class][put_index] = p;
+            ringbufindex_put(&n->tx_ringbuf[traffic_class]);
+            PRINTF("TSCH-queue: packet is added put_index=%u, class=%u, packet=%p\n",
+                   put_index, traffic_class, p);
             return p;
           } else {
             memb_free(&packet_memb, p);
@@ -265,6 +330,14 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
     }
   }
   PRINTF("TSCH-queue:! add packet failed: %u %p %d %p %p\n", tsch_is_locked(), n, put_index, p, p ? p->qb : NULL);
+  drop_count[traffic_class]++;
+  TSCH_LOG_ADD(tsch_log_drop,
+      log->drop.dest = TSCH_LOG_ID_FROM_LINKADDR(addr);
+      log->drop.traffic_class = traffic_class;
+      log->drop.queue_len = n != NULL ? tsch_queue_nbr_packet_count(n) : 0;
+      log->drop.pool_free = memb_numfree(&packet_memb);
+      log->drop.drop_count = drop_count[traffic_class];
+  );
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -276,31 +349,76 @@ tsch_queue_packet_count(const linkaddr_t *addr)
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      return ringbufindex_elements(&n->tx_ringbuf);
+      return tsch_queue_nbr_packet_count(n);
     }
   }
   return -1;
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the number of packets in all queues of a neighbor */
+int
+tsch_queue_nbr_packet_count(const struct tsch_neighbor *n)
+{
+  int i;
+  int count = 0;
+  for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+    count += ringbufindex_elements(&n->tx_ringbuf[i]);
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the number of packets dropped so far for a traffic class */
+uint16_t
+tsch_queue_drop_count(uint8_t traffic_class)
+{
+  return traffic_class < TSCH_QUEUE_NUM_CLASSES ? drop_count[traffic_class] : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Remove first packet from a given class queue of a neighbor */
+static struct tsch_packet *
+remove_packet_from_class(struct tsch_neighbor *n, uint8_t traffic_class)
+{
+  /* Get and remove packet from ringbuf (remove committed through an atomic operation */
+  int16_t get_index = ringbufindex_get(&n->tx_ringbuf[traffic_class]);
+  if(get_index != -1) {
+    PRINTF("TSCH-queue: packet is removed, get_index=%u, class=%u\n", get_index, traffic_class);
+    return n->tx_array[traffic_class][get_index];
+  } else {
+    return NULL;
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* Remove first packet from a neighbor queue */
 struct tsch_packet *
 tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n)
 {
   if(!tsch_is_locked()) {
     if(n != NULL) {
-      /* Get and remove packet from ringbuf (remove committed through an atomic operation */
-      int16_t get_index = ringbufindex_get(&n->tx_ringbuf);
-      if(get_index != -1) {
-        PRINTF("TSCH-queue: packet is removed, get_index=%u\n", get_index);
-        return n->tx_array[get_index];
-      } else {
-        return NULL;
+      int i;
+      for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+        if(!ringbufindex_empty(&n->tx_ringbuf[i])) {
+          return remove_packet_from_class(n, i);
+        }
       }
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Remove a given packet from the head of its neighbor queue. A packet of
+ * higher priority may have been added since p was selected for transmission,
+ * so we look up the queue from the packet's class. */
+struct tsch_packet *
+tsch_queue_remove_packet(struct tsch_neighbor *n, struct tsch_packet *p)
+{
+  if(!tsch_is_locked()) {
+    if(n != NULL && p != NULL) {
+      return remove_packet_from_class(n, p->traffic_class);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 /* Free a packet */
 void
 tsch_queue_free_packet(struct tsch_packet *p)
@@ -353,31 +471,47 @@ tsch_queue_free_unused_neighbors(void)
 int
 tsch_queue_is_empty(const struct tsch_neighbor *n)
 {
-  return !tsch_is_locked() && n != NULL && ringbufindex_empty(&n->tx_ringbuf);
+  return !tsch_is_locked() && n != NULL && tsch_queue_nbr_packet_count(n) == 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the first packet from a given class queue of a neighbor */
+static struct tsch_packet *
+get_packet_for_nbr_class(const struct tsch_neighbor *n, struct tsch_link *link,
+                         uint8_t traffic_class)
+{
+  int is_shared_link = link != NULL && link->link_options & LINK_OPTION_SHARED;
+  int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf[traffic_class]);
+  if(get_index != -1 &&
+      !(is_shared_link && !tsch_queue_backoff_expired(n))) {    /* If this is a shared link,
+                                                                make sure the backoff has expired */
+    struct tsch_packet *p = n->tx_array[traffic_class][get_index];
+#if TSCH_WITH_LINK_SELECTOR
+    int packet_attr_slotframe = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
+    int packet_attr_timeslot = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_TIMESLOT);
+    if(packet_attr_slotframe != 0xffff && packet_attr_slotframe != link->slotframe_handle) {
+      return NULL;
+    }
+    if(packet_attr_timeslot != 0xffff && packet_attr_timeslot != link->timeslot) {
+      return NULL;
+    }
+#endif
+    return p;
+  }
+  return NULL;
 }
 /*---------------------------------------------------------------------------*/
-/* Returns the first packet from a neighbor queue */
+/* Returns the first packet from a neighbor queue, highest priority first */
 struct tsch_packet *
 tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, struct tsch_link *link)
 {
   if(!tsch_is_locked()) {
-    int is_shared_link = link != NULL && link->link_options & LINK_OPTION_SHARED;
     if(n != NULL) {
-      int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf);
-      if(get_index != -1 &&
-          !(is_shared_link && !tsch_queue_backoff_expired(n))) {    /* If this is a shared link,
-                                                                    make sure the backoff has expired */
-#if TSCH_WITH_LINK_SELECTOR
-        int packet_attr_slotframe = queuebuf_attr(n->tx_array[get_index]->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
-        int packet_attr_timeslot = queuebuf_attr(n->tx_array[get_index]->qb, PACKETBUF_ATTR_TSCH_TIMESLOT);
-        if(packet_attr_slotframe != 0xffff && packet_attr_slotframe != link->slotframe_handle) {
-          return NULL;
-        }
-        if(packet_attr_timeslot != 0xffff && packet_attr_timeslot != link->timeslot) {
-          return NULL;
+      int i;
+      for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+        struct tsch_packet *p = get_packet_for_nbr_class(n, link, i);
+        if(p != NULL) {
+          return p;
         }
-#endif
-        return n->tx_array[get_index];
       }
     }
   }
@@ -400,20 +534,25 @@ struct tsch_packet *
 tsch_queue_get_unicast_packet_for_any(struct tsch_neighbor **n, struct tsch_link *link)
 {
   if(!tsch_is_locked()) {
-    struct tsch_neighbor *curr_nbr = list_head(neighbor_list);
-    struct tsch_packet *p = NULL;
-    while(curr_nbr != NULL) {
-      if(!curr_nbr->is_broadcast && curr_nbr->tx_links_count == 0) {
-        /* Only look up for non-broadcast neighbors we do not have a tx link to */
-        p = tsch_queue_get_packet_for_nbr(curr_nbr, link);
-        if(p != NULL) {
-          if(n != NULL) {
-            *n = curr_nbr;
+    int i;
+    /* Look up all neighbors for a packet of a class before moving
+     * on to the next (lower priority) class */
+    for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+      struct tsch_neighbor *curr_nbr = list_head(neighbor_list);
+      struct tsch_packet *p = NULL;
+      while(curr_nbr != NULL) {
+        if(!curr_nbr->is_broadcast && curr_nbr->tx_links_count == 0) {
+          /* Only look up for non-broadcast neighbors we do not have a tx link to */
+          p = get_packet_for_nbr_class(curr_nbr, link, i);
+          if(p != NULL) {
+            if(n != NULL) {
+              *n = curr_nbr;
+            }
+            return p;
           }
-          return p;
         }
+        curr_nbr = list_item_next(curr_nbr);
       }
-      curr_nbr = list_item_next(curr_nbr);
     }
   }
   return NULL;
@@ -474,6 +613,7 @@ tsch_queue_init(void)
   list_init(neighbor_list);
   memb_init(&neighbor_memb);
   memb_init(&packet_memb);
+  memset(drop_count, 0, sizeof(drop_count));
   /* Add virtual EB and the broadcast neighbors */
   n_eb = tsch_queue_add_nbr(&tsch_eb_address);
   n_broadcast = tsch_queue_add_nbr(&tsch_broadcast_address);
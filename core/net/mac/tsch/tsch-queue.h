@@ -77,6 +77,34 @@
 #define TSCH_QUEUE_MAX_NEIGHBOR_QUEUES ((NBR_TABLE_CONF_MAX_NEIGHBORS) + 2)
 #endif
 
+/* Separate control traffic (EBs, keepalives and ICMPv6 other than echo,
+ * i.e. RPL and ND) from data traffic. Each neighbor then has one queue per
+ * traffic class, and control packets are sent ahead of any queued data */
+#ifdef TSCH_QUEUE_CONF_WITH_PRIORITIES
+#define TSCH_QUEUE_WITH_PRIORITIES TSCH_QUEUE_CONF_WITH_PRIORITIES
+#else
+#define TSCH_QUEUE_WITH_PRIORITIES 0
+#endif
+
+/* The number of packets of the shared packet pool that only control
+ * traffic may use (with TSCH_QUEUE_WITH_PRIORITIES only) */
+#if !TSCH_QUEUE_WITH_PRIORITIES
+#define TSCH_QUEUE_CONTROL_RESERVE 0
+#elif defined(TSCH_QUEUE_CONF_CONTROL_RESERVE)
+#define TSCH_QUEUE_CONTROL_RESERVE TSCH_QUEUE_CONF_CONTROL_RESERVE
+#else
+#define TSCH_QUEUE_CONTROL_RESERVE 1
+#endif
+
+/* Per-neighbor soft limit on the number of queued data packets. A neighbor
+ * above its soft limit may queue more data packets only as long as less than
+ * half of the shared packet pool is in use. 0 disables the limit */
+#ifdef TSCH_QUEUE_CONF_NBR_SOFT_LIMIT
+#define TSCH_QUEUE_NBR_SOFT_LIMIT TSCH_QUEUE_CONF_NBR_SOFT_LIMIT
+#else
+#define TSCH_QUEUE_NBR_SOFT_LIMIT 0
+#endif
+
 /* TSCH CSMA-CA parameters, see IEEE 802.15.4e-2012 */
 /* Min backoff exponent */
 #ifdef TSCH_CONF_MAC_MIN_BE
@@ -112,6 +140,20 @@ void TSCH_CALLBACK_PACKET_READY(void);
 
 /************ Types ***********/
 
+/* Traffic classes, by decreasing priority */
+enum tsch_queue_class {
+#if TSCH_QUEUE_WITH_PRIORITIES
+  TSCH_QUEUE_CLASS_CONTROL,
+#endif /* TSCH_QUEUE_WITH_PRIORITIES */
+  TSCH_QUEUE_CLASS_DATA,
+  TSCH_QUEUE_NUM_CLASSES
+};
+
+#if !TSCH_QUEUE_WITH_PRIORITIES
+/* Without priorities, control traffic shares the data queue */
+#define TSCH_QUEUE_CLASS_CONTROL TSCH_QUEUE_CLASS_DATA
+#endif /* !TSCH_QUEUE_WITH_PRIORITIES */
+
 /* TSCH packet information */
 struct tsch_packet {
   struct queuebuf *qb;  /* pointer to the queuebuf to be sent */
@@ -121,6 +163,7 @@ struct tsch_packet {
   uint8_t ret; /* status -- MAC return code */
   uint8_t header_len; /* length of header and header IEs (needed for link-layer security) */
   uint8_t tsch_sync_ie_offset; /* Offset within the frame used for quick update of EB ASN and join priority */
+  uint8_t traffic_class; /* The class, and thus queue, the packet belongs to */
 };
 
 /* TSCH neighbor information */
@@ -135,11 +178,11 @@ struct tsch_neighbor {
   uint8_t last_backoff_window; /* Last CSMA backoff window */
   uint8_t tx_links_count; /* How many links do we have to this neighbor? */
   uint8_t dedicated_tx_links_count; /* How many dedicated links do we have to this neighbor? */
-  /* Array for the ringbuf. Contains pointers to packets.
-   * Its size must be a power of two to allow for atomic put */
-  struct tsch_packet *tx_array[TSCH_QUEUE_NUM_PER_NEIGHBOR];
-  /* Circular buffer of pointers to packet. */
-  struct ringbufindex tx_ringbuf;
+  /* Arrays for the ringbufs, one per traffic class. Contain pointers to packets.
+   * Their size must be a power of two to allow for atomic put */
+  struct tsch_packet *tx_array[TSCH_QUEUE_NUM_CLASSES][TSCH_QUEUE_NUM_PER_NEIGHBOR];
+  /* Circular buffers of pointers to packet, one per traffic class. */
+  struct ringbufindex tx_ringbuf[TSCH_QUEUE_NUM_CLASSES];
 };
 
 /***** External Variables *****/
@@ -162,9 +205,16 @@ int tsch_queue_update_time_source(const linkaddr_t *new_addr);
 struct tsch_packet *tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr);
 /* Returns the number of packets currently a given neighbor queue */
 int tsch_queue_packet_count(const linkaddr_t *addr);
+/* Returns the number of packets in all queues of a neighbor */
+int tsch_queue_nbr_packet_count(const struct tsch_neighbor *n);
+/* Returns the number of packets dropped so far for a traffic class */
+uint16_t tsch_queue_drop_count(uint8_t traffic_class);
 /* Remove first packet from a neighbor queue. The packet is stored in a separate
  * dequeued packet list, for later processing. Return the packet. */
 struct tsch_packet *tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n);
+/* Remove a given packet, as returned by tsch_queue_get_packet_for_nbr, from
+ * the head of its neighbor queue. Return the packet. */
+struct tsch_packet *tsch_queue_remove_packet(struct tsch_neighbor *n, struct tsch_packet *p);
 /* Free a packet */
 void tsch_queue_free_packet(struct tsch_packet *p);
 /* Reset neighbor queues */
@@ -69,6 +69,81 @@ MEMB(slotframe_memb, struct tsch_slotframe, TSCH_SCHEDULE_MAX_SLOTFRAMES);
 /* List of slotframes (each slotframe holds its own list of links) */
 LIST(slotframe_list);
 
+#if TSCH_SCHEDULE_COMPILED
+/* The links of all slotframes, grouped by slotframe in the order of
+ * slotframe_list and sorted by timeslot within each group. Updated
+ * along with the link lists, under the TSCH lock. */
+static struct tsch_link *compiled_links[TSCH_SCHEDULE_MAX_LINKS];
+static uint16_t compiled_num;
+
+/*---------------------------------------------------------------------------*/
+/* Returns the position of the first link of a slotframe with a timeslot
+ * greater than or equal to the one given, or the end of the slotframe's
+ * group if there is none */
+static uint16_t
+compiled_search(const struct tsch_slotframe *sf, uint32_t timeslot)
+{
+  uint16_t lo = sf->compiled_first;
+  uint16_t hi = sf->compiled_first + sf->compiled_count;
+  while(lo < hi) {
+    uint16_t mid = lo + (hi - lo) / 2;
+    if(compiled_links[mid]->timeslot < timeslot) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+/*---------------------------------------------------------------------------*/
+static void
+compiled_add(struct tsch_slotframe *sf, struct tsch_link *l)
+{
+  uint16_t pos = compiled_search(sf, l->timeslot);
+  memmove(&compiled_links[pos + 1], &compiled_links[pos],
+          (compiled_num - pos) * sizeof(struct tsch_link *));
+  compiled_links[pos] = l;
+  compiled_num++;
+  sf->compiled_count++;
+  /* Later slotframes have moved up by one */
+  for(sf = list_item_next(sf); sf != NULL; sf = list_item_next(sf)) {
+    sf->compiled_first++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+compiled_remove(struct tsch_slotframe *sf, struct tsch_link *l)
+{
+  uint16_t pos = compiled_search(sf, l->timeslot);
+  if(pos == sf->compiled_first + sf->compiled_count || compiled_links[pos] != l) {
+    return;
+  }
+  compiled_num--;
+  memmove(&compiled_links[pos], &compiled_links[pos + 1],
+          (compiled_num - pos) * sizeof(struct tsch_link *));
+  sf->compiled_count--;
+  for(sf = list_item_next(sf); sf != NULL; sf = list_item_next(sf)) {
+    sf->compiled_first--;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the link of a slotframe that comes first after a timeslot,
+ * wrapping around to the start of the slotframe */
+static struct tsch_link *
+compiled_next_link(const struct tsch_slotframe *sf, uint16_t timeslot)
+{
+  uint16_t pos;
+  if(sf->compiled_count == 0) {
+    return NULL;
+  }
+  pos = compiled_search(sf, (uint32_t)timeslot + 1);
+  if(pos == sf->compiled_first + sf->compiled_count) {
+    pos = sf->compiled_first;
+  }
+  return compiled_links[pos];
+}
+#endif /* TSCH_SCHEDULE_COMPILED */
+
 /* Adds and returns a slotframe (NULL if failure) */
 struct tsch_slotframe *
 tsch_schedule_add_slotframe(uint16_t handle, uint16_t size)
@@ -89,6 +164,11 @@ tsch_schedule_add_slotframe(uint16_t handle, uint16_t size)
       sf->handle = handle;
       TSCH_ASN_DIVISOR_INIT(sf->size, size);
       LIST_STRUCT_INIT(sf, links_list);
+#if TSCH_SCHEDULE_COMPILED
+      /* New slotframes go last, so their links go at the end */
+      sf->compiled_first = compiled_num;
+      sf->compiled_count = 0;
+#endif /* TSCH_SCHEDULE_COMPILED */
       /* Add the slotframe to the global list */
       list_add(slotframe_list, sf);
     }
@@ -209,6 +289,9 @@ tsch_schedule_add_link(struct tsch_slotframe *slotframe,
           address = &linkaddr_null;
         }
         linkaddr_copy(&l->addr, address);
+#if TSCH_SCHEDULE_COMPILED
+        compiled_add(slotframe, l);
+#endif /* TSCH_SCHEDULE_COMPILED */
 
         PRINTF("TSCH-schedule: add_link %u %u %u %u %u %u\n",
                slotframe->handle, link_options, link_type, timeslot, channel_offset, TSCH_LOG_ID_FROM_LINKADDR(address));
@@ -256,6 +339,9 @@ tsch_schedule_remove_link(struct tsch_slotframe *slotframe, struct tsch_link *l)
              TSCH_LOG_ID_FROM_LINKADDR(&l->addr));
 
       list_remove(slotframe->links_list, l);
+#if TSCH_SCHEDULE_COMPILED
+      compiled_remove(slotframe, l);
+#endif /* TSCH_SCHEDULE_COMPILED */
       memb_free(&link_memb, l);
 
       /* Release the lock before we update the neighbor (will take the lock) */
@@ -294,6 +380,14 @@ tsch_schedule_get_link_by_timeslot(struct tsch_slotframe *slotframe, uint16_t ti
 {
   if(!tsch_is_locked()) {
     if(slotframe != NULL) {
+#if TSCH_SCHEDULE_COMPILED
+      uint16_t pos = compiled_search(slotframe, timeslot);
+      if(pos < slotframe->compiled_first + slotframe->compiled_count
+         && compiled_links[pos]->timeslot == timeslot) {
+        return compiled_links[pos];
+      }
+      return NULL;
+#else /* TSCH_SCHEDULE_COMPILED */
       struct tsch_link *l = list_head(slotframe->links_list);
       /* Loop over all items. Assume there is max one link per timeslot */
       while(l != NULL) {
@@ -303,6 +397,7 @@ tsch_schedule_get_link_by_timeslot(struct tsch_slotframe *slotframe, uint16_t ti
         l = list_item_next(l);
       }
       return l;
+#endif /* TSCH_SCHEDULE_COMPILED */
     }
   }
   return NULL;
@@ -325,7 +420,13 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
     while(sf != NULL) {
       /* Get timeslot from ASN, given the slotframe length */
       uint16_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
+#if TSCH_SCHEDULE_COMPILED
+      /* There is at most one link per timeslot in a slotframe, so only
+       * the first one after the current timeslot can be the earliest */
+      struct tsch_link *l = compiled_next_link(sf, timeslot);
+#else /* TSCH_SCHEDULE_COMPILED */
       struct tsch_link *l = list_head(sf->links_list);
+#endif /* TSCH_SCHEDULE_COMPILED */
       while(l != NULL) {
         uint16_t time_to_timeslot =
           l->timeslot > timeslot ?
@@ -369,7 +470,11 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
           }
         }
 
+#if TSCH_SCHEDULE_COMPILED
+        l = NULL;
+#else /* TSCH_SCHEDULE_COMPILED */
         l = list_item_next(l);
+#endif /* TSCH_SCHEDULE_COMPILED */
       }
       sf = list_item_next(sf);
     }
@@ -391,6 +496,9 @@ tsch_schedule_init(void)
     memb_init(&link_memb);
     memb_init(&slotframe_memb);
     list_init(slotframe_list);
+#if TSCH_SCHEDULE_COMPILED
+    compiled_num = 0;
+#endif /* TSCH_SCHEDULE_COMPILED */
     tsch_release_lock();
     return 1;
   } else {
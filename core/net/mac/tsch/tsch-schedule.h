@@ -72,6 +72,16 @@
 #define TSCH_SCHEDULE_MAX_LINKS 32
 #endif
 
+/* Keep the links of each slotframe in an array sorted by timeslot, so
+ * that finding the next active link is a binary search per slotframe
+ * rather than a walk over all links. Costs TSCH_SCHEDULE_MAX_LINKS
+ * pointers of RAM. */
+#ifdef TSCH_SCHEDULE_CONF_COMPILED
+#define TSCH_SCHEDULE_COMPILED TSCH_SCHEDULE_CONF_COMPILED
+#else
+#define TSCH_SCHEDULE_COMPILED 0
+#endif
+
 /********** Constants *********/
 
 /* Link options */
@@ -122,6 +132,12 @@ struct tsch_slotframe {
   struct tsch_asn_divisor_t size;
   /* List of links belonging to this slotframe */
   LIST_STRUCT(links_list);
+#if TSCH_SCHEDULE_COMPILED
+  /* Position and number of the links of this slotframe in the
+   * timeslot-sorted link array */
+  uint16_t compiled_first;
+  uint16_t compiled_count;
+#endif /* TSCH_SCHEDULE_COMPILED */
 };
 
 /********** Functions *********/
@@ -174,6 +174,21 @@ static struct tsch_link *backup_link = NULL;
 static struct tsch_packet *current_packet = NULL;
 static struct tsch_neighbor *current_neighbor = NULL;
 
+#if TSCH_BURST_MAX_LEN > 0
+/* Roles of this node in a burst */
+enum tsch_burst_role {
+  TSCH_BURST_NONE,
+  TSCH_BURST_TX,
+  TSCH_BURST_RX,
+};
+/* Role of this node in the burst scheduled for the next timeslot, if any */
+static uint8_t burst_link_scheduled = TSCH_BURST_NONE;
+/* Role of this node in the burst of the current timeslot, if any */
+static uint8_t burst_link_current = TSCH_BURST_NONE;
+/* Number of timeslots added to the current burst so far */
+static uint8_t tsch_current_burst_count = 0;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+
 /* Protothread for association */
 PT_THREAD(tsch_scan(struct pt *pt));
 /* Protothread for slot operation, called from rtimer interrupt
@@ -382,7 +397,7 @@ update_neighbor_state(struct tsch_neighbor *n, struct tsch_packet *p,
 
   if(mac_tx_status == MAC_TX_OK) {
     /* Successful transmission */
-    tsch_queue_remove_packet_from_queue(n);
+    tsch_queue_remove_packet(n, p);
     in_queue = 0;
 
     /* Update CSMA state in the unicast case */
@@ -397,7 +412,7 @@ update_neighbor_state(struct tsch_neighbor *n, struct tsch_packet *p,
     /* Failed transmission */
     if(p->transmissions >= TSCH_MAC_MAX_FRAME_RETRIES + 1) {
       /* Drop packet */
-      tsch_queue_remove_packet_from_queue(n);
+      tsch_queue_remove_packet(n, p);
       in_queue = 0;
     }
     /* Update CSMA state in the unicast case */
@@ -525,6 +540,9 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
 #if CCA_ENABLED
       static uint8_t cca_status;
 #endif
+#if TSCH_BURST_MAX_LEN > 0
+      static uint8_t burst_link_requested;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
 
       /* get payload */
       enable_local_packetbuf();
@@ -542,6 +560,22 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
         packet_ready = 1;
       }
 
+#if TSCH_BURST_MAX_LEN > 0
+      /* If more unicast packets are queued for this neighbor, and the burst
+       * is not at its max length yet, set the frame pending bit to request
+       * a burst slot. Otherwise clear it, as it may be left over from a
+       * previous attempt. Must be done before securing the frame. */
+      burst_link_requested = 0;
+      if(!is_broadcast
+         && tsch_current_burst_count + 1 < TSCH_BURST_MAX_LEN
+         && tsch_queue_nbr_packet_count(current_neighbor) > 1) {
+        burst_link_requested = 1;
+        tsch_packet_set_frame_pending(packet, packet_len);
+      } else {
+        tsch_packet_clear_frame_pending(packet, packet_len);
+      }
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+
 #if LLSEC802154_ENABLED
       if(tsch_is_pan_secured) {
         /* If we are going to encrypt, we need to generate the output in a separate buffer and keep
@@ -685,6 +719,13 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
                   tsch_schedule_keepalive();
                 }
                 mac_tx_status = MAC_TX_OK;
+#if TSCH_BURST_MAX_LEN > 0
+                /* The neighbor acked a frame with frame pending set:
+                 * keep on transmitting in the next timeslot */
+                if(burst_link_requested) {
+                  burst_link_scheduled = TSCH_BURST_TX;
+                }
+#endif /* TSCH_BURST_MAX_LEN > 0 */
               } else {
                 mac_tx_status = MAC_TX_NOACK;
               }
@@ -726,6 +767,7 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
     log->tx.sec_level = 0;
 #endif /* LLSEC802154_ENABLED */
     log->tx.dest = TSCH_LOG_ID_FROM_LINKADDR(queuebuf_addr(current_packet->qb, PACKETBUF_ADDR_RECEIVER));
+    log->tx.seqno = queuebuf_attr(current_packet->qb, PACKETBUF_ATTR_MAC_SEQNO);
     );
 
     /* Poll process for later processing of packet sent events and logs */
@@ -875,6 +917,28 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
             }
 #endif
 
+#if TSCH_LOG_BINARY
+            /* In binary mode, log every reception. Do it before the ACK
+             * overwrites packetbuf */
+            TSCH_LOG_ADD(tsch_log_rx,
+                n = tsch_queue_get_nbr(&source_address);
+                log->rx.src = TSCH_LOG_ID_FROM_LINKADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+                log->rx.is_unicast = packetbuf_attr(PACKETBUF_ATTR_MAC_ACK);
+                log->rx.datalen = current_input->len;
+                log->rx.seqno = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+                log->rx.rssi = current_input->rssi;
+                log->rx.drift = -estimated_drift;
+                log->rx.drift_used = n != NULL && n->is_time_source;
+                log->rx.estimated_drift = estimated_drift;
+                log->rx.is_data = packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) == FRAME802154_DATAFRAME;
+#if LLSEC802154_ENABLED
+                log->rx.sec_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
+#else /* LLSEC802154_ENABLED */
+                log->rx.sec_level = 0;
+#endif /* LLSEC802154_ENABLED */
+            );
+#endif /* TSCH_LOG_BINARY */
+
             if(packetbuf_attr(PACKETBUF_ATTR_MAC_ACK)) {
               static uint8_t *ack_buf;
               static int ack_len;
@@ -900,6 +964,14 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
                 TSCH_DEBUG_RX_EVENT();
                 NETSTACK_RADIO.transmit(ack_len);
                 tsch_radio_off(TSCH_RADIO_CMD_OFF_WITHIN_TIMESLOT);
+
+#if TSCH_BURST_MAX_LEN > 0
+                /* The sender has more packets for us: stay on this link and
+                 * channel to receive them in the next timeslot */
+                if(tsch_packet_get_frame_pending(current_input->payload, current_input->len)) {
+                  burst_link_scheduled = TSCH_BURST_RX;
+                }
+#endif /* TSCH_BURST_MAX_LEN > 0 */
               }
             }
 
@@ -972,18 +1044,31 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
       /* Reset drift correction */
       drift_correction = 0;
       is_drift_correction_used = 0;
-      /* Get a packet ready to be sent */
-      current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
-      /* There is no packet to send, and this link does not have Rx flag. Instead of doing
-       * nothing, switch to the backup link (has Rx flag) if any. */
-      if(current_packet == NULL && !(current_link->link_options & LINK_OPTION_RX) && backup_link != NULL) {
-        current_link = backup_link;
+#if TSCH_BURST_MAX_LEN > 0
+      if(burst_link_current != TSCH_BURST_NONE) {
+        /* Burst slot: transmit the next packet to the same neighbor, or
+         * listen to the same neighbor. Keep the link and the channel. */
+        current_packet = NULL;
+        if(burst_link_current == TSCH_BURST_TX) {
+          current_packet = tsch_queue_get_packet_for_nbr(current_neighbor, current_link);
+        }
+        is_active_slot = current_packet != NULL || burst_link_current == TSCH_BURST_RX;
+      } else
+#endif /* TSCH_BURST_MAX_LEN > 0 */
+      {
+        /* Get a packet ready to be sent */
         current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
-      }
-      is_active_slot = current_packet != NULL || (current_link->link_options & LINK_OPTION_RX);
-      if(is_active_slot) {
+        /* There is no packet to send, and this link does not have Rx flag. Instead of doing
+         * nothing, switch to the backup link (has Rx flag) if any. */
+        if(current_packet == NULL && !(current_link->link_options & LINK_OPTION_RX) && backup_link != NULL) {
+          current_link = backup_link;
+          current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
+        }
+        is_active_slot = current_packet != NULL || (current_link->link_options & LINK_OPTION_RX);
         /* Hop channel */
         current_channel = tsch_calculate_channel(&tsch_current_asn, current_link->channel_offset);
+      }
+      if(is_active_slot) {
         NETSTACK_RADIO.set_value(RADIO_PARAM_CHANNEL, current_channel);
         /* Turn the radio on already here if configured so; necessary for radios with slow startup */
         tsch_radio_on(TSCH_RADIO_CMD_ON_START_OF_TIMESLOT);
@@ -1035,6 +1120,18 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
           tsch_queue_update_all_backoff_windows(&current_link->addr);
         }
 
+#if TSCH_BURST_MAX_LEN > 0
+        if(burst_link_scheduled != TSCH_BURST_NONE && current_link != NULL) {
+          /* A burst was agreed on in this timeslot: use the very next timeslot,
+           * with the same link and channel */
+          burst_link_current = burst_link_scheduled;
+          tsch_current_burst_count++;
+          timeslot_diff = 1;
+          backup_link = NULL;
+        } else {
+          burst_link_current = TSCH_BURST_NONE;
+          tsch_current_burst_count = 0;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
         /* Get next active link */
         current_link = tsch_schedule_get_next_active_link(&tsch_current_asn, &timeslot_diff, &backup_link);
         if(current_link == NULL) {
@@ -1042,6 +1139,10 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
            * behavior: wake up at the next slot. */
           timeslot_diff = 1;
         }
+#if TSCH_BURST_MAX_LEN > 0
+        }
+        burst_link_scheduled = TSCH_BURST_NONE;
+#endif /* TSCH_BURST_MAX_LEN > 0 */
         /* Update ASN */
         TSCH_ASN_INC(tsch_current_asn, timeslot_diff);
         /* Time to next wake up */
@@ -38,6 +38,7 @@
 #include <string.h>
 #include "lib/memb.h"
 #include "lib/list.h"
+#include "lib/hash-index.h"
 #include "net/nbr-table.h"
 
 #define DEBUG 0
@@ -86,6 +87,15 @@ static unsigned num_tables;
 MEMB(neighbor_addr_mem, nbr_table_key_t, NBR_TABLE_MAX_NEIGHBORS);
 LIST(nbr_table_keys);
 
+#if NBR_TABLE_WITH_HASH
+#if NBR_TABLE_HASH_SIZE <= NBR_TABLE_MAX_NEIGHBORS
+#error "NBR_TABLE_HASH_SIZE must be larger than NBR_TABLE_MAX_NEIGHBORS"
+#endif /* NBR_TABLE_HASH_SIZE <= NBR_TABLE_MAX_NEIGHBORS */
+/* Hash index from link-layer address to neighbor index */
+static unsigned hash_home(int index);
+HASH_INDEX(nbr_hash, NBR_TABLE_HASH_SIZE, hash_home);
+#endif /* NBR_TABLE_WITH_HASH */
+
 /*---------------------------------------------------------------------------*/
 /* Get a key from a neighbor index */
 static nbr_table_key_t *
@@ -128,6 +138,49 @@ key_from_item(nbr_table_t *table, const nbr_table_item_t *item)
 {
   return key_from_index(index_from_item(table, item));
 }
+#if NBR_TABLE_WITH_HASH
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_lladdr(const linkaddr_t *lladdr)
+{
+  /* FNV-1a spreads addresses that only differ in their last bytes, as
+   * they usually do */
+  return hash_index_fnv1a(HASH_INDEX_FNV1A_INIT, lladdr, LINKADDR_SIZE)
+      % NBR_TABLE_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_home(int index)
+{
+  return hash_lladdr(&key_from_index(index)->lladdr);
+}
+/*---------------------------------------------------------------------------*/
+static int
+hash_match(int index, const void *lladdr)
+{
+  return linkaddr_cmp(lladdr, &key_from_index(index)->lladdr);
+}
+/*---------------------------------------------------------------------------*/
+/* Get the hash slot of a link-layer address, or of the empty slot
+ * where it would go */
+static unsigned
+hash_find(const linkaddr_t *lladdr)
+{
+  return hash_index_find(&nbr_hash, hash_lladdr(lladdr), hash_match, lladdr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_add(nbr_table_key_t *key)
+{
+  hash_index_set(&nbr_hash, hash_find(&key->lladdr), index_from_key(key));
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(nbr_table_key_t *key)
+{
+  hash_index_remove(&nbr_hash, hash_find(&key->lladdr));
+}
+#endif /* NBR_TABLE_WITH_HASH */
 /*---------------------------------------------------------------------------*/
 /* Get the index of a neighbor from its link-layer address */
 static int
@@ -139,6 +192,10 @@ index_from_lladdr(const linkaddr_t *lladdr)
   if(lladdr == NULL) {
     lladdr = &linkaddr_null;
   }
+#if NBR_TABLE_WITH_HASH
+  key = key_from_index(hash_index_get(&nbr_hash, hash_find(lladdr)));
+  return key != NULL ? index_from_key(key) : -1;
+#endif /* NBR_TABLE_WITH_HASH */
   key = list_head(nbr_table_keys);
   while(key != NULL) {
     if(lladdr && linkaddr_cmp(lladdr, &key->lladdr)) {
@@ -196,6 +253,9 @@ remove_key(nbr_table_key_t *least_used_key)
   }
   /* Empty used map */
   used_map[index_from_key(least_used_key)] = 0;
+#if NBR_TABLE_WITH_HASH
+  hash_remove(least_used_key);
+#endif /* NBR_TABLE_WITH_HASH */
   /* Remove neighbor from list */
   list_remove(nbr_table_keys, least_used_key);
 }
@@ -369,6 +429,9 @@ nbr_table_add_lladdr(nbr_table_t *table, const linkaddr_t *lladdr, nbr_table_rea
 
     /* Set link-layer address */
     linkaddr_copy(&key->lladdr, lladdr);
+#if NBR_TABLE_WITH_HASH
+    hash_add(key);
+#endif /* NBR_TABLE_WITH_HASH */
   }
 
   /* Get item in the current table */
@@ -466,11 +529,17 @@ nbr_table_update_lladdr(const linkaddr_t *old_addr, const linkaddr_t *new_addr,
     return 0;
   }
   key = key_from_index(index);
+#if NBR_TABLE_WITH_HASH
+  hash_remove(key);
+#endif /* NBR_TABLE_WITH_HASH */
   /**
    * Copy the new lladdr into the key - since we know that there is no
    * conflicting entry.
    */
   memcpy(&key->lladdr, new_addr, sizeof(linkaddr_t));
+#if NBR_TABLE_WITH_HASH
+  hash_add(key);
+#endif /* NBR_TABLE_WITH_HASH */
   NBR_TABLE_RELEASE_LOCK();
   return 1;
 }
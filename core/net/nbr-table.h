@@ -46,6 +46,23 @@
 #define NBR_TABLE_MAX_NEIGHBORS 8
 #endif /* NBR_TABLE_CONF_MAX_NEIGHBORS */
 
+/* Keep a hash index over the link-layer addresses of the neighbors, so
+ * that looking up a neighbor does not walk the whole neighbor list.
+ * Costs NBR_TABLE_HASH_SIZE 16-bit words of RAM. */
+#ifdef NBR_TABLE_CONF_WITH_HASH
+#define NBR_TABLE_WITH_HASH NBR_TABLE_CONF_WITH_HASH
+#else /* NBR_TABLE_CONF_WITH_HASH */
+#define NBR_TABLE_WITH_HASH 0
+#endif /* NBR_TABLE_CONF_WITH_HASH */
+
+/* Number of slots in the hash index, should be about twice
+ * NBR_TABLE_MAX_NEIGHBORS to keep probe sequences short */
+#ifdef NBR_TABLE_CONF_HASH_SIZE
+#define NBR_TABLE_HASH_SIZE NBR_TABLE_CONF_HASH_SIZE
+#else /* NBR_TABLE_CONF_HASH_SIZE */
+#define NBR_TABLE_HASH_SIZE (2 * NBR_TABLE_MAX_NEIGHBORS)
+#endif /* NBR_TABLE_CONF_HASH_SIZE */
+
 #ifndef NBR_TABLE_CONF_WITH_LOCKING
 #define NBR_TABLE_CONF_WITH_LOCKING 0
 #endif /* NBR_TABLE_CONF_WITH_LOCKING */
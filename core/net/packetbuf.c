@@ -60,6 +60,12 @@ struct packetbuf *packetbuf = &temp;
 #define PRINTF(...)
 #endif
 
+#if PACKETBUF_WITH_REFERENCE
+#define REFLEN() (packetbuf->reflen)
+#else /* PACKETBUF_WITH_REFERENCE */
+#define REFLEN() 0
+#endif /* PACKETBUF_WITH_REFERENCE */
+
 /*---------------------------------------------------------------------------*/
 void
 packetbuf_clear(void)
@@ -67,6 +73,10 @@ packetbuf_clear(void)
   packetbuf->datalen = 0;
   packetbuf->bufptr = 0;
   packetbuf->hdrlen = 0;
+#if PACKETBUF_WITH_REFERENCE
+  packetbuf->ref = NULL;
+  packetbuf->reflen = 0;
+#endif /* PACKETBUF_WITH_REFERENCE */
   packetbuf_attr_clear();
 }
 /*---------------------------------------------------------------------------*/
@@ -88,8 +98,8 @@ packetbuf_compact(void)
   int16_t i;
 
   if(packetbuf->bufptr) {
-    /* shift data to the left */
-    for(i = 0; i < packetbuf->datalen; i++) {
+    /* shift data to the left, external data stays in place */
+    for(i = 0; i < packetbuf->datalen - REFLEN(); i++) {
       packetbuf->data[packetbuf->hdrlen + i] = packetbuf->data[packetbuf_hdrlen() + i];
     }
     packetbuf->bufptr = 0;
@@ -102,12 +112,77 @@ packetbuf_copyto(void *to)
   if(packetbuf->hdrlen + packetbuf->datalen > PACKETBUF_SIZE) {
     return 0;
   }
-  memcpy(to, packetbuf_hdrptr(), packetbuf->hdrlen);
-  memcpy((uint8_t *)to + packetbuf->hdrlen, packetbuf_dataptr(), packetbuf->datalen);
+  memcpy(to, packetbuf->data, packetbuf->hdrlen);
+  memcpy((uint8_t *)to + packetbuf->hdrlen, packetbuf->data + packetbuf_hdrlen(),
+         packetbuf->datalen - REFLEN());
+#if PACKETBUF_WITH_REFERENCE
+  /* Gather the external data without copying it into the packetbuf first */
+  memcpy((uint8_t *)to + packetbuf->hdrlen + packetbuf->datalen - packetbuf->reflen,
+         packetbuf->ref, packetbuf->reflen);
+#endif /* PACKETBUF_WITH_REFERENCE */
   return packetbuf->hdrlen + packetbuf->datalen;
 }
 /*---------------------------------------------------------------------------*/
 int
+packetbuf_reference(const void *ptr, uint16_t len)
+{
+#if PACKETBUF_WITH_REFERENCE
+  packetbuf_clear();
+  packetbuf_append_reference(ptr, MIN(PACKETBUF_SIZE, len));
+  return packetbuf->datalen;
+#else /* PACKETBUF_WITH_REFERENCE */
+  return packetbuf_copyfrom(ptr, len);
+#endif /* PACKETBUF_WITH_REFERENCE */
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_append_reference(const void *ptr, uint16_t len)
+{
+  if(len + packetbuf_totlen() > PACKETBUF_SIZE) {
+    return 0;
+  }
+#if PACKETBUF_WITH_REFERENCE
+  /* Only one external segment is kept */
+  packetbuf_copy_reference();
+  packetbuf->ref = ptr;
+  packetbuf->reflen = len;
+#else /* PACKETBUF_WITH_REFERENCE */
+  memcpy((uint8_t *)packetbuf_dataptr() + packetbuf->datalen, ptr, len);
+#endif /* PACKETBUF_WITH_REFERENCE */
+  packetbuf->datalen += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_is_reference(void)
+{
+  return REFLEN() > 0;
+}
+/*---------------------------------------------------------------------------*/
+const void *
+packetbuf_reference_ptr(void)
+{
+#if PACKETBUF_WITH_REFERENCE
+  return packetbuf->reflen > 0 ? packetbuf->ref : NULL;
+#else /* PACKETBUF_WITH_REFERENCE */
+  return NULL;
+#endif /* PACKETBUF_WITH_REFERENCE */
+}
+/*---------------------------------------------------------------------------*/
+void
+packetbuf_copy_reference(void)
+{
+#if PACKETBUF_WITH_REFERENCE
+  if(packetbuf->reflen > 0) {
+    memcpy(packetbuf->data + packetbuf_totlen() - packetbuf->reflen,
+           packetbuf->ref, packetbuf->reflen);
+    packetbuf->ref = NULL;
+    packetbuf->reflen = 0;
+  }
+#endif /* PACKETBUF_WITH_REFERENCE */
+}
+/*---------------------------------------------------------------------------*/
+int
 packetbuf_hdralloc(int size)
 {
   int16_t i;
@@ -116,8 +191,8 @@ packetbuf_hdralloc(int size)
     return 0;
   }
 
-  /* shift data to the right */
-  for(i = packetbuf_totlen() - 1; i >= 0; i--) {
+  /* shift data to the right, external data stays in place */
+  for(i = packetbuf_totlen() - REFLEN() - 1; i >= 0; i--) {
     packetbuf->data[i + size] = packetbuf->data[i];
   }
   packetbuf->hdrlen += size;
@@ -131,6 +206,7 @@ packetbuf_hdrreduce(int size)
     return 0;
   }
 
+  packetbuf_copy_reference();
   packetbuf->bufptr += size;
   packetbuf->datalen -= size;
   return 1;
@@ -140,18 +216,21 @@ void
 packetbuf_set_datalen(uint16_t len)
 {
   PRINTF("packetbuf_set_len: len %d\n", len);
+  packetbuf_copy_reference();
   packetbuf->datalen = len;
 }
 /*---------------------------------------------------------------------------*/
 void *
 packetbuf_dataptr(void)
 {
+  packetbuf_copy_reference();
   return packetbuf->data + packetbuf_hdrlen();
 }
 /*---------------------------------------------------------------------------*/
 void *
 packetbuf_hdrptr(void)
 {
+  packetbuf_copy_reference();
   return packetbuf->data;
 }
 /*---------------------------------------------------------------------------*/
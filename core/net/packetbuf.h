@@ -79,6 +79,24 @@
 #define PACKETBUF_WITH_UNENCRYPTED_BYTES 0
 #endif /* PACKETBUF_CONF_WITH_UNENCRYPTED_BYTES */
 
+/**
+ * \brief      Enable external data references in the packetbuf
+ *
+ *             With references enabled, the tail of the packet data
+ *             can be left in an external buffer (see
+ *             packetbuf_append_reference()) and is only copied into
+ *             the packetbuf when a contiguous packet is needed,
+ *             typically when the MAC layer writes its header. Queuebufs
+ *             copy referenced data directly from the external buffer,
+ *             and are themselves referenced when copied back to the
+ *             packetbuf.
+ */
+#ifdef PACKETBUF_CONF_WITH_REFERENCE
+#define PACKETBUF_WITH_REFERENCE PACKETBUF_CONF_WITH_REFERENCE
+#else /* PACKETBUF_CONF_WITH_REFERENCE */
+#define PACKETBUF_WITH_REFERENCE 0
+#endif /* PACKETBUF_CONF_WITH_REFERENCE */
+
 /**
  * \brief      Clear and reset the packetbuf
  *
@@ -190,6 +208,63 @@ int packetbuf_copyfrom(const void *from, uint16_t len);
  */
 int packetbuf_copyto(void *to);
 
+/**
+ * \brief      Point the packetbuf to external data
+ * \param ptr  A pointer to the external data
+ * \param len  The length of the external data
+ * \retval     The length of the data in the packetbuf
+ *
+ *             This function clears the packetbuf and sets its data
+ *             portion to the external data, without copying it. The
+ *             external data must remain valid and unchanged until the
+ *             packet has been sent or copied to a queuebuf. Without
+ *             PACKETBUF_WITH_REFERENCE, the data is copied.
+ *
+ */
+int packetbuf_reference(const void *ptr, uint16_t len);
+
+/**
+ * \brief      Append external data to the data in the packetbuf
+ * \param ptr  A pointer to the external data
+ * \param len  The length of the external data
+ * \retval     Non-zero if the data could be appended, zero otherwise
+ *
+ *             This function appends external data after the current
+ *             data of the packetbuf, e.g. a payload after a header
+ *             written with packetbuf_dataptr(), and adds its length
+ *             to the data length. The same lifetime rules as for
+ *             packetbuf_reference() apply. If the packet would not fit
+ *             in the packetbuf, nothing is appended.
+ *
+ */
+int packetbuf_append_reference(const void *ptr, uint16_t len);
+
+/**
+ * \brief      Check if the packetbuf references external data
+ * \retval     Non-zero if part of the data is stored externally
+ *
+ */
+int packetbuf_is_reference(void);
+
+/**
+ * \brief      Get a pointer to the external data of the packetbuf
+ * \retval     Pointer to the external data, or NULL if there is none
+ *
+ */
+const void *packetbuf_reference_ptr(void);
+
+/**
+ * \brief      Copy referenced external data into the packetbuf
+ *
+ *             This function makes the packet contiguous in the
+ *             packetbuf. It is called implicitly by
+ *             packetbuf_dataptr(), packetbuf_hdrptr() and the
+ *             functions that modify the data, so that external data is
+ *             never written to.
+ *
+ */
+void packetbuf_copy_reference(void);
+
 /**
  * \brief      Extend the header of the packetbuf, for outbound packets
  * \param size The number of bytes the header should be extended
@@ -251,6 +326,9 @@ enum {
   PACKETBUF_ATTR_MAC_SEQNO,
   PACKETBUF_ATTR_MAC_ACK,
   PACKETBUF_ATTR_IS_CREATED_AND_SECURED,
+#if NETSTACK_CONF_WITH_IPV6
+  PACKETBUF_ATTR_ICMP6_TYPE,
+#endif /* NETSTACK_CONF_WITH_IPV6 */
 #if TSCH_WITH_LINK_SELECTOR
   PACKETBUF_ATTR_TSCH_SLOTFRAME,
   PACKETBUF_ATTR_TSCH_TIMESLOT,
@@ -339,6 +417,11 @@ struct packetbuf {
   uint16_t datalen;
   uint8_t hdrlen;
   uint16_t bufptr;
+#if PACKETBUF_WITH_REFERENCE
+  /* External data, the last reflen bytes of the data portion */
+  const uint8_t *ref;
+  uint16_t reflen;
+#endif /* PACKETBUF_WITH_REFERENCE */
 };
 extern struct packetbuf *packetbuf;
 
@@ -276,6 +276,19 @@ queuebuf_load_to_ram(struct queuebuf *b)
 }
 #endif /* WITH_SWAP */
 /*---------------------------------------------------------------------------*/
+/* Makes sure that the packetbuf does not reference the data of a queuebuf
+   that is about to be freed or overwritten */
+static void
+release_packetbuf_reference(struct queuebuf_data *buframptr)
+{
+#if PACKETBUF_WITH_REFERENCE
+  const uint8_t *ref = packetbuf_reference_ptr();
+  if(ref >= buframptr->data && ref < buframptr->data + PACKETBUF_SIZE) {
+    packetbuf_copy_reference();
+  }
+#endif /* PACKETBUF_WITH_REFERENCE */
+}
+/*---------------------------------------------------------------------------*/
 void
 queuebuf_init(void)
 {
@@ -382,6 +395,7 @@ void
 queuebuf_update_from_packetbuf(struct queuebuf *buf)
 {
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
+  release_packetbuf_reference(buframptr);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
   buframptr->len = packetbuf_copyto(buframptr->data);
 #if WITH_SWAP
@@ -397,11 +411,13 @@ queuebuf_free(struct queuebuf *buf)
   if(memb_inmemb(&bufmem, buf)) {
 #if WITH_SWAP
     if(buf->location == IN_RAM) {
+      release_packetbuf_reference(buf->ram_ptr);
       memb_free(&buframmem, buf->ram_ptr);
     } else {
       queuebuf_remove_from_file(buf->swap_id);
     }
 #else
+    release_packetbuf_reference(buf->ram_ptr);
     memb_free(&buframmem, buf->ram_ptr);
 #endif
     memb_free(&bufmem, buf);
@@ -420,7 +436,16 @@ queuebuf_to_packetbuf(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
-    packetbuf_copyfrom(buframptr->data, buframptr->len);
+#if WITH_SWAP
+    if(b->location == IN_CFS) {
+      /* tmpdata may be reloaded at any time, it cannot be referenced */
+      packetbuf_copyfrom(buframptr->data, buframptr->len);
+    } else
+#endif /* WITH_SWAP */
+    {
+      /* Copied only when the packet is modified or made contiguous */
+      packetbuf_reference(buframptr->data, buframptr->len);
+    }
     packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
   }
 }
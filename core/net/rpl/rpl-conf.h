@@ -320,6 +320,21 @@
 #define RPL_PROBING_DELAY_FUNC get_probing_delay
 #endif
 
+/*
+ * RPL parent heap. When enabled, parents are kept in a min-heap ordered
+ * by their cached path cost. The heap is adjusted incrementally on link
+ * statistics updates and parent events, so that finding the best parent
+ * does not require calling the objective function on every parent, and
+ * link updates that leave the path cost unchanged do not trigger parent
+ * selection. Useful on nodes with large neighbor tables, of up to 255
+ * neighbors.
+ */
+#ifdef RPL_CONF_WITH_PARENT_HEAP
+#define RPL_WITH_PARENT_HEAP RPL_CONF_WITH_PARENT_HEAP
+#else
+#define RPL_WITH_PARENT_HEAP 0
+#endif
+
 /*
  * Interval of DIS transmission
  */
@@ -257,6 +257,112 @@ rpl_set_preferred_parent(rpl_dag_t *dag, rpl_parent_t *p)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_PARENT_HEAP
+#if NBR_TABLE_MAX_NEIGHBORS > 255
+#error "RPL_CONF_WITH_PARENT_HEAP supports at most 255 neighbors (8-bit heap indices)"
+#endif /* NBR_TABLE_MAX_NEIGHBORS > 255 */
+/* Parents of all DAGs, ordered by cached path cost, cheapest first */
+static rpl_parent_t *parent_heap[NBR_TABLE_MAX_NEIGHBORS];
+static uint8_t parent_heap_len;
+/* Depth of the heap walk in best_parent; enough for any 8-bit heap index */
+#define PARENT_HEAP_STACK_SIZE 16
+/*---------------------------------------------------------------------------*/
+static int
+parent_heap_contains(rpl_parent_t *p)
+{
+  return p->heap_index < parent_heap_len && parent_heap[p->heap_index] == p;
+}
+/*---------------------------------------------------------------------------*/
+static void
+parent_heap_set(int i, rpl_parent_t *p)
+{
+  parent_heap[i] = p;
+  p->heap_index = i;
+}
+/*---------------------------------------------------------------------------*/
+/* Moves the parent at index i up or down to restore the heap order */
+static void
+parent_heap_sift(int i)
+{
+  rpl_parent_t *p = parent_heap[i];
+  int child;
+
+  while(i > 0 && parent_heap[(i - 1) / 2]->path_cost > p->path_cost) {
+    parent_heap_set(i, parent_heap[(i - 1) / 2]);
+    i = (i - 1) / 2;
+  }
+  while((child = 2 * i + 1) < parent_heap_len) {
+    if(child + 1 < parent_heap_len &&
+       parent_heap[child + 1]->path_cost < parent_heap[child]->path_cost) {
+      child++;
+    }
+    if(parent_heap[child]->path_cost >= p->path_cost) {
+      break;
+    }
+    parent_heap_set(i, parent_heap[child]);
+    i = child;
+  }
+  parent_heap_set(i, p);
+}
+/*---------------------------------------------------------------------------*/
+static void
+parent_heap_remove(rpl_parent_t *p)
+{
+  rpl_parent_t *last;
+
+  if(p != NULL && parent_heap_contains(p)) {
+    last = parent_heap[--parent_heap_len];
+    if(last != p) {
+      parent_heap_set(p->heap_index, last);
+      parent_heap_sift(last->heap_index);
+    }
+  }
+}
+#endif /* RPL_WITH_PARENT_HEAP */
+/*---------------------------------------------------------------------------*/
+int
+rpl_update_parent_cost(rpl_parent_t *p)
+{
+#if RPL_WITH_PARENT_HEAP
+  uint16_t cost;
+  uint8_t fresh;
+  int changed;
+
+  if(p == NULL) {
+    return 0;
+  }
+
+  if(p->dag != NULL && p->dag->instance != NULL && p->dag->instance->of != NULL) {
+    cost = p->dag->instance->of->parent_path_cost(p);
+  } else {
+    cost = 0xffff;
+  }
+  fresh = rpl_parent_is_fresh(p) ? RPL_PARENT_FLAG_WAS_FRESH : 0;
+
+  if(!parent_heap_contains(p)) {
+    if(parent_heap_len >= NBR_TABLE_MAX_NEIGHBORS) {
+      return 1;
+    }
+    p->path_cost = cost;
+    parent_heap_set(parent_heap_len++, p);
+    parent_heap_sift(p->heap_index);
+    changed = 1;
+  } else {
+    changed = cost != p->path_cost ||
+      fresh != (p->flags & RPL_PARENT_FLAG_WAS_FRESH);
+    if(cost != p->path_cost) {
+      p->path_cost = cost;
+      parent_heap_sift(p->heap_index);
+    }
+  }
+  p->flags = (p->flags & ~RPL_PARENT_FLAG_WAS_FRESH) | fresh;
+
+  return changed;
+#else /* RPL_WITH_PARENT_HEAP */
+  return 1;
+#endif /* RPL_WITH_PARENT_HEAP */
+}
+/*---------------------------------------------------------------------------*/
 /* Greater-than function for the lollipop counter.                      */
 /*---------------------------------------------------------------------------*/
 static int
@@ -688,6 +794,10 @@ rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
   PRINT6ADDR(addr);
   PRINTF("\n");
   if(lladdr != NULL) {
+#if RPL_WITH_PARENT_HEAP
+    /* An existing entry is reset when added again */
+    parent_heap_remove(nbr_table_get_from_lladdr(rpl_parents, (linkaddr_t *)lladdr));
+#endif /* RPL_WITH_PARENT_HEAP */
     /* Add parent in rpl_parents - again this is due to DIO */
     p = nbr_table_add_lladdr(rpl_parents, (linkaddr_t *)lladdr,
                              NBR_TABLE_REASON_RPL_DIO, dio);
@@ -700,6 +810,7 @@ rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
 #if RPL_WITH_MC
       memcpy(&p->mc, &dio->mc, sizeof(p->mc));
 #endif /* RPL_WITH_MC */
+      rpl_update_parent_cost(p);
     }
   }
 
@@ -849,50 +960,116 @@ rpl_select_dag(rpl_instance_t *instance, rpl_parent_t *p)
   return best_dag;
 }
 /*---------------------------------------------------------------------------*/
+static int
+parent_is_candidate(rpl_dag_t *dag, rpl_parent_t *p, int fresh_only)
+{
+  /* Exclude parents from other DAGs or announcing an infinite rank */
+  if(p->dag != dag || p->rank == INFINITE_RANK || p->rank < ROOT_RANK(dag->instance)) {
+    if(p->rank < ROOT_RANK(dag->instance)) {
+      PRINTF("RPL: Parent has invalid rank\n");
+    }
+    return 0;
+  }
+
+  if(fresh_only && !rpl_parent_is_fresh(p)) {
+    /* Filter out non-fresh parents if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  {
+  uip_ds6_nbr_t *nbr = rpl_get_nbr(p);
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(nbr == NULL || nbr->state != NBR_REACHABLE) {
+    return 0;
+  }
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_PARENT_HEAP
 static rpl_parent_t *
 best_parent(rpl_dag_t *dag, int fresh_only)
 {
   rpl_parent_t *p;
   rpl_of_t *of;
   rpl_parent_t *best = NULL;
+  uint8_t stack[PARENT_HEAP_STACK_SIZE];
+  int sp;
+  int i;
 
   if(dag == NULL || dag->instance == NULL || dag->instance->of == NULL) {
     return NULL;
   }
 
   of = dag->instance->of;
-  /* Search for the best parent according to the OF */
-  for(p = nbr_table_head(rpl_parents); p != NULL; p = nbr_table_next(rpl_parents, p)) {
-
-    /* Exclude parents from other DAGs or announcing an infinite rank */
-    if(p->dag != dag || p->rank == INFINITE_RANK || p->rank < ROOT_RANK(dag->instance)) {
-      if(p->rank < ROOT_RANK(dag->instance)) {
-        PRINTF("RPL: Parent has invalid rank\n");
-      }
+  /* Walk the heap depth-first, skipping the subtrees rooted at a parent
+     more costly than the best acceptable parent found so far. Only the
+     cheapest parents are handed to the OF. */
+  sp = 0;
+  if(parent_heap_len > 0) {
+    stack[sp++] = 0;
+  }
+  while(sp > 0) {
+    i = stack[--sp];
+    p = parent_heap[i];
+
+    if(best != NULL && p->path_cost > best->path_cost) {
       continue;
     }
 
-    if(fresh_only && !rpl_parent_is_fresh(p)) {
-      /* Filter out non-fresh parents if fresh_only is set */
-      continue;
+    if(parent_is_candidate(dag, p, fresh_only) && of->best_parent(NULL, p) == p) {
+      /* Ties are left to the OF */
+      if(best == NULL || p->path_cost < best->path_cost) {
+        best = p;
+      } else {
+        best = of->best_parent(best, p);
+      }
     }
 
-#if UIP_ND6_SEND_NS
-    {
-    uip_ds6_nbr_t *nbr = rpl_get_nbr(p);
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(nbr == NULL || nbr->state != NBR_REACHABLE) {
-      continue;
+    if(2 * i + 2 < parent_heap_len && sp < PARENT_HEAP_STACK_SIZE) {
+      stack[sp++] = 2 * i + 2;
     }
+    if(2 * i + 1 < parent_heap_len && sp < PARENT_HEAP_STACK_SIZE) {
+      stack[sp++] = 2 * i + 1;
     }
-#endif /* UIP_ND6_SEND_NS */
+  }
 
-    /* Now we have an acceptable parent, check if it is the new best */
+  /* Let the OF apply its hysteresis between the preferred parent and the
+     cheapest one */
+  p = dag->preferred_parent;
+  if(p != NULL && p != best && parent_is_candidate(dag, p, fresh_only)) {
     best = of->best_parent(best, p);
   }
 
   return best;
 }
+#else /* RPL_WITH_PARENT_HEAP */
+static rpl_parent_t *
+best_parent(rpl_dag_t *dag, int fresh_only)
+{
+  rpl_parent_t *p;
+  rpl_of_t *of;
+  rpl_parent_t *best = NULL;
+
+  if(dag == NULL || dag->instance == NULL || dag->instance->of == NULL) {
+    return NULL;
+  }
+
+  of = dag->instance->of;
+  /* Search for the best parent according to the OF */
+  for(p = nbr_table_head(rpl_parents); p != NULL; p = nbr_table_next(rpl_parents, p)) {
+    if(parent_is_candidate(dag, p, fresh_only)) {
+      /* Now we have an acceptable parent, check if it is the new best */
+      best = of->best_parent(best, p);
+    }
+  }
+
+  return best;
+}
+#endif /* RPL_WITH_PARENT_HEAP */
 /*---------------------------------------------------------------------------*/
 rpl_parent_t *
 rpl_select_parent(rpl_dag_t *dag)
@@ -939,6 +1116,9 @@ rpl_remove_parent(rpl_parent_t *parent)
 
   rpl_nullify_parent(parent);
 
+#if RPL_WITH_PARENT_HEAP
+  parent_heap_remove(parent);
+#endif /* RPL_WITH_PARENT_HEAP */
   nbr_table_remove(rpl_parents, parent);
 }
 /*---------------------------------------------------------------------------*/
@@ -999,6 +1179,7 @@ rpl_move_parent(rpl_dag_t *dag_src, rpl_dag_t *dag_dst, rpl_parent_t *parent)
   PRINTF("\n");
 
   parent->dag = dag_dst;
+  rpl_update_parent_cost(parent);
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -1179,6 +1360,8 @@ rpl_join_instance(uip_ipaddr_t *from, rpl_dio_t *dio)
   }
 
   instance->of->reset(dag);
+  /* The parent was added before the OF of the instance was known */
+  rpl_update_parent_cost(p);
 }
 
 #if RPL_MAX_DAG_PER_INSTANCE > 1
@@ -1371,6 +1554,8 @@ rpl_process_parent_event(rpl_instance_t *instance, rpl_parent_t *p)
 
   return_value = 1;
 
+  rpl_update_parent_cost(p);
+
   if(RPL_IS_STORING(instance)
       && uip_ds6_route_is_nexthop(rpl_get_parent_ipaddr(p))
       && !rpl_parent_is_reachable(p) && instance->mop > RPL_MOP_NON_STORING) {
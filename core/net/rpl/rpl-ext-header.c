@@ -131,6 +131,7 @@ rpl_verify_hbh_header(int uip_ext_opt_offset)
     /* A rank error was signalled, attempt to repair it by updating
      * the sender's rank from ext header */
     sender->rank = sender_rank;
+    rpl_update_parent_cost(sender);
     if(RPL_IS_NON_STORING(instance)) {
       /* Select DAG and preferred parent only in non-storing mode. In storing mode,
        * a parent switch would result in an immediate No-path DAO transmission, dropping
@@ -322,21 +323,133 @@ count_matching_bytes(const void *p1, const void *p2, size_t n)
   return n;
 }
 /*---------------------------------------------------------------------------*/
+/* Make room for a source routing header of ext_len bytes after the IPv6
+   header and fill in its fixed fields */
+static void
+write_srh_header(uint8_t path_len, uint8_t cmpr, uint8_t ext_len,
+                 uint8_t padding)
+{
+  /* Move existing ext headers and payload uip_ext_len further */
+  memmove(uip_buf + uip_l2_l3_hdr_len + ext_len,
+      uip_buf + uip_l2_l3_hdr_len, uip_len - UIP_IPH_LEN);
+  memset(uip_buf + uip_l2_l3_hdr_len, 0, ext_len);
+
+  /* Insert source routing header */
+  UIP_RH_BUF->next = UIP_IP_BUF->proto;
+  UIP_IP_BUF->proto = UIP_PROTO_ROUTING;
+
+  /* Initialize IPv6 Routing Header */
+  UIP_RH_BUF->len = (ext_len - 8) / 8;
+  UIP_RH_BUF->routing_type = RPL_RH_TYPE_SRH;
+  UIP_RH_BUF->seg_left = path_len;
+
+  /* Initialize RPL Source Routing Header */
+  UIP_RPL_SRH_BUF->cmpr = cmpr;
+  UIP_RPL_SRH_BUF->pad = padding << 4;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_ip_len(uint8_t ext_len)
+{
+  uint8_t temp_len;
+
+  /* In-place update of IPv6 length field */
+  temp_len = UIP_IP_BUF->len[1];
+  UIP_IP_BUF->len[1] += ext_len;
+  if(UIP_IP_BUF->len[1] < temp_len) {
+    UIP_IP_BUF->len[0]++;
+  }
+
+  uip_ext_len += ext_len;
+  uip_len += ext_len;
+}
+#if RPL_NS_SRH_CACHE_SIZE
+/*---------------------------------------------------------------------------*/
+/* A source routing header built earlier for a destination. A path_len
+   of zero means the destination is a child of the root and needs no
+   header. */
+struct srh_cache_entry {
+  rpl_ns_node_t *dest_node;
+  uint32_t version;
+  uip_ipaddr_t next_hop;
+  uint8_t path_len;
+  uint8_t cmpr;
+  uint8_t ext_len;
+  uint8_t padding;
+  uint8_t hops[RPL_NS_SRH_CACHE_MAX_LEN];
+};
+
+static struct srh_cache_entry srh_cache[RPL_NS_SRH_CACHE_SIZE];
+/*---------------------------------------------------------------------------*/
+static struct srh_cache_entry *
+srh_cache_slot(const rpl_ns_node_t *dest_node)
+{
+  return &srh_cache[((uintptr_t)dest_node / sizeof(rpl_ns_node_t)) %
+                    RPL_NS_SRH_CACHE_SIZE];
+}
+/*---------------------------------------------------------------------------*/
+static struct srh_cache_entry *
+srh_cache_lookup(const rpl_ns_node_t *dest_node)
+{
+  struct srh_cache_entry *e;
+
+  e = srh_cache_slot(dest_node);
+  if(e->dest_node == dest_node && e->version == rpl_ns_topology_version()) {
+    return e;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Remember the source routing header that was just written to uip_buf
+   (or that none was needed, if path_len is zero). Must be called before
+   update_ip_len(), which moves UIP_RPL_SRH_BUF. */
+static void
+srh_cache_store(rpl_ns_node_t *dest_node, uint8_t path_len, uint8_t ext_len,
+                uint8_t padding)
+{
+  struct srh_cache_entry *e;
+  uint8_t hops_len;
+
+  hops_len = 0;
+  if(path_len > 0) {
+    hops_len = ext_len - RPL_RH_LEN - RPL_SRH_LEN - padding;
+    if(hops_len > RPL_NS_SRH_CACHE_MAX_LEN) {
+      return;
+    }
+  }
+
+  e = srh_cache_slot(dest_node);
+  e->dest_node = dest_node;
+  e->version = rpl_ns_topology_version();
+  e->path_len = path_len;
+  if(path_len > 0) {
+    e->cmpr = UIP_RPL_SRH_BUF->cmpr;
+    e->ext_len = ext_len;
+    e->padding = padding;
+    uip_ipaddr_copy(&e->next_hop, &UIP_IP_BUF->destipaddr);
+    memcpy(e->hops, ((uint8_t *)UIP_RPL_SRH_BUF) + RPL_SRH_LEN, hops_len);
+  }
+}
+#endif /* RPL_NS_SRH_CACHE_SIZE */
+/*---------------------------------------------------------------------------*/
 static int
 insert_srh_header(void)
 {
   /* Implementation of RFC6554 */
-  uint8_t temp_len;
   uint8_t path_len;
   uint8_t ext_len;
   uint8_t cmpri, cmpre; /* ComprI and ComprE fields of the RPL Source Routing Header */
   uint8_t *hop_ptr;
   uint8_t padding;
+  uint8_t cmpr;
   rpl_ns_node_t *dest_node;
   rpl_ns_node_t *root_node;
   rpl_ns_node_t *node;
   rpl_dag_t *dag;
   uip_ipaddr_t node_addr;
+#if RPL_NS_SRH_CACHE_SIZE
+  struct srh_cache_entry *cached;
+#endif /* RPL_NS_SRH_CACHE_SIZE */
 
   PRINTF("RPL: SRH creating source routing header with destination ");
   PRINT6ADDR(&UIP_IP_BUF->destipaddr);
@@ -358,6 +471,30 @@ insert_srh_header(void)
     return 1;
   }
 
+#if RPL_NS_SRH_CACHE_SIZE
+  cached = srh_cache_lookup(dest_node);
+  if(cached != NULL) {
+    if(cached->path_len == 0) {
+      PRINTF("RPL: SRH no need to insert SRH\n");
+      return 1;
+    }
+    path_len = cached->path_len;
+    cmpr = cached->cmpr;
+    ext_len = cached->ext_len;
+    padding = cached->padding;
+    if(uip_len + ext_len > UIP_BUFSIZE) {
+      PRINTF("RPL: Packet too long: impossible to add source routing header (%u bytes)\n", ext_len);
+      return 1;
+    }
+    write_srh_header(path_len, cmpr, ext_len, padding);
+    memcpy(((uint8_t *)UIP_RPL_SRH_BUF) + RPL_SRH_LEN, cached->hops,
+           ext_len - RPL_RH_LEN - RPL_SRH_LEN - padding);
+    uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &cached->next_hop);
+    update_ip_len(ext_len);
+    return 1;
+  }
+#endif /* RPL_NS_SRH_CACHE_SIZE */
+
   root_node = rpl_ns_get_node(dag, &dag->dag_id);
   if(root_node == NULL) {
     PRINTF("RPL: SRH root node not found\n");
@@ -378,6 +515,9 @@ insert_srh_header(void)
 
   if(node == root_node) {
     PRINTF("RPL: SRH no need to insert SRH\n");
+#if RPL_NS_SRH_CACHE_SIZE
+    srh_cache_store(dest_node, 0, 0, 0);
+#endif /* RPL_NS_SRH_CACHE_SIZE */
     return 1;
   }
 
@@ -413,23 +553,8 @@ insert_srh_header(void)
     return 1;
   }
 
-  /* Move existing ext headers and payload uip_ext_len further */
-  memmove(uip_buf + uip_l2_l3_hdr_len + ext_len,
-      uip_buf + uip_l2_l3_hdr_len, uip_len - UIP_IPH_LEN);
-  memset(uip_buf + uip_l2_l3_hdr_len, 0, ext_len);
-
-  /* Insert source routing header */
-  UIP_RH_BUF->next = UIP_IP_BUF->proto;
-  UIP_IP_BUF->proto = UIP_PROTO_ROUTING;
-
-  /* Initialize IPv6 Routing Header */
-  UIP_RH_BUF->len = (ext_len - 8) / 8;
-  UIP_RH_BUF->routing_type = RPL_RH_TYPE_SRH;
-  UIP_RH_BUF->seg_left = path_len;
-
-  /* Initialize RPL Source Routing Header */
-  UIP_RPL_SRH_BUF->cmpr = (cmpri << 4) + cmpre;
-  UIP_RPL_SRH_BUF->pad = padding << 4;
+  cmpr = (cmpri << 4) + cmpre;
+  write_srh_header(path_len, cmpr, ext_len, padding);
 
   /* Initialize addresses field (the actual source route).
    * From last to first. */
@@ -449,15 +574,11 @@ insert_srh_header(void)
   rpl_ns_get_node_global_addr(&node_addr, node);
   uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &node_addr);
 
-  /* In-place update of IPv6 length field */
-  temp_len = UIP_IP_BUF->len[1];
-  UIP_IP_BUF->len[1] += ext_len;
-  if(UIP_IP_BUF->len[1] < temp_len) {
-    UIP_IP_BUF->len[0]++;
-  }
+#if RPL_NS_SRH_CACHE_SIZE
+  srh_cache_store(dest_node, path_len, ext_len, padding);
+#endif /* RPL_NS_SRH_CACHE_SIZE */
 
-  uip_ext_len += ext_len;
-  uip_len += ext_len;
+  update_ip_len(ext_len);
 
   return 1;
 }
@@ -702,6 +702,7 @@ dao_input_storing(void)
       PRINTF("RPL: Loop detected when receiving a unicast DAO from a node with a lower rank! (%u < %u)\n",
              DAG_RANK(parent->rank, instance), DAG_RANK(dag->rank, instance));
       parent->rank = INFINITE_RANK;
+      rpl_update_parent_cost(parent);
       parent->flags |= RPL_PARENT_FLAG_UPDATED;
       return;
     }
@@ -710,6 +711,7 @@ dao_input_storing(void)
     if(parent != NULL && parent == dag->preferred_parent) {
       PRINTF("RPL: Loop detected when receiving a unicast DAO from our parent\n");
       parent->rank = INFINITE_RANK;
+      rpl_update_parent_cost(parent);
       parent->flags |= RPL_PARENT_FLAG_UPDATED;
       return;
     }
@@ -107,9 +107,11 @@ dao_ack_callback(rpl_parent_t *p, int status)
   if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
     /* punish the ETX as if this was 10 packets lost */
     link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+    rpl_update_parent_cost(p);
   } else if(status == RPL_DAO_ACK_TIMEOUT) { /* timeout = no ack */
     /* punish the total lack of ACK with a similar punishment */
     link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+    rpl_update_parent_cost(p);
   }
 }
 #endif /* RPL_WITH_DAO_ACK */
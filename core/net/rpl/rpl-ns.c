@@ -47,6 +47,7 @@
 #include "net/rpl/rpl-ns.h"
 #include "lib/list.h"
 #include "lib/memb.h"
+#include "lib/hash-index.h"
 
 #if RPL_WITH_NON_STORING
 
@@ -63,6 +64,24 @@ static int num_nodes;
 LIST(nodelist);
 MEMB(nodememb, rpl_ns_node_t, RPL_NS_LINK_NUM);
 
+/* Bumped on every topology change */
+static uint32_t topology_version;
+
+#if RPL_NS_WITH_HASH
+#if RPL_NS_HASH_SIZE <= RPL_NS_LINK_NUM
+#error "RPL_NS_HASH_SIZE must be larger than RPL_NS_LINK_NUM"
+#endif /* RPL_NS_HASH_SIZE <= RPL_NS_LINK_NUM */
+/* Hash index from link identifier to the index of a node in nodememb */
+static unsigned hash_home(int index);
+HASH_INDEX(node_hash, RPL_NS_HASH_SIZE, hash_home);
+
+/* The key of a node lookup */
+struct hash_key {
+  const rpl_dag_t *dag;
+  const uip_ipaddr_t *addr;
+};
+#endif /* RPL_NS_WITH_HASH */
+
 /*---------------------------------------------------------------------------*/
 int
 rpl_ns_num_nodes(void)
@@ -80,11 +99,84 @@ node_matches_address(const rpl_dag_t *dag, const rpl_ns_node_t *node, const uip_
       && !memcmp(addr, &node->dag->dag_id, 8)
       && !memcmp(((const unsigned char *)addr) + 8, node->link_identifier, 8);
 }
+#if RPL_NS_WITH_HASH
+/*---------------------------------------------------------------------------*/
+static rpl_ns_node_t *
+node_from_index(int index)
+{
+  return (rpl_ns_node_t *)nodememb.mem + index;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_link_identifier(const unsigned char *id)
+{
+  return hash_index_fnv1a(HASH_INDEX_FNV1A_INIT, id, 8) % RPL_NS_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash_home(int index)
+{
+  return hash_link_identifier(node_from_index(index)->link_identifier);
+}
+/*---------------------------------------------------------------------------*/
+static int
+hash_match_address(int index, const void *key)
+{
+  const struct hash_key *k = key;
+
+  return node_matches_address(k->dag, node_from_index(index), k->addr);
+}
+/*---------------------------------------------------------------------------*/
+static int
+hash_match_node(int index, const void *node)
+{
+  return node_from_index(index) == node;
+}
+/*---------------------------------------------------------------------------*/
+/* Get the hash slot of the node with this address, or of the empty
+   slot where it would go */
+static unsigned
+hash_find(const rpl_dag_t *dag, const uip_ipaddr_t *addr)
+{
+  struct hash_key key;
+
+  key.dag = dag;
+  key.addr = addr;
+  return hash_index_find(&node_hash,
+                         hash_link_identifier(((const unsigned char *)addr) + 8),
+                         hash_match_address, &key);
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_add(rpl_ns_node_t *node, const uip_ipaddr_t *addr)
+{
+  hash_index_set(&node_hash, hash_find(node->dag, addr),
+                 node - node_from_index(0));
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(rpl_ns_node_t *node)
+{
+  hash_index_remove(&node_hash,
+                    hash_index_find(&node_hash,
+                                    hash_link_identifier(node->link_identifier),
+                                    hash_match_node, node));
+}
+#endif /* RPL_NS_WITH_HASH */
 /*---------------------------------------------------------------------------*/
 rpl_ns_node_t *
 rpl_ns_get_node(const rpl_dag_t *dag, const uip_ipaddr_t *addr)
 {
   rpl_ns_node_t *l;
+#if RPL_NS_WITH_HASH
+  int index;
+
+  if(addr == NULL || dag == NULL) {
+    return NULL;
+  }
+  index = hash_index_get(&node_hash, hash_find(dag, addr));
+  return index != -1 ? node_from_index(index) : NULL;
+#endif /* RPL_NS_WITH_HASH */
   for(l = list_head(nodelist); l != NULL; l = list_item_next(l)) {
     /* Compare prefix and node identifier */
     if(node_matches_address(dag, l, addr)) {
@@ -123,6 +215,7 @@ rpl_ns_update_node(rpl_dag_t *dag, const uip_ipaddr_t *child, const uip_ipaddr_t
   rpl_ns_node_t *child_node = rpl_ns_get_node(dag, child);
   rpl_ns_node_t *parent_node = rpl_ns_get_node(dag, parent);
   rpl_ns_node_t *old_parent_node;
+  rpl_ns_node_t *prev_parent_node;
 
   if(parent != NULL) {
     /* No node for the parent, add one with infinite lifetime */
@@ -150,6 +243,11 @@ rpl_ns_update_node(rpl_dag_t *dag, const uip_ipaddr_t *child, const uip_ipaddr_t
   child_node->dag = dag;
   child_node->lifetime = lifetime;
   memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
+#if RPL_NS_WITH_HASH
+  /* Rewrites the same slot if the node was already indexed */
+  hash_add(child_node, child);
+#endif /* RPL_NS_WITH_HASH */
+  prev_parent_node = child_node->parent;
 
   /* Is the node reachable before the update? */
   if(rpl_ns_is_node_reachable(dag, child)) {
@@ -167,6 +265,10 @@ rpl_ns_update_node(rpl_dag_t *dag, const uip_ipaddr_t *child, const uip_ipaddr_t
     child_node->parent = parent_node;
   }
 
+  if(child_node->parent != prev_parent_node) {
+    topology_version++;
+  }
+
   return child_node;
 }
 /*---------------------------------------------------------------------------*/
@@ -176,6 +278,10 @@ rpl_ns_init(void)
   num_nodes = 0;
   memb_init(&nodememb);
   list_init(nodelist);
+  topology_version++;
+#if RPL_NS_WITH_HASH
+  hash_index_clear(&node_hash);
+#endif /* RPL_NS_WITH_HASH */
 }
 /*---------------------------------------------------------------------------*/
 rpl_ns_node_t *
@@ -221,10 +327,20 @@ rpl_ns_periodic(void)
       }
       /* No child found, deallocate node */
       list_remove(nodelist, l);
+#if RPL_NS_WITH_HASH
+      hash_remove(l);
+#endif /* RPL_NS_WITH_HASH */
       memb_free(&nodememb, l);
       num_nodes--;
+      topology_version++;
     }
   }
 }
+/*---------------------------------------------------------------------------*/
+uint32_t
+rpl_ns_topology_version(void)
+{
+  return topology_version;
+}
 
 #endif /* RPL_WITH_NON_STORING */
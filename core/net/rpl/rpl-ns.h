@@ -49,6 +49,41 @@
 #define RPL_NS_LINK_NUM 32
 #endif /* RPL_NS_CONF_LINK_NUM */
 
+/* Index the nodes in a hash table keyed by link identifier, so that
+ * rpl_ns_get_node() does not walk the node list. Meant for roots of
+ * large non-storing networks. Costs RPL_NS_HASH_SIZE 16-bit words. */
+#ifdef RPL_NS_CONF_WITH_HASH
+#define RPL_NS_WITH_HASH RPL_NS_CONF_WITH_HASH
+#else /* RPL_NS_CONF_WITH_HASH */
+#define RPL_NS_WITH_HASH 0
+#endif /* RPL_NS_CONF_WITH_HASH */
+
+/* Number of slots in the hash index, should be about twice
+ * RPL_NS_LINK_NUM to keep probe sequences short */
+#ifdef RPL_NS_CONF_HASH_SIZE
+#define RPL_NS_HASH_SIZE RPL_NS_CONF_HASH_SIZE
+#else /* RPL_NS_CONF_HASH_SIZE */
+#define RPL_NS_HASH_SIZE (2 * RPL_NS_LINK_NUM)
+#endif /* RPL_NS_CONF_HASH_SIZE */
+
+/* Number of source routing headers that the root keeps ready for
+ * reuse, in a direct-mapped cache keyed by destination. Entries are
+ * dropped whenever a DAO changes the topology. Zero disables the
+ * cache. */
+#ifdef RPL_NS_CONF_SRH_CACHE_SIZE
+#define RPL_NS_SRH_CACHE_SIZE RPL_NS_CONF_SRH_CACHE_SIZE
+#else /* RPL_NS_CONF_SRH_CACHE_SIZE */
+#define RPL_NS_SRH_CACHE_SIZE 0
+#endif /* RPL_NS_CONF_SRH_CACHE_SIZE */
+
+/* Maximum size of the compressed addresses of a cached source route,
+ * longer routes are built every time */
+#ifdef RPL_NS_CONF_SRH_CACHE_MAX_LEN
+#define RPL_NS_SRH_CACHE_MAX_LEN RPL_NS_CONF_SRH_CACHE_MAX_LEN
+#else /* RPL_NS_CONF_SRH_CACHE_MAX_LEN */
+#define RPL_NS_SRH_CACHE_MAX_LEN 64
+#endif /* RPL_NS_CONF_SRH_CACHE_MAX_LEN */
+
 typedef struct rpl_ns_node {
   struct rpl_ns_node *next;
   uint32_t lifetime;
@@ -68,5 +103,8 @@ rpl_ns_node_t *rpl_ns_get_node(const rpl_dag_t *dag, const uip_ipaddr_t *addr);
 int rpl_ns_is_node_reachable(const rpl_dag_t *dag, const uip_ipaddr_t *addr);
 void rpl_ns_get_node_global_addr(uip_ipaddr_t *addr, rpl_ns_node_t *node);
 void rpl_ns_periodic(void);
+/* Incremented whenever a parent changes or a node is removed, so that
+ * source routes computed earlier can be recognized as stale */
+uint32_t rpl_ns_topology_version(void);
 
 #endif /* RPL_NS_H */
@@ -378,6 +378,10 @@ void rpl_move_parent(rpl_dag_t *dag_src, rpl_dag_t *dag_dst, rpl_parent_t *paren
 rpl_parent_t *rpl_select_parent(rpl_dag_t *dag);
 rpl_dag_t *rpl_select_dag(rpl_instance_t *instance,rpl_parent_t *parent);
 void rpl_recalculate_ranks(void);
+/* Refreshes the cached path cost of a parent and its position in the
+   parent heap. Returns non-zero if the path cost or freshness of the
+   parent may have changed (always, when the heap is disabled). */
+int rpl_update_parent_cost(rpl_parent_t *parent);
 
 /* RPL routing table functions. */
 void rpl_remove_routes(rpl_dag_t *dag);
@@ -263,8 +263,9 @@ rpl_link_neighbor_callback(const linkaddr_t *addr, int status, int numtx)
   for(instance = &instance_table[0], end = instance + RPL_MAX_INSTANCES; instance < end; ++instance) {
     if(instance->used == 1 ) {
       parent = rpl_find_parent_any_dag(instance, &ipaddr);
-      if(parent != NULL) {
-        /* Trigger DAG rank recalculation. */
+      /* Trigger DAG rank recalculation, unless the link update left the
+         path cost and freshness of the parent unchanged. */
+      if(parent != NULL && rpl_update_parent_cost(parent)) {
         PRINTF("RPL: rpl_link_neighbor_callback triggering update\n");
         parent->flags |= RPL_PARENT_FLAG_UPDATED;
       }
@@ -291,6 +292,7 @@ rpl_ipv6_neighbor_callback(uip_ds6_nbr_t *nbr)
       p = rpl_find_parent_any_dag(instance, &nbr->ipaddr);
       if(p != NULL) {
         p->rank = INFINITE_RANK;
+        rpl_update_parent_cost(p);
         /* Trigger DAG rank recalculation. */
         PRINTF("RPL: rpl_ipv6_neighbor_callback infinite rank\n");
         p->flags |= RPL_PARENT_FLAG_UPDATED;
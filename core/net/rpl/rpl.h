@@ -110,6 +110,7 @@ struct rpl_dag;
 /*---------------------------------------------------------------------------*/
 #define RPL_PARENT_FLAG_UPDATED           0x1
 #define RPL_PARENT_FLAG_LINK_METRIC_VALID 0x2
+#define RPL_PARENT_FLAG_WAS_FRESH         0x4
 
 struct rpl_parent {
   struct rpl_dag *dag;
@@ -119,6 +120,10 @@ struct rpl_parent {
   rpl_rank_t rank;
   uint8_t dtsn;
   uint8_t flags;
+#if RPL_WITH_PARENT_HEAP
+  uint16_t path_cost; /* Cached OF path cost, the heap key */
+  uint8_t heap_index;
+#endif /* RPL_WITH_PARENT_HEAP */
 };
 typedef struct rpl_parent rpl_parent_t;
 /*---------------------------------------------------------------------------*/
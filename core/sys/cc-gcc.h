@@ -39,5 +39,14 @@
 
 #define CC_CONF_ALIGN(n) __attribute__((__aligned__(n)))
 
+#ifndef CC_CONF_MEMORY_BARRIER
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+/* Hosts that may run the two sides on different cores need a fence */
+#define CC_CONF_MEMORY_BARRIER() __sync_synchronize()
+#else
+#define CC_CONF_MEMORY_BARRIER() __asm__ __volatile__("" : : : "memory")
+#endif
+#endif /* CC_CONF_MEMORY_BARRIER */
+
 #endif /* __GNUC__ */
 #endif /* _CC_GCC_H_ */
@@ -129,6 +129,20 @@
 
 #define CC_ACCESS_NOW(type, variable) (*(volatile type *)&(variable))
 
+/** \def CC_MEMORY_BARRIER()
+ * This macro keeps the compiler, and on multi-core hosts the CPU,
+ * from moving memory accesses across it. It is used where data is
+ * handed over between an interrupt or another core and the main
+ * loop through an index, such as in the ring buffers, so that the
+ * data is written before the index that publishes it. It defaults to
+ * nothing for compilers that are not known to need it.
+ */
+#ifdef CC_CONF_MEMORY_BARRIER
+#define CC_MEMORY_BARRIER() CC_CONF_MEMORY_BARRIER()
+#else /* CC_CONF_MEMORY_BARRIER */
+#define CC_MEMORY_BARRIER()
+#endif /* CC_CONF_MEMORY_BARRIER */
+
 #ifndef NULL
 #define NULL 0
 #endif /* NULL */
@@ -44,9 +44,21 @@
 
 #include "sys/ctimer.h"
 #include "contiki.h"
-#include "lib/list.h"
 
-LIST(ctimer_list);
+/*
+ * Pending callback timers are kept in a timer deadline queue of their
+ * own. A single event timer, owned by the ctimer process, is set to
+ * the expiration time of the first callback timer in the queue, so a
+ * callback costs no event and no list search. The etimer of each
+ * callback timer only holds its timer and queue entry; its process
+ * pointer is set while the callback timer is pending.
+ */
+static int timer_before(struct timerq_entry *a, struct timerq_entry *b);
+TIMERQ(ctimer_queue, timer_before);
+static struct etimer next_timer;
+static clock_time_t now;
+
+#define CTIMER(e) TIMERQ_ELEMENT(e, struct ctimer, etimer.entry)
 
 static char initialized;
 
@@ -58,31 +70,85 @@ static char initialized;
 #define PRINTF(...)
 #endif
 
-/*---------------------------------------------------------------------------*/
 PROCESS(ctimer_process, "Ctimer process");
+/*---------------------------------------------------------------------------*/
+static int
+timer_before(struct timerq_entry *a, struct timerq_entry *b)
+{
+  return timer_expires_before(&CTIMER(a)->etimer.timer,
+                              &CTIMER(b)->etimer.timer, now);
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule_next(void)
+{
+  struct ctimer *c;
+
+  if(!initialized) {
+    return;
+  }
+  if(timerq_head(&ctimer_queue) == NULL) {
+    etimer_stop(&next_timer);
+    return;
+  }
+  c = CTIMER(timerq_head(&ctimer_queue));
+  if(!etimer_expired(&next_timer) &&
+     etimer_expiration_time(&next_timer) ==
+     etimer_expiration_time(&c->etimer)) {
+    return;
+  }
+  PROCESS_CONTEXT_BEGIN(&ctimer_process);
+  if(timer_expired(&c->etimer.timer)) {
+    etimer_set(&next_timer, 0);
+  } else {
+    etimer_set(&next_timer, timer_remaining(&c->etimer.timer));
+  }
+  PROCESS_CONTEXT_END(&ctimer_process);
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_timer(struct ctimer *c)
+{
+  if(c->etimer.p != PROCESS_NONE &&
+     timerq_contains(&ctimer_queue, &c->etimer.entry)) {
+    now = clock_time();
+    timerq_remove(&ctimer_queue, &c->etimer.entry);
+  }
+  c->etimer.p = PROCESS_NONE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_timer(struct ctimer *c)
+{
+  now = clock_time();
+  c->etimer.p = &ctimer_process;
+  timerq_add(&ctimer_queue, &c->etimer.entry);
+  schedule_next();
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(ctimer_process, ev, data)
 {
   struct ctimer *c;
   PROCESS_BEGIN();
 
-  for(c = list_head(ctimer_list); c != NULL; c = c->next) {
-    etimer_set(&c->etimer, c->etimer.timer.interval);
-  }
   initialized = 1;
+  schedule_next();
 
   while(1) {
     PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_TIMER);
-    for(c = list_head(ctimer_list); c != NULL; c = c->next) {
-      if(&c->etimer == data) {
-	list_remove(ctimer_list, c);
-	PROCESS_CONTEXT_BEGIN(c->p);
-	if(c->f != NULL) {
-	  c->f(c->ptr);
-	}
-	PROCESS_CONTEXT_END(c->p);
-	break;
+    while(timerq_head(&ctimer_queue) != NULL) {
+      c = CTIMER(timerq_head(&ctimer_queue));
+      if(!timer_expired(&c->etimer.timer)) {
+        break;
+      }
+      remove_timer(c);
+      PROCESS_CONTEXT_BEGIN(c->p);
+      if(c->f != NULL) {
+        c->f(c->ptr);
       }
+      PROCESS_CONTEXT_END(c->p);
     }
+    schedule_next();
   }
   PROCESS_END();
 }
@@ -91,7 +157,6 @@ void
 ctimer_init(void)
 {
   initialized = 0;
-  list_init(ctimer_list);
   process_start(&ctimer_process, NULL);
 }
 /*---------------------------------------------------------------------------*/
@@ -107,69 +172,41 @@ ctimer_set_with_process(struct ctimer *c, clock_time_t t,
 	   void (*f)(void *), void *ptr, struct process *p)
 {
   PRINTF("ctimer_set %p %u\n", c, (unsigned)t);
+  remove_timer(c);
   c->p = p;
   c->f = f;
   c->ptr = ptr;
-  if(initialized) {
-    PROCESS_CONTEXT_BEGIN(&ctimer_process);
-    etimer_set(&c->etimer, t);
-    PROCESS_CONTEXT_END(&ctimer_process);
-  } else {
-    c->etimer.timer.interval = t;
-  }
-
-  list_add(ctimer_list, c);
+  timer_set(&c->etimer.timer, t);
+  add_timer(c);
 }
 /*---------------------------------------------------------------------------*/
 void
 ctimer_reset(struct ctimer *c)
 {
-  if(initialized) {
-    PROCESS_CONTEXT_BEGIN(&ctimer_process);
-    etimer_reset(&c->etimer);
-    PROCESS_CONTEXT_END(&ctimer_process);
-  }
-
-  list_add(ctimer_list, c);
+  remove_timer(c);
+  timer_reset(&c->etimer.timer);
+  add_timer(c);
 }
 /*---------------------------------------------------------------------------*/
 void
 ctimer_restart(struct ctimer *c)
 {
-  if(initialized) {
-    PROCESS_CONTEXT_BEGIN(&ctimer_process);
-    etimer_restart(&c->etimer);
-    PROCESS_CONTEXT_END(&ctimer_process);
-  }
-
-  list_add(ctimer_list, c);
+  remove_timer(c);
+  timer_restart(&c->etimer.timer);
+  add_timer(c);
 }
 /*---------------------------------------------------------------------------*/
 void
 ctimer_stop(struct ctimer *c)
 {
-  if(initialized) {
-    etimer_stop(&c->etimer);
-  } else {
-    c->etimer.next = NULL;
-    c->etimer.p = PROCESS_NONE;
-  }
-  list_remove(ctimer_list, c);
+  remove_timer(c);
+  schedule_next();
 }
 /*---------------------------------------------------------------------------*/
 int
 ctimer_expired(struct ctimer *c)
 {
-  struct ctimer *t;
-  if(initialized) {
-    return etimer_expired(&c->etimer);
-  }
-  for(t = list_head(ctimer_list); t != NULL; t = t->next) {
-    if(t == c) {
-      return 0;
-    }
-  }
-  return 1;
+  return c->etimer.p == PROCESS_NONE;
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -57,7 +57,6 @@
 #include "sys/etimer.h"
 
 struct ctimer {
-  struct ctimer *next;
   struct etimer etimer;
   struct process *p;
   void (*f)(void *);
@@ -38,6 +38,7 @@
  */
 
 #include "sys/energest.h"
+#include "sys/cc.h"
 #include "contiki-conf.h"
 
 #if ENERGEST_CONF_ON
@@ -113,6 +114,109 @@ energest_flush(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if ENERGEST_TRACE
+#if (ENERGEST_TRACE_SIZE & (ENERGEST_TRACE_SIZE - 1)) != 0
+#error ENERGEST_CONF_TRACE_SIZE must be a power of two
+#endif
+#if ENERGEST_TRACE_SIZE > 256
+#error ENERGEST_CONF_TRACE_SIZE must be at most 256
+#endif
+
+/*
+ * Records are added by energest_trace_record() from the main loop and
+ * from interrupts, and removed by a single reader. The check for a
+ * free slot, the store and the update of trace_put and trace_lost are
+ * made with interrupts disabled, so that a record made from an
+ * interrupt cannot take the same slot. As in lib/ringbuf.c, the reader
+ * only writes trace_get and trace_lost_read, so it needs no lock. The
+ * indices are uint8_t so that they are accessed atomically on most
+ * platforms, and one slot is kept free to tell a full ring from an
+ * empty one.
+ */
+#define TRACE_MASK (ENERGEST_TRACE_SIZE - 1)
+
+unsigned char energest_trace_on = 1;
+static struct energest_trace_entry trace[ENERGEST_TRACE_SIZE];
+static uint8_t trace_put, trace_get;
+static unsigned long trace_lost, trace_lost_read;
+/*---------------------------------------------------------------------------*/
+void
+energest_trace_record(uint8_t type, uint8_t on, rtimer_clock_t time,
+                      uint16_t arg)
+{
+  struct energest_trace_entry *e;
+  int int_state;
+
+  int_state = ENERGEST_TRACE_INT_DISABLE();
+  if(((trace_put - CC_ACCESS_NOW(uint8_t, trace_get)) & TRACE_MASK) ==
+     TRACE_MASK) {
+    /* Full: drop the new entry */
+    trace_lost++;
+  } else {
+    e = &trace[trace_put];
+    e->time = time;
+    e->type = type;
+    e->on = on;
+    e->arg = arg;
+    CC_MEMORY_BARRIER();
+    CC_ACCESS_NOW(uint8_t, trace_put) = (trace_put + 1) & TRACE_MASK;
+  }
+  ENERGEST_TRACE_INT_RESTORE(int_state);
+}
+/*---------------------------------------------------------------------------*/
+void
+energest_trace_mark(uint8_t mark, uint16_t arg)
+{
+  if(energest_trace_on) {
+    energest_trace_record(mark, 1, RTIMER_NOW(), arg);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+energest_trace_read(struct energest_trace_entry *e)
+{
+  if(CC_ACCESS_NOW(uint8_t, trace_put) == trace_get) {
+    return 0;
+  }
+  CC_MEMORY_BARRIER();
+  *e = trace[trace_get];
+  CC_MEMORY_BARRIER();
+  CC_ACCESS_NOW(uint8_t, trace_get) = (trace_get + 1) & TRACE_MASK;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+read_lost(void)
+{
+  unsigned long lost;
+
+  /* The counter may be wider than an atomic access, so read it until
+     two reads agree. */
+  do {
+    lost = CC_ACCESS_NOW(unsigned long, trace_lost);
+  } while(lost != CC_ACCESS_NOW(unsigned long, trace_lost));
+  return lost;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+energest_trace_lost(void)
+{
+  unsigned long lost;
+
+  lost = read_lost();
+  lost -= trace_lost_read;
+  trace_lost_read += lost;
+  return lost;
+}
+/*---------------------------------------------------------------------------*/
+void
+energest_trace_reset(void)
+{
+  CC_ACCESS_NOW(uint8_t, trace_get) = CC_ACCESS_NOW(uint8_t, trace_put);
+  trace_lost_read = read_lost();
+}
+#endif /* ENERGEST_TRACE */
+/*---------------------------------------------------------------------------*/
 #else /* ENERGEST_CONF_ON */
 void energest_type_set(int type, unsigned long val) {}
 void energest_init(void) {}
@@ -75,6 +75,81 @@ unsigned long energest_leveldevice_leveltime(int powerlevel);
 void energest_type_set(int type, unsigned long value);
 void energest_flush(void);
 
+/*
+ * Optional high-resolution trace of state transitions. When
+ * ENERGEST_CONF_TRACE is set, every ENERGEST_ON/OFF/SWITCH also
+ * stores a timestamped record in a RAM ring of
+ * ENERGEST_CONF_TRACE_SIZE entries (a power of two, at most 256, one
+ * of which is kept free). New records are dropped when the ring is
+ * full and counted as lost. Records may be added from interrupt
+ * context while the ring is being read, as long as the platform
+ * defines ENERGEST_CONF_TRACE_INT_DISABLE (see below).
+ * Link layers may add marks (ENERGEST_TRACE_MARK) so that a host
+ * tool can attribute radio on-time to individual packets; see
+ * tools/powertrace/parse-energest-trace.
+ */
+#if defined(ENERGEST_CONF_TRACE) && ENERGEST_CONF_ON
+#define ENERGEST_TRACE ENERGEST_CONF_TRACE
+#else
+#define ENERGEST_TRACE 0
+#endif
+
+#ifdef ENERGEST_CONF_TRACE_SIZE
+#define ENERGEST_TRACE_SIZE ENERGEST_CONF_TRACE_SIZE
+#else
+#define ENERGEST_TRACE_SIZE 64
+#endif
+
+/*
+ * Interrupt masking around the reservation and store of a record.
+ * ENERGEST_CONF_TRACE_INT_DISABLE() disables interrupts and returns
+ * the previous interrupt state, which is passed to
+ * ENERGEST_CONF_TRACE_INT_RESTORE(). Without them, a record made from
+ * an interrupt that preempts another record may overwrite it.
+ */
+#ifdef ENERGEST_CONF_TRACE_INT_DISABLE
+#define ENERGEST_TRACE_INT_DISABLE()  ENERGEST_CONF_TRACE_INT_DISABLE()
+#define ENERGEST_TRACE_INT_RESTORE(s) ENERGEST_CONF_TRACE_INT_RESTORE(s)
+#else
+#define ENERGEST_TRACE_INT_DISABLE()  0
+#define ENERGEST_TRACE_INT_RESTORE(s) ((void)(s))
+#endif
+
+/* Mark types, numbered above the energest types */
+#define ENERGEST_TRACE_MARK_TX_START 0x80 /* arg: MAC sequence number */
+#define ENERGEST_TRACE_MARK_TX_DONE  0x81 /* arg: seqno | (status << 8) */
+#define ENERGEST_TRACE_MARK_RX       0x82 /* arg: MAC sequence number */
+
+struct energest_trace_entry {
+  rtimer_clock_t time;
+  uint16_t arg;
+  uint8_t type;
+  uint8_t on;
+};
+
+#if ENERGEST_TRACE
+extern unsigned char energest_trace_on;
+
+void energest_trace_record(uint8_t type, uint8_t on, rtimer_clock_t time,
+                           uint16_t arg);
+void energest_trace_mark(uint8_t mark, uint16_t arg);
+/* Pop the oldest entry into *e. Returns 0 when the ring is empty. */
+int energest_trace_read(struct energest_trace_entry *e);
+/* Number of entries dropped since the last call. */
+unsigned long energest_trace_lost(void);
+void energest_trace_reset(void);
+
+#define ENERGEST_TRACE_RECORD(type, on, time) do { \
+    if(energest_trace_on) { \
+      energest_trace_record((type), (on), (time), 0); \
+    } \
+  } while(0)
+#define ENERGEST_TRACE_MARK(mark, arg) energest_trace_mark((mark), (arg))
+#else /* ENERGEST_TRACE */
+#define ENERGEST_TRACE_RECORD(type, on, time) do { } while(0)
+#define ENERGEST_TRACE_MARK(mark, arg) do { } while(0)
+#endif /* ENERGEST_TRACE */
+
 #if ENERGEST_CONF_ON
 /*extern int energest_total_count;*/
 extern energest_t energest_total_time[ENERGEST_TYPE_MAX];
@@ -89,6 +164,7 @@ extern energest_t energest_leveldevice_current_leveltime[ENERGEST_CONF_LEVELDEVI
                            /*++energest_total_count;*/ \
                            energest_current_time[type] = RTIMER_NOW(); \
 			   energest_current_mode[type] = 1; \
+                           ENERGEST_TRACE_RECORD(type, 1, energest_current_time[type]); \
                            } while(0)
 #ifdef __AVR__
 /* Handle 16 bit rtimer wraparound */
@@ -97,6 +173,7 @@ extern energest_t energest_leveldevice_current_leveltime[ENERGEST_CONF_LEVELDEVI
 							energest_total_time[type].current += (rtimer_clock_t)(RTIMER_NOW() - \
 							energest_current_time[type]); \
 							energest_current_mode[type] = 0; \
+							ENERGEST_TRACE_RECORD(type, 0, RTIMER_NOW()); \
                            } while(0)
 
 #define ENERGEST_OFF_LEVEL(type,level) do { \
@@ -104,6 +181,7 @@ extern energest_t energest_leveldevice_current_leveltime[ENERGEST_CONF_LEVELDEVI
 										energest_leveldevice_current_leveltime[level].current += (rtimer_clock_t)(RTIMER_NOW() - \
 										energest_current_time[type]); \
 										energest_current_mode[type] = 0; \
+										ENERGEST_TRACE_RECORD(type, 0, RTIMER_NOW()); \
                                        } while(0)
 
 #define ENERGEST_SWITCH(type_off, type_on) do { \
@@ -115,9 +193,11 @@ extern energest_t energest_leveldevice_current_leveltime[ENERGEST_CONF_LEVELDEVI
                                                energest_total_time[type_off].current += (rtimer_clock_t)(energest_local_variable_now - \
                                                  energest_current_time[type_off]); \
                                                energest_current_mode[type_off] = 0; \
+                                               ENERGEST_TRACE_RECORD(type_off, 0, energest_local_variable_now); \
                                              } \
                                              energest_current_time[type_on] = energest_local_variable_now; \
                                              energest_current_mode[type_on] = 1; \
+                                             ENERGEST_TRACE_RECORD(type_on, 1, energest_local_variable_now); \
                                            } while(0)
 
 #else
@@ -125,12 +205,14 @@ extern energest_t energest_leveldevice_current_leveltime[ENERGEST_CONF_LEVELDEVI
                            energest_total_time[type].current += (rtimer_clock_t)(RTIMER_NOW() - \
                            energest_current_time[type]); \
 			   energest_current_mode[type] = 0; \
+                           ENERGEST_TRACE_RECORD(type, 0, RTIMER_NOW()); \
                            } while(0)
 
 #define ENERGEST_OFF_LEVEL(type,level) do { \
                                         energest_leveldevice_current_leveltime[level].current += (rtimer_clock_t)(RTIMER_NOW() - \
 			                energest_current_time[type]); \
 			   energest_current_mode[type] = 0; \
+                                        ENERGEST_TRACE_RECORD(type, 0, RTIMER_NOW()); \
                                         } while(0)
 
 #define ENERGEST_SWITCH(type_off, type_on) do { \
@@ -139,9 +221,11 @@ extern energest_t energest_leveldevice_current_leveltime[ENERGEST_CONF_LEVELDEVI
                                                energest_total_time[type_off].current += (rtimer_clock_t)(energest_local_variable_now - \
                                                  energest_current_time[type_off]); \
                                                energest_current_mode[type_off] = 0; \
+                                               ENERGEST_TRACE_RECORD(type_off, 0, energest_local_variable_now); \
                                              } \
                                              energest_current_time[type_on] = energest_local_variable_now; \
                                              energest_current_mode[type_on] = 1; \
+                                             ENERGEST_TRACE_RECORD(type_on, 1, energest_local_variable_now); \
                                            } while(0)
 #endif
 
@@ -49,95 +49,115 @@
 #include "sys/etimer.h"
 #include "sys/process.h"
 
-static struct etimer *timerlist;
+/*
+ * Pending timers are kept in a timer deadline queue ordered by
+ * expiration time, so that the next timer to expire is always at the
+ * head of the queue.
+ */
+static int timer_before(struct timerq_entry *a, struct timerq_entry *b);
+TIMERQ(timerqueue, timer_before);
 static clock_time_t next_expiration;
+/* The time that queue comparisons are made against. */
+static clock_time_t now;
+
+#define ETIMER(e) TIMERQ_ELEMENT(e, struct etimer, entry)
 
 PROCESS(etimer_process, "Event timer");
 /*---------------------------------------------------------------------------*/
+static int
+timer_before(struct timerq_entry *a, struct timerq_entry *b)
+{
+  return timer_expires_before(&ETIMER(a)->timer, &ETIMER(b)->timer, now);
+}
+/*---------------------------------------------------------------------------*/
+static int
+in_queue(struct etimer *t)
+{
+  return t->p != PROCESS_NONE && timerq_contains(&timerqueue, &t->entry);
+}
+/*---------------------------------------------------------------------------*/
+static void
+queue_add(struct etimer *t)
+{
+  now = clock_time();
+  timerq_add(&timerqueue, &t->entry);
+}
+/*---------------------------------------------------------------------------*/
+static void
+queue_remove(struct etimer *t)
+{
+  now = clock_time();
+  timerq_remove(&timerqueue, &t->entry);
+}
+/*---------------------------------------------------------------------------*/
+static struct etimer *
+find_process_timer(struct process *p)
+{
+  struct timerq_entry *e;
+
+  for(e = timerq_walk(&timerqueue, NULL); e != NULL;
+      e = timerq_walk(&timerqueue, e)) {
+    if(ETIMER(e)->p == p) {
+      return ETIMER(e);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 static void
 update_time(void)
 {
-  clock_time_t tdist;
-  clock_time_t now;
-  struct etimer *t;
+  struct timerq_entry *head;
 
-  if (timerlist == NULL) {
+  head = timerq_head(&timerqueue);
+  if(head == NULL) {
     next_expiration = 0;
   } else {
-    now = clock_time();
-    t = timerlist;
-    /* Must calculate distance to next time into account due to wraps */
-    tdist = t->timer.start + t->timer.interval - now;
-    for(t = t->next; t != NULL; t = t->next) {
-      if(t->timer.start + t->timer.interval - now < tdist) {
-	tdist = t->timer.start + t->timer.interval - now;
-      }
-    }
-    next_expiration = now + tdist;
+    next_expiration = etimer_expiration_time(ETIMER(head));
   }
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(etimer_process, ev, data)
 {
-  struct etimer *t, *u;
-	
+  struct etimer *t;
+
   PROCESS_BEGIN();
 
-  timerlist = NULL;
-  
+  timerq_init(&timerqueue);
+
   while(1) {
     PROCESS_YIELD();
 
     if(ev == PROCESS_EVENT_EXITED) {
       struct process *p = data;
 
-      while(timerlist != NULL && timerlist->p == p) {
-	timerlist = timerlist->next;
-      }
-
-      if(timerlist != NULL) {
-	t = timerlist;
-	while(t->next != NULL) {
-	  if(t->next->p == p) {
-	    t->next = t->next->next;
-	  } else
-	    t = t->next;
-	}
+      while((t = find_process_timer(p)) != NULL) {
+	queue_remove(t);
       }
+      update_time();
       continue;
     } else if(ev != PROCESS_EVENT_POLL) {
       continue;
     }
 
-  again:
-    
-    u = NULL;
-    
-    for(t = timerlist; t != NULL; t = t->next) {
-      if(timer_expired(&t->timer)) {
-	if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
-	  
-	  /* Reset the process ID of the event timer, to signal that the
-	     etimer has expired. This is later checked in the
-	     etimer_expired() function. */
-	  t->p = PROCESS_NONE;
-	  if(u != NULL) {
-	    u->next = t->next;
-	  } else {
-	    timerlist = t->next;
-	  }
-	  t->next = NULL;
-	  update_time();
-	  goto again;
-	} else {
-	  etimer_request_poll();
-	}
+    while(timerq_head(&timerqueue) != NULL &&
+          timer_expired(&ETIMER(timerq_head(&timerqueue))->timer)) {
+      t = ETIMER(timerq_head(&timerqueue));
+      if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
+
+	/* Reset the process ID of the event timer, to signal that the
+	   etimer has expired. This is later checked in the
+	   etimer_expired() function. */
+	queue_remove(t);
+	t->p = PROCESS_NONE;
+      } else {
+	etimer_request_poll();
+	break;
       }
-      u = t;
     }
-    
+    update_time();
   }
-  
+
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
@@ -150,25 +170,16 @@ etimer_request_poll(void)
 static void
 add_timer(struct etimer *timer)
 {
-  struct etimer *t;
-
   etimer_request_poll();
 
-  if(timer->p != PROCESS_NONE) {
-    for(t = timerlist; t != NULL; t = t->next) {
-      if(t == timer) {
-	/* Timer already on list, bail out. */
-        timer->p = PROCESS_CURRENT();
-	update_time();
-	return;
-      }
-    }
+  if(in_queue(timer)) {
+    /* Timer already in the queue: its expiration time may have
+       changed, so take it out and insert it again. */
+    queue_remove(timer);
   }
 
-  /* Timer not on list. */
   timer->p = PROCESS_CURRENT();
-  timer->next = timerlist;
-  timerlist = timer;
+  queue_add(timer);
 
   update_time();
 }
@@ -205,7 +216,13 @@ etimer_restart(struct etimer *et)
 void
 etimer_adjust(struct etimer *et, int timediff)
 {
-  et->timer.start += timediff;
+  if(in_queue(et)) {
+    queue_remove(et);
+    et->timer.start += timediff;
+    queue_add(et);
+  } else {
+    et->timer.start += timediff;
+  }
   update_time();
 }
 /*---------------------------------------------------------------------------*/
@@ -230,7 +247,7 @@ etimer_start_time(struct etimer *et)
 int
 etimer_pending(void)
 {
-  return timerlist != NULL;
+  return timerq_head(&timerqueue) != NULL;
 }
 /*---------------------------------------------------------------------------*/
 clock_time_t
@@ -242,29 +259,11 @@ etimer_next_expiration_time(void)
 void
 etimer_stop(struct etimer *et)
 {
-  struct etimer *t;
-
-  /* First check if et is the first event timer on the list. */
-  if(et == timerlist) {
-    timerlist = timerlist->next;
+  if(in_queue(et)) {
+    queue_remove(et);
     update_time();
-  } else {
-    /* Else walk through the list and try to find the item before the
-       et timer. */
-    for(t = timerlist; t != NULL && t->next != et; t = t->next);
-
-    if(t != NULL) {
-      /* We've found the item before the event timer that we are about
-	 to remove. We point the items next pointer to the event after
-	 the removed item. */
-      t->next = et->next;
-
-      update_time();
-    }
   }
 
-  /* Remove the next pointer from the item to be removed. */
-  et->next = NULL;
   /* Set the timer as expired */
   et->p = PROCESS_NONE;
 }
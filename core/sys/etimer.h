@@ -63,6 +63,7 @@
 #define ETIMER_H_
 
 #include "sys/timer.h"
+#include "sys/timerq.h"
 #include "sys/process.h"
 
 /**
@@ -75,7 +76,7 @@
  */
 struct etimer {
   struct timer timer;
-  struct etimer *next;
+  struct timerq_entry entry;
   struct process *p;
 };
 
@@ -46,8 +46,19 @@
 #include "sys/mt.h"
 #include "sys/cc.h"
 
+#include <stddef.h>
+
 static struct mt_thread *current;
 
+#ifdef MTARCH_CURRENT
+/* The architecture may run several threads at once, in which case it
+   knows which one is calling. */
+#define CURRENT() ((struct mt_thread *)((char *)MTARCH_CURRENT() - \
+                                        offsetof(struct mt_thread, thread)))
+#else /* MTARCH_CURRENT */
+#define CURRENT() current
+#endif /* MTARCH_CURRENT */
+
 /*--------------------------------------------------------------------------*/
 void
 mt_init(void)
@@ -97,7 +108,7 @@ void
 mt_exit(void)
 {
   mtarch_pstop();
-  current->state = MT_STATE_EXITED;
+  CURRENT()->state = MT_STATE_EXITED;
   mtarch_yield();
 }
 /*--------------------------------------------------------------------------*/
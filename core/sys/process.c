@@ -47,6 +47,10 @@
 
 #include "sys/process.h"
 #include "sys/arg.h"
+#if PROCESS_PROFILE
+#include "sys/rtimer.h"
+#include <string.h>
+#endif /* PROCESS_PROFILE */
 
 /*
  * Pointer to the currently running process structure.
@@ -65,11 +69,35 @@ struct event_data {
   struct process *p;
 };
 
-static process_num_events_t nevents, fevent;
-static struct event_data events[PROCESS_CONF_NUMEVENTS];
+/*
+ * One event queue per priority level. The total number of pending
+ * events is kept in nevents.
+ */
+struct event_queue {
+  process_num_events_t nevents, fevent;
+  struct event_data events[PROCESS_CONF_NUMEVENTS];
+};
+
+static process_num_events_t nevents;
+static struct event_queue queues[PROCESS_PRIORITIES];
+
+#if PROCESS_PRIORITIES > 1
+#define PRIORITY(p) ((p) == PROCESS_BROADCAST ? PROCESS_PRIORITY_NORMAL : \
+                     (p)->priority)
+#else /* PROCESS_PRIORITIES > 1 */
+#define PRIORITY(p) 0
+#endif /* PROCESS_PRIORITIES > 1 */
+
+#if PROCESS_SUBSCRIPTIONS
+/* Subscriptions are hashed on the event number. */
+#define SUBSCRIPTION_BUCKETS 8
+static struct process_subscription *subscriptions[SUBSCRIPTION_BUCKETS];
+#define BUCKET(ev) (&subscriptions[(ev) % SUBSCRIPTION_BUCKETS])
+#endif /* PROCESS_SUBSCRIPTIONS */
 
 #if PROCESS_CONF_STATS
 process_num_events_t process_maxevents;
+unsigned short process_droppedevents[PROCESS_PRIORITIES];
 #endif
 
 static volatile unsigned char poll_requested;
@@ -119,6 +147,25 @@ process_start(struct process *p, process_data_t data)
   /* Post a synchronous initialization event to the process. */
   process_post_synch(p, PROCESS_EVENT_INIT, data);
 }
+#if PROCESS_SUBSCRIPTIONS
+/*---------------------------------------------------------------------------*/
+static void
+remove_subscriptions(struct process *p)
+{
+  struct process_subscription **s;
+  int i;
+
+  for(i = 0; i < SUBSCRIPTION_BUCKETS; i++) {
+    for(s = &subscriptions[i]; *s != NULL;) {
+      if((*s)->p == p) {
+        *s = (*s)->next;
+      } else {
+        s = &(*s)->next;
+      }
+    }
+  }
+}
+#endif /* PROCESS_SUBSCRIPTIONS */
 /*---------------------------------------------------------------------------*/
 static void
 exit_process(struct process *p, struct process *fromprocess)
@@ -150,6 +197,10 @@ exit_process(struct process *p, struct process *fromprocess)
       }
     }
 
+#if PROCESS_SUBSCRIPTIONS
+    remove_subscriptions(p);
+#endif /* PROCESS_SUBSCRIPTIONS */
+
     if(p->thread != NULL && p != fromprocess) {
       /* Post the exit event to the process that is about to exit. */
       process_current = p;
@@ -171,10 +222,19 @@ exit_process(struct process *p, struct process *fromprocess)
   process_current = old_current;
 }
 /*---------------------------------------------------------------------------*/
+#if PROCESS_PROFILE
+/* Time spent in processes called from within the current call, which
+   is subtracted from the time of the current process. */
+static rtimer_clock_t nested_ticks;
+#endif /* PROCESS_PROFILE */
+/*---------------------------------------------------------------------------*/
 static void
 call_process(struct process *p, process_event_t ev, process_data_t data)
 {
   int ret;
+#if PROCESS_PROFILE
+  rtimer_clock_t start, elapsed, self, outer_nested;
+#endif /* PROCESS_PROFILE */
 
 #if DEBUG
   if(p->state == PROCESS_STATE_CALLED) {
@@ -187,7 +247,26 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event %d\n", PROCESS_NAME_STRING(p), ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+#if PROCESS_PROFILE
+    outer_nested = nested_ticks;
+    nested_ticks = 0;
+    start = RTIMER_NOW();
+#endif /* PROCESS_PROFILE */
     ret = p->thread(&p->pt, ev, data);
+#if PROCESS_PROFILE
+    elapsed = RTIMER_NOW() - start;
+    self = elapsed - nested_ticks;
+    nested_ticks = outer_nested + elapsed;
+    p->profile.calls++;
+    if(ev != PROCESS_EVENT_POLL) {
+      p->profile.received++;
+    }
+    p->profile.ticks += self;
+    if(self > p->profile.max_ticks) {
+      p->profile.max_ticks = self;
+      p->profile.max_event = ev;
+    }
+#endif /* PROCESS_PROFILE */
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -207,12 +286,25 @@ process_exit(struct process *p)
 void
 process_init(void)
 {
+  int i;
+
   lastevent = PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  nevents = 0;
+  for(i = 0; i < PROCESS_PRIORITIES; i++) {
+    queues[i].nevents = queues[i].fevent = 0;
+#if PROCESS_CONF_STATS
+    process_droppedevents[i] = 0;
+#endif /* PROCESS_CONF_STATS */
+  }
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
 #endif /* PROCESS_CONF_STATS */
+#if PROCESS_SUBSCRIPTIONS
+  for(i = 0; i < SUBSCRIPTION_BUCKETS; i++) {
+    subscriptions[i] = NULL;
+  }
+#endif /* PROCESS_SUBSCRIPTIONS */
 
   process_current = process_list = NULL;
 }
@@ -226,12 +318,16 @@ do_poll(void)
 {
   struct process *p;
 
+  PROCESS_LOCK();
   poll_requested = 0;
+  PROCESS_UNLOCK();
   /* Call the processes that needs to be polled. */
   for(p = process_list; p != NULL; p = p->next) {
     if(p->needspoll) {
       p->state = PROCESS_STATE_RUNNING;
+      PROCESS_LOCK();
       p->needspoll = 0;
+      PROCESS_UNLOCK();
       call_process(p, PROCESS_EVENT_POLL, NULL);
     }
   }
@@ -248,7 +344,12 @@ do_event(void)
   process_event_t ev;
   process_data_t data;
   struct process *receiver;
+  struct event_queue *q;
   struct process *p;
+  int subscribers;
+#if PROCESS_SUBSCRIPTIONS
+  struct process_subscription *s, *next;
+#endif /* PROCESS_SUBSCRIPTIONS */
   
   /*
    * If there are any events in the queue, take the first one and walk
@@ -259,29 +360,58 @@ do_event(void)
    */
 
   if(nevents > 0) {
+
+    PROCESS_LOCK();
+
+    /* Take the event from the highest priority queue that has one. */
+    q = &queues[PROCESS_PRIORITIES - 1];
+    while(q->nevents == 0) {
+      --q;
+    }
     
     /* There are events that we should deliver. */
-    ev = events[fevent].ev;
+    ev = q->events[q->fevent].ev;
     
-    data = events[fevent].data;
-    receiver = events[fevent].p;
+    data = q->events[q->fevent].data;
+    receiver = q->events[q->fevent].p;
 
     /* Since we have seen the new event, we move pointer upwards
        and decrease the number of events. */
-    fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    q->fevent = (q->fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    --q->nevents;
     --nevents;
 
+    PROCESS_UNLOCK();
+
     /* If this is a broadcast event, we deliver it to all events, in
        order of their priority. */
     if(receiver == PROCESS_BROADCAST) {
-      for(p = process_list; p != NULL; p = p->next) {
-
-	/* If we have been requested to poll a process, we do this in
-	   between processing the broadcast event. */
+      subscribers = 0;
+#if PROCESS_SUBSCRIPTIONS
+      /* If any process subscribed to the event, only the subscribers
+	 get it. */
+      for(s = *BUCKET(ev); s != NULL; s = next) {
+	next = s->next;
+	if(s->ev != ev) {
+	  continue;
+	}
 	if(poll_requested) {
 	  do_poll();
 	}
-	call_process(p, ev, data);
+	call_process(s->p, ev, data);
+	subscribers++;
+      }
+#endif /* PROCESS_SUBSCRIPTIONS */
+      if(subscribers == 0) {
+	for(p = process_list; p != NULL; p = p->next) {
+
+	  /* If we have been requested to poll a process, we do this in
+	     between processing the broadcast event. */
+	  if(poll_requested) {
+	    do_poll();
+	  }
+	  call_process(p, ev, data);
+	}
       }
     } else {
       /* This is not a broadcast event, so we deliver it to the
@@ -322,6 +452,7 @@ int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
   process_num_events_t snum;
+  struct event_queue *q;
 
   if(PROCESS_CURRENT() == NULL) {
     PRINTF("process_post: NULL process posts event %d to process '%s', nevents %d\n",
@@ -332,7 +463,13 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
 	   p == PROCESS_BROADCAST? "<broadcast>": PROCESS_NAME_STRING(p), nevents);
   }
   
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  PROCESS_LOCK();
+  q = &queues[PRIORITY(p)];
+  if(q->nevents == PROCESS_CONF_NUMEVENTS) {
+#if PROCESS_CONF_STATS
+    process_droppedevents[PRIORITY(p)]++;
+#endif /* PROCESS_CONF_STATS */
+    PROCESS_UNLOCK();
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, PROCESS_NAME_STRING(process_current));
@@ -343,21 +480,35 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
     return PROCESS_ERR_FULL;
   }
   
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
-  events[snum].ev = ev;
-  events[snum].data = data;
-  events[snum].p = p;
+  snum = (process_num_events_t)(q->fevent + q->nevents) % PROCESS_CONF_NUMEVENTS;
+  q->events[snum].ev = ev;
+  q->events[snum].data = data;
+  q->events[snum].p = p;
+  ++q->nevents;
   ++nevents;
 
+#if PROCESS_PROFILE
+  if(process_current != NULL) {
+    process_current->profile.posted++;
+  }
+#endif /* PROCESS_PROFILE */
+
 #if PROCESS_CONF_STATS
   if(nevents > process_maxevents) {
     process_maxevents = nevents;
   }
 #endif /* PROCESS_CONF_STATS */
+  PROCESS_UNLOCK();
   
   return PROCESS_ERR_OK;
 }
 /*---------------------------------------------------------------------------*/
+int
+process_post_space(struct process *p)
+{
+  return PROCESS_CONF_NUMEVENTS - queues[PRIORITY(p)].nevents;
+}
+/*---------------------------------------------------------------------------*/
 void
 process_post_synch(struct process *p, process_event_t ev, process_data_t data)
 {
@@ -373,8 +524,10 @@ process_poll(struct process *p)
   if(p != NULL) {
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
+      PROCESS_LOCK();
       p->needspoll = 1;
       poll_requested = 1;
+      PROCESS_UNLOCK();
     }
   }
 }
@@ -384,5 +537,90 @@ process_is_running(struct process *p)
 {
   return p->state != PROCESS_STATE_NONE;
 }
+#if PROCESS_PRIORITIES > 1
+/*---------------------------------------------------------------------------*/
+void
+process_set_priority(struct process *p, unsigned char priority)
+{
+  if(priority > PROCESS_PRIORITY_HIGH) {
+    priority = PROCESS_PRIORITY_HIGH;
+  }
+  p->priority = priority;
+}
+#endif /* PROCESS_PRIORITIES > 1 */
+#if PROCESS_SUBSCRIPTIONS
+/*---------------------------------------------------------------------------*/
+void
+process_subscribe(struct process_subscription *s, process_event_t ev)
+{
+  s->p = PROCESS_CURRENT();
+  s->ev = ev;
+  s->next = *BUCKET(ev);
+  *BUCKET(ev) = s;
+}
+/*---------------------------------------------------------------------------*/
+void
+process_unsubscribe(struct process_subscription *s)
+{
+  struct process_subscription **sp;
+
+  for(sp = BUCKET(s->ev); *sp != NULL; sp = &(*sp)->next) {
+    if(*sp == s) {
+      *sp = s->next;
+      break;
+    }
+  }
+}
+#endif /* PROCESS_SUBSCRIPTIONS */
+/*---------------------------------------------------------------------------*/
+#if PROCESS_PROFILE
+/*---------------------------------------------------------------------------*/
+void
+process_profile_reset(void)
+{
+  struct process *p;
+
+  for(p = process_list; p != NULL; p = p->next) {
+    memset(&p->profile, 0, sizeof(p->profile));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put_uint32(uint8_t *buf, unsigned long v)
+{
+  buf[0] = v;
+  buf[1] = v >> 8;
+  buf[2] = v >> 16;
+  buf[3] = v >> 24;
+  return buf + 4;
+}
+/*---------------------------------------------------------------------------*/
+int
+process_profile_header(uint8_t *buf)
+{
+  buf[0] = 'P';
+  buf[1] = 'P';
+  buf[2] = 1;
+  buf[3] = PROCESS_PROFILE_RECORD_SIZE;
+  put_uint32(&buf[4], RTIMER_SECOND);
+  return PROCESS_PROFILE_HEADER_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+int
+process_profile_record(struct process *p, uint8_t *buf)
+{
+  uint8_t *ptr;
+
+  memset(buf, 0, PROCESS_PROFILE_NAME_LEN);
+  strncpy((char *)buf, PROCESS_NAME_STRING(p), PROCESS_PROFILE_NAME_LEN);
+  ptr = put_uint32(buf + PROCESS_PROFILE_NAME_LEN, p->profile.calls);
+  ptr = put_uint32(ptr, p->profile.received);
+  ptr = put_uint32(ptr, p->profile.posted);
+  ptr = put_uint32(ptr, p->profile.ticks);
+  ptr = put_uint32(ptr, p->profile.max_ticks);
+  put_uint32(ptr, p->profile.max_event);
+  return PROCESS_PROFILE_RECORD_SIZE;
+}
 /*---------------------------------------------------------------------------*/
+#endif /* PROCESS_PROFILE */
 /** @} */
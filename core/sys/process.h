@@ -88,6 +88,70 @@ typedef unsigned char process_num_events_t;
 #define PROCESS_CONF_NUMEVENTS 32
 #endif /* PROCESS_CONF_NUMEVENTS */
 
+/**
+ * The number of event priority levels. Each level has an event queue
+ * of PROCESS_CONF_NUMEVENTS events, and events are dispatched from the
+ * highest level that has pending events. An event is queued at the
+ * priority of the process it is posted to, broadcast events at
+ * PROCESS_PRIORITY_NORMAL.
+ */
+#ifdef PROCESS_CONF_PRIORITIES
+#define PROCESS_PRIORITIES PROCESS_CONF_PRIORITIES
+#else /* PROCESS_CONF_PRIORITIES */
+#define PROCESS_PRIORITIES 1
+#endif /* PROCESS_CONF_PRIORITIES */
+
+#define PROCESS_PRIORITY_NORMAL 0
+#define PROCESS_PRIORITY_HIGH   (PROCESS_PRIORITIES - 1)
+
+/**
+ * If set, a broadcast event that any process subscribed to with
+ * process_subscribe() is only delivered to its subscribers, instead
+ * of to every process in the system. Events without subscribers,
+ * such as serial_line_event_message and sensors_event for the
+ * in-tree listeners that never subscribe, still go to every process.
+ */
+#ifdef PROCESS_CONF_SUBSCRIPTIONS
+#define PROCESS_SUBSCRIPTIONS PROCESS_CONF_SUBSCRIPTIONS
+#else /* PROCESS_CONF_SUBSCRIPTIONS */
+#define PROCESS_SUBSCRIPTIONS 0
+#endif /* PROCESS_CONF_SUBSCRIPTIONS */
+
+/**
+ * Per-process execution profiling.
+ *
+ * With PROCESS_CONF_PROFILE set to 1, every process keeps a struct
+ * process_profile with the number of times it was called, the number
+ * of events it received and posted, and the time spent in it,
+ * measured in rtimer ticks. Time spent in processes that are called
+ * synchronously from within a process is accounted to those
+ * processes only. The numbers can be read directly from the process
+ * structures or serialized with process_profile_record().
+ */
+#ifdef PROCESS_CONF_PROFILE
+#define PROCESS_PROFILE PROCESS_CONF_PROFILE
+#else /* PROCESS_CONF_PROFILE */
+#define PROCESS_PROFILE 0
+#endif /* PROCESS_CONF_PROFILE */
+
+/**
+ * Lock hooks for the event queue.
+ *
+ * On platforms where code outside of the Contiki main loop may call
+ * process_post() or process_poll() concurrently, such as mt threads
+ * that run on POSIX threads on the native platform, the platform can
+ * define PROCESS_CONF_LOCK() and PROCESS_CONF_UNLOCK() to a mutex
+ * that protects the event queue and the poll flags. They default to
+ * nothing.
+ */
+#ifdef PROCESS_CONF_LOCK
+#define PROCESS_LOCK()   PROCESS_CONF_LOCK()
+#define PROCESS_UNLOCK() PROCESS_CONF_UNLOCK()
+#else /* PROCESS_CONF_LOCK */
+#define PROCESS_LOCK()
+#define PROCESS_UNLOCK()
+#endif /* PROCESS_CONF_LOCK */
+
 #define PROCESS_EVENT_NONE            0x80
 #define PROCESS_EVENT_INIT            0x81
 #define PROCESS_EVENT_POLL            0x82
@@ -312,6 +376,23 @@ static PT_THREAD(process_thread_##name(struct pt *process_pt,	\
 
 /** @} */
 
+#if PROCESS_PROFILE
+struct process_profile {
+  /** Number of times the process was called, for any reason. */
+  unsigned long calls;
+  /** Number of events other than polls that the process received. */
+  unsigned long received;
+  /** Number of events that the process posted. */
+  unsigned long posted;
+  /** Total time spent in the process, in rtimer ticks. */
+  unsigned long ticks;
+  /** Longest single call of the process, in rtimer ticks. */
+  unsigned long max_ticks;
+  /** The event that the longest call handled. */
+  process_event_t max_event;
+};
+#endif /* PROCESS_PROFILE */
+
 struct process {
   struct process *next;
 #if PROCESS_CONF_NO_PROCESS_NAMES
@@ -323,6 +404,22 @@ struct process {
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
   unsigned char state, needspoll;
+#if PROCESS_PRIORITIES > 1
+  unsigned char priority;
+#endif /* PROCESS_PRIORITIES > 1 */
+#if PROCESS_PROFILE
+  struct process_profile profile;
+#endif /* PROCESS_PROFILE */
+};
+
+/**
+ * A subscription of a process to a broadcast event, see
+ * process_subscribe().
+ */
+struct process_subscription {
+  struct process_subscription *next;
+  struct process *p;
+  process_event_t ev;
 };
 
 /**
@@ -348,7 +445,9 @@ CCIF void process_start(struct process *p, process_data_t data);
  * processes. The handing of the event is deferred until the target
  * process is scheduled by the kernel. An event can be broadcast to
  * all processes, in which case all processes in the system will be
- * scheduled to handle the event.
+ * scheduled to handle the event, or only the processes that
+ * subscribed to it if PROCESS_CONF_SUBSCRIPTIONS is set and it has
+ * any subscribers.
  *
  * \param ev The event to be posted.
  *
@@ -452,6 +551,53 @@ process_current = p
  */
 CCIF process_event_t process_alloc_event(void);
 
+#if PROCESS_PRIORITIES > 1
+/**
+ * Set the priority of a process.
+ *
+ * Events posted to a process are queued at its priority, and events
+ * of a higher priority are always delivered first. The default
+ * priority is PROCESS_PRIORITY_NORMAL.
+ *
+ * \param p The process.
+ * \param priority The priority, from PROCESS_PRIORITY_NORMAL to
+ * PROCESS_PRIORITY_HIGH.
+ */
+void process_set_priority(struct process *p, unsigned char priority);
+#else /* PROCESS_PRIORITIES > 1 */
+#define process_set_priority(p, priority)
+#endif /* PROCESS_PRIORITIES > 1 */
+
+/**
+ * Number of events that can still be posted to a process.
+ *
+ * Producers of many events can use this function to back off
+ * before the event queue is full.
+ *
+ * \param p The process, or PROCESS_BROADCAST.
+ *
+ * \return The number of free slots in the event queue that events to
+ * the process are posted to.
+ */
+int process_post_space(struct process *p);
+
+#if PROCESS_SUBSCRIPTIONS
+/**
+ * Subscribe the current process to a broadcast event.
+ *
+ * \param s A subscription structure that must be kept until the
+ * subscription is removed.
+ * \param ev The broadcast event.
+ */
+void process_subscribe(struct process_subscription *s, process_event_t ev);
+
+/**
+ * Remove a subscription that was made with process_subscribe().
+ * Subscriptions are removed automatically when a process exits.
+ */
+void process_unsubscribe(struct process_subscription *s);
+#endif /* PROCESS_SUBSCRIPTIONS */
+
 /** @} */
 
 /**
@@ -519,6 +665,54 @@ CCIF int process_is_running(struct process *p);
  */
 int process_nevents(void);
 
+#if PROCESS_CONF_STATS
+/** The largest number of events that have been waiting at once. */
+extern process_num_events_t process_maxevents;
+/** The number of events dropped because the queue of their priority
+    was full. */
+extern unsigned short process_droppedevents[PROCESS_PRIORITIES];
+#endif /* PROCESS_CONF_STATS */
+
+#if PROCESS_PROFILE
+/** Size of a serialized profile header, see process_profile_header(). */
+#define PROCESS_PROFILE_HEADER_SIZE  8
+/** Size of a serialized profile record, see process_profile_record(). */
+#define PROCESS_PROFILE_RECORD_SIZE  40
+/** Number of name bytes in a serialized profile record. */
+#define PROCESS_PROFILE_NAME_LEN     16
+
+/**
+ * Clear the profiling counters of all processes.
+ */
+void process_profile_reset(void);
+
+/**
+ * Serialize the header of a binary profile dump.
+ *
+ * The header is the two bytes "PP", a format version (1), the size
+ * of a record, and the number of rtimer ticks per second as a 32-bit
+ * little-endian number.
+ *
+ * \param buf A buffer of at least PROCESS_PROFILE_HEADER_SIZE bytes.
+ * \return The number of bytes written.
+ */
+int process_profile_header(uint8_t *buf);
+
+/**
+ * Serialize the profile of a process into a binary record.
+ *
+ * A record holds the first PROCESS_PROFILE_NAME_LEN bytes of the
+ * process name, padded with zeroes, followed by calls, received,
+ * posted, ticks and max_ticks as 32-bit little-endian numbers, and
+ * max_event as a 32-bit little-endian number.
+ *
+ * \param p The process.
+ * \param buf A buffer of at least PROCESS_PROFILE_RECORD_SIZE bytes.
+ * \return The number of bytes written.
+ */
+int process_profile_record(struct process *p, uint8_t *buf);
+#endif /* PROCESS_PROFILE */
+
 /** @} */
 
 CCIF extern struct process *process_list;
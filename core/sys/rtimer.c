@@ -54,9 +54,25 @@
 #define PRINTF(...)
 #endif
 
+#if RTIMER_MULTIPLE
+static int rtimer_before(struct timerq_entry *a, struct timerq_entry *b);
+TIMERQ(rtimer_queue, rtimer_before);
+
+#define RTIMER(e) TIMERQ_ELEMENT(e, struct rtimer, entry)
+#else /* RTIMER_MULTIPLE */
 static struct rtimer *next_rtimer;
+#endif /* RTIMER_MULTIPLE */
 static const rtimer_clock_t max_rtimer_value = -1;
 
+#if RTIMER_MULTIPLE
+/*---------------------------------------------------------------------------*/
+static int
+rtimer_before(struct timerq_entry *a, struct timerq_entry *b)
+{
+  return RTIMER_CLOCK_LT(RTIMER(a)->time, RTIMER(b)->time);
+}
+#endif /* RTIMER_MULTIPLE */
+
 /*---------------------------------------------------------------------------*/
 void
 rtimer_init(void)
@@ -71,6 +87,18 @@ rtimer_set(struct rtimer *rtimer, rtimer_clock_t time,
 {
   PRINTF("rtimer_set time %d\n", time);
 
+#if RTIMER_MULTIPLE
+  if(timerq_contains(&rtimer_queue, &rtimer->entry)) {
+    timerq_remove(&rtimer_queue, &rtimer->entry);
+  }
+  rtimer->func = func;
+  rtimer->ptr = ptr;
+  rtimer->time = time;
+  timerq_add(&rtimer_queue, &rtimer->entry);
+  if(timerq_head(&rtimer_queue) == &rtimer->entry) {
+    rtimer_arch_schedule(time);
+  }
+#else /* RTIMER_MULTIPLE */
   if(next_rtimer) {
     return RTIMER_ERR_ALREADY_SCHEDULED;
   }
@@ -80,6 +108,7 @@ rtimer_set(struct rtimer *rtimer, rtimer_clock_t time,
   rtimer->time = time;
   next_rtimer = rtimer;
   rtimer_arch_schedule(time);
+#endif /* RTIMER_MULTIPLE */
 
   return RTIMER_OK;
 }
@@ -89,11 +118,25 @@ rtimer_run_next(void)
 {
   struct rtimer *t;
 
+#if RTIMER_MULTIPLE
+  /* Run all tasks that are due, then set the hardware timer to the
+     first one that is not. */
+  while(timerq_head(&rtimer_queue) != NULL) {
+    t = RTIMER(timerq_head(&rtimer_queue));
+    if(RTIMER_CLOCK_LT(RTIMER_NOW(), t->time)) {
+      rtimer_arch_schedule(t->time);
+      return;
+    }
+    timerq_remove(&rtimer_queue, &t->entry);
+    t->func(t, t->ptr);
+  }
+#else /* RTIMER_MULTIPLE */
   if(!(t = next_rtimer)) {
     return;
   }
   next_rtimer = NULL;
   t->func(t, t->ptr);
+#endif /* RTIMER_MULTIPLE */
 }
 /*---------------------------------------------------------------------------*/
 static void
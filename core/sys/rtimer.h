@@ -63,6 +63,25 @@ typedef unsigned short rtimer_clock_t;
 #define RTIMER_CLOCK_LT(a, b)      (RTIMER_CLOCK_DIFF((a),(b)) < 0)
 
 #include "rtimer-arch.h"
+#include "sys/timerq.h"
+
+/**
+ * \brief      Allow several pending real-time tasks.
+ *
+ *             By default only one real-time task can be pending, and
+ *             rtimer_set() fails with RTIMER_ERR_ALREADY_SCHEDULED
+ *             while another task is scheduled. With
+ *             RTIMER_CONF_MULTIPLE set to 1, pending tasks are kept in
+ *             a timer deadline queue and the hardware timer is always
+ *             set to the earliest one. rtimer_set() must then not be
+ *             called from code that can be interrupted by the rtimer
+ *             interrupt, other than from rtimer callbacks.
+ */
+#ifdef RTIMER_CONF_MULTIPLE
+#define RTIMER_MULTIPLE RTIMER_CONF_MULTIPLE
+#else
+#define RTIMER_MULTIPLE 0
+#endif
 
 /**
  * \brief      Initialize the real-time scheduler.
@@ -87,6 +106,9 @@ struct rtimer {
   rtimer_clock_t time;
   rtimer_callback_t func;
   void *ptr;
+#if RTIMER_MULTIPLE
+  struct timerq_entry entry;
+#endif /* RTIMER_MULTIPLE */
 };
 
 enum {
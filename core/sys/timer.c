@@ -144,5 +144,32 @@ timer_remaining(struct timer *t)
   return t->start + t->interval - clock_time();
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * Compare the expiration times of two timers
+ *
+ * This function checks if timer a expires before timer b. Expired
+ * timers come before timers that have not yet expired, the others
+ * are compared by their remaining time, which keeps the result
+ * correct when the clock wraps.
+ *
+ * \param a A pointer to the first timer
+ * \param b A pointer to the second timer
+ * \param now The current time
+ *
+ * \return Non-zero if timer a expires before timer b
+ *
+ */
+int
+timer_expires_before(struct timer *a, struct timer *b, clock_time_t now)
+{
+  if(now - a->start >= a->interval) {
+    return 1;
+  }
+  if(now - b->start >= b->interval) {
+    return 0;
+  }
+  return a->start + a->interval - now < b->start + b->interval - now;
+}
+/*---------------------------------------------------------------------------*/
 
 /** @} */
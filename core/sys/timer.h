@@ -93,6 +93,7 @@ void timer_reset(struct timer *t);
 void timer_restart(struct timer *t);
 CCIF int timer_expired(struct timer *t);
 clock_time_t timer_remaining(struct timer *t);
+int timer_expires_before(struct timer *a, struct timer *b, clock_time_t now);
 
 
 #endif /* TIMER_H_ */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup timerq
+ * @{
+ */
+
+/**
+ * \file
+ *         Timer deadline queue implementation.
+ */
+
+#include "sys/timerq.h"
+
+/*---------------------------------------------------------------------------*/
+static struct timerq_entry *
+meld(struct timerq *q, struct timerq_entry *a, struct timerq_entry *b)
+{
+  struct timerq_entry *t;
+
+  if(q->before(b, a)) {
+    t = a;
+    a = b;
+    b = t;
+  }
+  b->prev = a;
+  b->next = a->child;
+  if(a->child != NULL) {
+    a->child->prev = b;
+  }
+  a->child = b;
+  return a;
+}
+/*---------------------------------------------------------------------------*/
+static struct timerq_entry *
+merge_pairs(struct timerq *q, struct timerq_entry *first)
+{
+  struct timerq_entry *a, *b, *pairs, *result;
+
+  /* Meld the siblings pairwise from left to right, stacking the
+     results, then meld the stack from right to left. */
+  pairs = NULL;
+  while(first != NULL) {
+    a = first;
+    b = a->next;
+    a->prev = NULL;
+    if(b == NULL) {
+      a->next = pairs;
+      pairs = a;
+      break;
+    }
+    first = b->next;
+    a->next = b->prev = b->next = NULL;
+    a = meld(q, a, b);
+    a->next = pairs;
+    pairs = a;
+  }
+
+  result = NULL;
+  while(pairs != NULL) {
+    a = pairs;
+    pairs = a->next;
+    a->next = NULL;
+    result = result == NULL ? a : meld(q, result, a);
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+void
+timerq_init(struct timerq *q)
+{
+  q->head = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+timerq_add(struct timerq *q, struct timerq_entry *e)
+{
+  e->next = e->prev = e->child = NULL;
+  q->head = q->head == NULL ? e : meld(q, q->head, e);
+}
+/*---------------------------------------------------------------------------*/
+void
+timerq_remove(struct timerq *q, struct timerq_entry *e)
+{
+  struct timerq_entry *sub;
+
+  if(e == q->head) {
+    q->head = merge_pairs(q, e->child);
+  } else {
+    if(e->prev->child == e) {
+      e->prev->child = e->next;
+    } else {
+      e->prev->next = e->next;
+    }
+    if(e->next != NULL) {
+      e->next->prev = e->prev;
+    }
+    sub = merge_pairs(q, e->child);
+    if(sub != NULL) {
+      q->head = meld(q, q->head, sub);
+    }
+  }
+  e->next = e->prev = e->child = NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+timerq_contains(struct timerq *q, struct timerq_entry *e)
+{
+  return e == q->head ||
+    (e->prev != NULL && (e->prev->child == e || e->prev->next == e));
+}
+/*---------------------------------------------------------------------------*/
+struct timerq_entry *
+timerq_walk(struct timerq *q, struct timerq_entry *e)
+{
+  /* Depth-first walk without recursion: the parent of an entry is
+     found by following "prev" back to the first sibling. */
+  if(e == NULL) {
+    return q->head;
+  }
+  if(e->child != NULL) {
+    return e->child;
+  }
+  while(e != NULL && e->next == NULL) {
+    while(e->prev != NULL && e->prev->child != e) {
+      e = e->prev;
+    }
+    e = e->prev;
+  }
+  return e == NULL ? NULL : e->next;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
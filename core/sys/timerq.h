@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup sys
+ * @{
+ */
+
+/**
+ * \defgroup timerq Timer deadline queue
+ * @{
+ *
+ * The timer deadline queue is an intrusive priority queue that keeps
+ * timers ordered by their deadline, so that the next timer to expire
+ * can be found in constant time. It is shared by the event timer, the
+ * callback timer and, when RTIMER_CONF_MULTIPLE is set, the real-time
+ * timer modules.
+ *
+ * The queue is a pairing heap: insertion is O(1) and removal of any
+ * element is O(log n) amortized. Elements embed a struct timerq_entry,
+ * and the queue is told how to order two entries through a
+ * comparison function given to the TIMERQ() macro.
+ *
+ */
+
+#ifndef TIMERQ_H_
+#define TIMERQ_H_
+
+#include <stddef.h>
+
+/**
+ * Queue linkage embedded in every element of a timer deadline queue.
+ */
+struct timerq_entry {
+  struct timerq_entry *next;   /* Next sibling. */
+  struct timerq_entry *prev;   /* Previous sibling, or parent of a first child. */
+  struct timerq_entry *child;  /* First child. */
+};
+
+/**
+ * Comparison function of a timer deadline queue. Returns non-zero if
+ * entry a is due before entry b.
+ */
+typedef int (* timerq_before_t)(struct timerq_entry *a,
+                                struct timerq_entry *b);
+
+struct timerq {
+  struct timerq_entry *head;
+  timerq_before_t before;
+};
+
+/**
+ * Declare a timer deadline queue.
+ *
+ * \param name The name of the queue.
+ * \param before The comparison function that orders the entries.
+ */
+#define TIMERQ(name, before) static struct timerq name = { NULL, before }
+
+/**
+ * Get a pointer to the element that contains a queue entry.
+ *
+ * \param e A pointer to the struct timerq_entry.
+ * \param type The type of the element.
+ * \param member The name of the struct timerq_entry member.
+ */
+#define TIMERQ_ELEMENT(e, type, member) \
+  ((type *)((char *)(e) - offsetof(type, member)))
+
+void timerq_init(struct timerq *q);
+
+/**
+ * Add an entry to a queue. The entry must not already be in a queue.
+ */
+void timerq_add(struct timerq *q, struct timerq_entry *e);
+
+/**
+ * Remove an entry from a queue. The entry must be in the queue.
+ */
+void timerq_remove(struct timerq *q, struct timerq_entry *e);
+
+/**
+ * Check if an entry is in a queue.
+ *
+ * The check only looks at the entry and its neighbours, so the entry
+ * must either be zero-initialized or have been added to the queue at
+ * some point.
+ */
+int timerq_contains(struct timerq *q, struct timerq_entry *e);
+
+/**
+ * Get the entry with the earliest deadline, or NULL if the queue is
+ * empty.
+ */
+#define timerq_head(q) ((q)->head)
+
+/**
+ * Iterate over all entries of a queue, in no particular order.
+ *
+ * \param e The current entry, or NULL to get the first entry.
+ * \return The entry after e, or NULL when all entries have been
+ * visited. The queue must not be modified during the iteration.
+ */
+struct timerq_entry *timerq_walk(struct timerq *q, struct timerq_entry *e);
+
+#endif /* TIMERQ_H_ */
+
+/** @} */
+/** @} */
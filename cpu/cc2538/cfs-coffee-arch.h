@@ -123,6 +123,42 @@
 #else
 #define COFFEE_MICRO_LOGS      0
 #endif
+/** Number of pages cached in RAM */
+#ifdef COFFEE_CONF_PAGE_CACHE_SIZE
+#define COFFEE_PAGE_CACHE_SIZE COFFEE_CONF_PAGE_CACHE_SIZE
+#else
+#define COFFEE_PAGE_CACHE_SIZE 0
+#endif
+/** Whether to keep an in-RAM index of file names and free pages */
+#ifdef COFFEE_CONF_NAME_INDEX
+#define COFFEE_NAME_INDEX      COFFEE_CONF_NAME_INDEX
+#else
+#define COFFEE_NAME_INDEX      0
+#endif
+/** Number of name slots in the index */
+#ifdef COFFEE_CONF_NAME_INDEX_SIZE
+#define COFFEE_NAME_INDEX_SIZE COFFEE_CONF_NAME_INDEX_SIZE
+#else
+#define COFFEE_NAME_INDEX_SIZE 32
+#endif
+/** Whether to collect garbage in a background process */
+#ifdef COFFEE_CONF_GC_PROCESS
+#define COFFEE_GC_PROCESS      COFFEE_CONF_GC_PROCESS
+#else
+#define COFFEE_GC_PROCESS      0
+#endif
+/** Number of free sectors the background process aims for */
+#ifdef COFFEE_CONF_GC_WATERMARK
+#define COFFEE_GC_WATERMARK    COFFEE_CONF_GC_WATERMARK
+#else
+#define COFFEE_GC_WATERMARK    2
+#endif
+/** Clock ticks between background garbage collection steps */
+#ifdef COFFEE_CONF_GC_INTERVAL
+#define COFFEE_GC_INTERVAL     COFFEE_CONF_GC_INTERVAL
+#else
+#define COFFEE_GC_INTERVAL     (CLOCK_SECOND / 8)
+#endif
 /** Whether files are expected to be appended to only */
 #ifdef COFFEE_CONF_APPEND_ONLY
 #define COFFEE_APPEND_ONLY     COFFEE_CONF_APPEND_ONLY
@@ -105,6 +105,12 @@ spl_t   splhigh_(void);
 #define splx(sr) __asm__ __volatile__("bis %0, r2" : : "r" (sr))
 #endif
 
+/* Energest trace records are also made from interrupts */
+#ifndef ENERGEST_CONF_TRACE_INT_DISABLE
+#define ENERGEST_CONF_TRACE_INT_DISABLE()  splhigh()
+#define ENERGEST_CONF_TRACE_INT_RESTORE(s) splx(s)
+#endif /* ENERGEST_CONF_TRACE_INT_DISABLE */
+
 /* Workaround for bug in msp430-gcc compiler */
 #if defined(__MSP430__) && defined(__GNUC__) && MSP430_MEMCPY_WORKAROUND
 #ifndef memcpy
@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions 
+ * are met: 
+ * 1. Redistributions of source code must retain the above copyright 
+ *    notice, this list of conditions and the following disclaimer. 
+ * 2. Redistributions in binary form must reproduce the above copyright 
+ *    notice, this list of conditions and the following disclaimer in the 
+ *    documentation and/or other materials provided with the distribution. 
+ * 3. Neither the name of the Institute nor the names of its contributors 
+ *    may be used to endorse or promote products derived from this software 
+ *    without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND 
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE 
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS 
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF 
+ * SUCH DAMAGE. 
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         mt support for the native platform on a pool of POSIX threads.
+ *
+ *         With MTARCH_CONF_PTHREADS set to 1, mt_exec() does not run
+ *         the thread on the stack of the caller. Instead, it hands the
+ *         thread to a pool of worker POSIX threads, one per CPU unless
+ *         MTARCH_CONF_WORKERS says otherwise, and returns at once, as
+ *         if the thread had been preempted right away. The thread then
+ *         runs in parallel with the Contiki main loop and with other
+ *         mt threads until it calls mt_yield() or mt_exit(). Calling
+ *         mt_exec() on a thread that is still running makes it run
+ *         again after it yields.
+ *
+ *         Each worker keeps a deque of runnable threads. A thread is
+ *         queued on the worker that last ran it, the owner takes the
+ *         most recently queued thread and idle workers steal the
+ *         oldest thread from other workers.
+ *
+ *         While running on a worker, a thread may only call
+ *         process_post() and process_poll(), which are protected by a
+ *         lock, and must not touch any other state that it shares with
+ *         the Contiki main loop. The main loop picks up the posted
+ *         events within its select() timeout.
+ */
+
+#include "sys/mt.h"
+
+#if MTARCH_PTHREADS
+
+#ifdef __APPLE__
+/* Avoid deprecated error on Darwin */
+#define _XOPEN_SOURCE
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef MTARCH_STACKSIZE
+#define MTARCH_STACKSIZE 16384
+#endif /* MTARCH_STACKSIZE */
+
+#ifdef MTARCH_CONF_WORKERS
+#define WORKERS MTARCH_CONF_WORKERS
+#else
+#define WORKERS 0 /* one per online CPU */
+#endif
+
+#define MAX_WORKERS 64
+
+enum {
+  STATE_IDLE,
+  STATE_QUEUED,
+  STATE_RUNNING,
+};
+
+struct worker;
+
+struct mtarch_t {
+  ucontext_t context;
+  struct mtarch_t *next, *prev;
+  struct mtarch_thread *thread;
+  struct worker *home;
+  unsigned char state;
+  unsigned char again;
+  char stack[MTARCH_STACKSIZE];
+};
+
+struct worker {
+  pthread_t id;
+  pthread_mutex_t lock;
+  struct mtarch_t *head, *tail;
+  struct mtarch_t *running;
+  ucontext_t context;
+};
+
+static struct worker workers[MAX_WORKERS];
+static int num_workers;
+static unsigned int next_home;
+static pthread_key_t worker_key;
+
+/* The state of all threads and the number of queued threads are
+   protected by state_lock. A worker deque is protected by the lock of
+   the worker, which is taken after state_lock when both are needed. */
+static pthread_mutex_t state_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_available = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t thread_idle = PTHREAD_COND_INITIALIZER;
+static int queued;
+static int stopping;
+
+static pthread_mutex_t process_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*--------------------------------------------------------------------------*/
+static void
+push(struct worker *w, struct mtarch_t *t)
+{
+  pthread_mutex_lock(&w->lock);
+  t->next = NULL;
+  t->prev = w->tail;
+  if(w->tail != NULL) {
+    w->tail->next = t;
+  } else {
+    w->head = t;
+  }
+  w->tail = t;
+  pthread_mutex_unlock(&w->lock);
+}
+/*--------------------------------------------------------------------------*/
+static struct mtarch_t *
+pop_tail(struct worker *w)
+{
+  struct mtarch_t *t;
+
+  pthread_mutex_lock(&w->lock);
+  t = w->tail;
+  if(t != NULL) {
+    w->tail = t->prev;
+    if(w->tail != NULL) {
+      w->tail->next = NULL;
+    } else {
+      w->head = NULL;
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+  return t;
+}
+/*--------------------------------------------------------------------------*/
+static struct mtarch_t *
+pop_head(struct worker *w)
+{
+  struct mtarch_t *t;
+
+  pthread_mutex_lock(&w->lock);
+  t = w->head;
+  if(t != NULL) {
+    w->head = t->next;
+    if(w->head != NULL) {
+      w->head->prev = NULL;
+    } else {
+      w->tail = NULL;
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+  return t;
+}
+/*--------------------------------------------------------------------------*/
+/* Must be called with state_lock held. */
+static void
+enqueue(struct mtarch_t *t)
+{
+  t->state = STATE_QUEUED;
+  queued++;
+  push(t->home, t);
+  pthread_cond_signal(&work_available);
+}
+/*--------------------------------------------------------------------------*/
+static struct mtarch_t *
+find_work(struct worker *w)
+{
+  struct mtarch_t *t;
+  int i, victim;
+
+  t = pop_tail(w);
+  if(t == NULL) {
+    victim = w - workers;
+    for(i = 1; i < num_workers && t == NULL; i++) {
+      t = pop_head(&workers[(victim + i) % num_workers]);
+    }
+  }
+  return t;
+}
+/*--------------------------------------------------------------------------*/
+static int
+has_exited(struct mtarch_t *t)
+{
+  struct mt_thread *mt;
+
+  mt = (struct mt_thread *)((char *)t->thread -
+                            offsetof(struct mt_thread, thread));
+  return mt->state == MT_STATE_EXITED;
+}
+/*--------------------------------------------------------------------------*/
+static void *
+worker_main(void *arg)
+{
+  struct worker *w = arg;
+  struct mtarch_t *t;
+
+  pthread_setspecific(worker_key, w);
+
+  while(1) {
+    t = find_work(w);
+    if(t == NULL) {
+      pthread_mutex_lock(&state_lock);
+      while(queued == 0 && !stopping) {
+        pthread_cond_wait(&work_available, &state_lock);
+      }
+      if(queued == 0 && stopping) {
+        pthread_mutex_unlock(&state_lock);
+        return NULL;
+      }
+      pthread_mutex_unlock(&state_lock);
+      continue;
+    }
+
+    pthread_mutex_lock(&state_lock);
+    queued--;
+    t->state = STATE_RUNNING;
+    t->home = w;
+    pthread_mutex_unlock(&state_lock);
+
+    /* Run the thread until it yields or exits. */
+    w->running = t;
+    swapcontext(&w->context, &t->context);
+    w->running = NULL;
+
+    pthread_mutex_lock(&state_lock);
+    if(t->again && !has_exited(t)) {
+      t->again = 0;
+      enqueue(t);
+    } else {
+      t->again = 0;
+      t->state = STATE_IDLE;
+      pthread_cond_broadcast(&thread_idle);
+    }
+    pthread_mutex_unlock(&state_lock);
+  }
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_init(void)
+{
+  int i;
+
+  if(num_workers > 0) {
+    return;
+  }
+
+  num_workers = WORKERS;
+  if(num_workers <= 0) {
+    num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if(num_workers <= 0) {
+    num_workers = 1;
+  } else if(num_workers > MAX_WORKERS) {
+    num_workers = MAX_WORKERS;
+  }
+
+  pthread_key_create(&worker_key, NULL);
+  stopping = 0;
+  for(i = 0; i < num_workers; i++) {
+    pthread_mutex_init(&workers[i].lock, NULL);
+    workers[i].head = workers[i].tail = NULL;
+    workers[i].running = NULL;
+    pthread_create(&workers[i].id, NULL, worker_main, &workers[i]);
+  }
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_remove(void)
+{
+  int i;
+
+  pthread_mutex_lock(&state_lock);
+  stopping = 1;
+  pthread_cond_broadcast(&work_available);
+  pthread_mutex_unlock(&state_lock);
+
+  for(i = 0; i < num_workers; i++) {
+    pthread_join(workers[i].id, NULL);
+    pthread_mutex_destroy(&workers[i].lock);
+  }
+  pthread_key_delete(worker_key);
+  num_workers = 0;
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_start(struct mtarch_thread *thread,
+	     void (* function)(void *data),
+	     void *data)
+{
+  struct mtarch_t *t;
+
+  t = malloc(sizeof(struct mtarch_t));
+  thread->mt_thread = t;
+
+  getcontext(&t->context);
+  t->context.uc_link = NULL;
+  t->context.uc_stack.ss_sp = t->stack;
+  t->context.uc_stack.ss_size = sizeof(t->stack);
+  /* See mtarch.c for notes on passing the pointer argument. */
+  makecontext(&t->context, (void (*)(void))function, 1, data);
+
+  t->thread = thread;
+  t->state = STATE_IDLE;
+  t->again = 0;
+
+  /* Spread new threads over the workers. */
+  pthread_mutex_lock(&state_lock);
+  t->home = &workers[next_home++ % num_workers];
+  pthread_mutex_unlock(&state_lock);
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_yield(void)
+{
+  struct worker *w;
+  struct mtarch_t *t;
+
+  w = pthread_getspecific(worker_key);
+  if(w == NULL || w->running == NULL) {
+    /* Not called from an mt thread. */
+    return;
+  }
+  t = w->running;
+
+  /* The thread may be resumed by another worker, so w must not be
+     used after this call. */
+  swapcontext(&t->context, &w->context);
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_exec(struct mtarch_thread *thread)
+{
+  struct mtarch_t *t = thread->mt_thread;
+
+  pthread_mutex_lock(&state_lock);
+  if(t->state == STATE_IDLE) {
+    enqueue(t);
+  } else if(t->state == STATE_RUNNING) {
+    t->again = 1;
+  }
+  pthread_mutex_unlock(&state_lock);
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_stop(struct mtarch_thread *thread)
+{
+  struct mtarch_t *t = thread->mt_thread;
+
+  /* Wait for the thread to yield before its stack goes away. */
+  pthread_mutex_lock(&state_lock);
+  t->again = 0;
+  while(t->state != STATE_IDLE) {
+    pthread_cond_wait(&thread_idle, &state_lock);
+  }
+  pthread_mutex_unlock(&state_lock);
+
+  free(t);
+}
+/*--------------------------------------------------------------------------*/
+struct mtarch_thread *
+mtarch_current(void)
+{
+  struct worker *w;
+
+  w = pthread_getspecific(worker_key);
+  if(w == NULL || w->running == NULL) {
+    return NULL;
+  }
+  return w->running->thread;
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_lock(void)
+{
+  pthread_mutex_lock(&process_lock);
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_unlock(void)
+{
+  pthread_mutex_unlock(&process_lock);
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_pstart(void)
+{
+}
+/*--------------------------------------------------------------------------*/
+void
+mtarch_pstop(void)
+{
+}
+/*--------------------------------------------------------------------------*/
+
+#endif /* MTARCH_PTHREADS */
@@ -34,6 +34,8 @@
 
 #include "sys/mt.h"
 
+#if !MTARCH_PTHREADS
+
 #ifndef MTARCH_STACKSIZE
 #define MTARCH_STACKSIZE 4096
 #endif /* MTARCH_STACKSIZE */
@@ -183,3 +185,5 @@ mtarch_pstop(void)
 {
 }
 /*--------------------------------------------------------------------------*/
+
+#endif /* !MTARCH_PTHREADS */
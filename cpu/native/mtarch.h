@@ -35,8 +35,28 @@
 #ifndef MTARCH_H_
 #define MTARCH_H_
 
+#include "contiki-conf.h"
+
+/*
+ * With MTARCH_CONF_PTHREADS set to 1, mt threads are run by a pool of
+ * POSIX threads instead of on the stack of the Contiki main loop. See
+ * mtarch-pthread.c.
+ */
+#ifdef MTARCH_CONF_PTHREADS
+#define MTARCH_PTHREADS MTARCH_CONF_PTHREADS
+#else
+#define MTARCH_PTHREADS 0
+#endif
+
 struct mtarch_thread {
   void *mt_thread;
 };
 
+#if MTARCH_PTHREADS
+/* Several mt threads may be running at the same time, so mt_exit()
+   asks for the thread that runs on the calling POSIX thread. */
+struct mtarch_thread *mtarch_current(void);
+#define MTARCH_CURRENT() mtarch_current()
+#endif /* MTARCH_PTHREADS */
+
 #endif /* MTARCH_H_ */
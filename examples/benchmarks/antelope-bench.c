@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Benchmark of time-series range queries in Antelope on the
+ *         native platform, without an index and with a B+-tree index
+ *         that is bulk loaded from the existing relation, and of joins
+ *         between the samples and smaller metadata relations.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs-coffee.h"
+#include "lib/random.h"
+
+#include "antelope.h"
+#include "index.h"
+#include "relation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define SAMPLES   2000
+#define APPENDS   1000
+#define QUERIES   200
+#define PERIOD    10
+#define WINDOW    100
+#define SENSORS   100
+#define EVENTS    60
+#define DELETES   100
+#define DUPLICATES 300
+
+#define EVENT_JOIN "JOIN events, samples ON time PROJECT time, value, kind;"
+
+PROCESS(antelope_bench_process, "Antelope benchmark");
+AUTOSTART_PROCESSES(&antelope_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static int
+insert_samples(long first, long count)
+{
+  long i;
+  int errors;
+
+  errors = 0;
+  for(i = first; i < first + count; i++) {
+    errors += DB_ERROR(db_query(NULL, "INSERT (%ld, %ld) INTO samples;",
+                                i * PERIOD, i % 100));
+  }
+  return errors;
+}
+/*---------------------------------------------------------------------------*/
+static int
+index_ready(char *relation, char *attribute)
+{
+  relation_t *rel;
+  attribute_t *attr;
+  int ready;
+
+  rel = relation_load(relation);
+  if(rel == NULL) {
+    return 0;
+  }
+  attr = relation_attribute_get(rel, attribute);
+  ready = attr != NULL && index_exists(attr);
+  relation_release(rel);
+  return ready;
+}
+/*---------------------------------------------------------------------------*/
+/* Delete the index entries with the keys first, first + step, ...
+   through the index API, since AQL removals rebuild the relation. The
+   tuples stay in the relation, but queries through the index no
+   longer find them. */
+static int
+delete_keys(char *relation, char *attribute, long first, long step,
+            long count)
+{
+  relation_t *rel;
+  attribute_t *attr;
+  attribute_value_t value;
+  int errors;
+
+  rel = relation_load(relation);
+  if(rel == NULL) {
+    return 1;
+  }
+  attr = relation_attribute_get(rel, attribute);
+  errors = attr == NULL || attr->index == NULL;
+  value.domain = DOMAIN_LONG;
+  for(; !errors && count > 0; count--, first += step) {
+    VALUE_LONG(&value) = first;
+    errors += DB_ERROR(index_delete(attr->index, &value));
+  }
+  relation_release(rel);
+  return errors;
+}
+/*---------------------------------------------------------------------------*/
+/* Return the number of rows found by a query, or -1 if it fails. */
+static long
+count_rows(const char *query)
+{
+  db_handle_t handle;
+  db_result_t result;
+  long rows;
+
+  rows = 0;
+  result = db_query(&handle, query);
+  if(DB_ERROR(result)) {
+    db_free(&handle);
+    return -1;
+  }
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW) {
+      rows++;
+    } else if(result != DB_OK) {
+      db_free(&handle);
+      if(DB_ERROR(result)) {
+        return -1;
+      }
+    }
+  }
+  return rows;
+}
+/*---------------------------------------------------------------------------*/
+/* Run the same windows for each mode and return the total number of
+   rows found, which must not depend on the mode. */
+static unsigned long
+run_queries(const char *mode, long samples)
+{
+  db_handle_t handle;
+  db_result_t result;
+  unsigned long start, elapsed, rows, processed;
+  long from;
+  int i, errors;
+
+  random_init(1);
+  rows = processed = 0;
+  errors = 0;
+  start = usec_now();
+  for(i = 0; i < QUERIES; i++) {
+    from = (random_rand() % samples) * PERIOD;
+    result = db_query(&handle,
+                      "SELECT time, value FROM samples WHERE time >= %ld AND time <= %ld;",
+                      from, from + WINDOW - 1);
+    if(DB_ERROR(result)) {
+      errors++;
+      db_free(&handle);
+      continue;
+    }
+    while(db_processing(&handle)) {
+      result = db_process(&handle);
+      if(result == DB_GOT_ROW) {
+        rows++;
+        processed++;
+      } else if(result == DB_OK) {
+        processed++;
+      } else {
+        errors += DB_ERROR(result);
+        db_free(&handle);
+      }
+    }
+  }
+  elapsed = usec_now() - start;
+  printf("antelope-bench: %5ld samples, %-5s: %d queries in %8lu us (%lu us/query), %lu rows, %lu tuples processed, %d failed\n",
+         samples, mode, QUERIES, elapsed, elapsed / QUERIES, rows, processed,
+         errors);
+  return rows;
+}
+/*---------------------------------------------------------------------------*/
+static long
+run_join(const char *mode, const char *query)
+{
+  unsigned long start, elapsed;
+  long rows;
+
+  start = usec_now();
+  rows = count_rows(query);
+  elapsed = usec_now() - start;
+  printf("antelope-bench: join, %-5s: %8lu us, %ld rows, %d failed\n",
+         mode, elapsed, rows < 0 ? 0 : rows, rows < 0);
+  return rows;
+}
+/*---------------------------------------------------------------------------*/
+/* Delete every other key from a window of the B+-tree on samples.time
+   and query the window again. An index search that finds nothing fails,
+   so the window also covers keys that are kept. */
+static int
+check_btree_delete(void)
+{
+  static char query[128];
+  long rows;
+  int errors;
+
+  errors = delete_keys("samples", "time", 0, 2 * PERIOD, DELETES);
+  snprintf(query, sizeof(query),
+           "SELECT time FROM samples WHERE time >= 0 AND time <= %ld;",
+           2L * DELETES * PERIOD - 1);
+  rows = count_rows(query);
+  errors += rows != DELETES;
+  printf("antelope-bench: btree, %d keys deleted: %ld of %d rows found, %d failed\n",
+         DELETES, rows, 2 * DELETES, errors);
+  return errors;
+}
+/*---------------------------------------------------------------------------*/
+/* Index many duplicates of one key, which span several leaves, between
+   a few entries of the neighboring keys, and delete half of them. */
+static int
+check_btree_duplicates(void)
+{
+  long i, before, after, others;
+  int errors;
+
+  errors = 0;
+  db_query(NULL, "CREATE RELATION readings;");
+  db_query(NULL, "CREATE ATTRIBUTE sensor DOMAIN INT IN readings;");
+  db_query(NULL, "CREATE ATTRIBUTE level DOMAIN INT IN readings;");
+  errors += DB_ERROR(db_query(NULL, "CREATE INDEX readings.sensor TYPE BTREE;"));
+  for(i = 0; i < DUPLICATES; i++) {
+    if(i % 30 == 0) {
+      errors += DB_ERROR(db_query(NULL, "INSERT (1, %ld) INTO readings;", i));
+      errors += DB_ERROR(db_query(NULL, "INSERT (3, %ld) INTO readings;", i));
+    }
+    errors += DB_ERROR(db_query(NULL, "INSERT (2, %ld) INTO readings;", i));
+  }
+
+  before = count_rows("SELECT sensor FROM readings WHERE sensor = 2;");
+  errors += delete_keys("readings", "sensor", 2, 0, DUPLICATES / 2);
+  after = count_rows("SELECT sensor FROM readings WHERE sensor = 2;");
+  others = count_rows("SELECT sensor FROM readings WHERE sensor >= 1 AND sensor <= 3;");
+  errors += before != DUPLICATES || after != DUPLICATES / 2 ||
+            others != DUPLICATES / 2 + 2 * (DUPLICATES / 30);
+  printf("antelope-bench: btree, %d duplicates: %ld rows found, %ld after deleting %d, %ld in range, %d failed\n",
+         DUPLICATES, before, after, DUPLICATES / 2, others, errors);
+
+  db_query(NULL, "REMOVE RELATION readings;");
+  return errors;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(antelope_bench_process, ev, data)
+{
+  static unsigned long start, scan_rows, index_rows;
+  static long join_rows;
+#if DB_JOIN_AREA_SIZE > 0
+  static long hash_rows;
+#endif /* DB_JOIN_AREA_SIZE > 0 */
+  static int errors;
+
+  PROCESS_BEGIN();
+
+  cfs_coffee_format();
+  db_init();
+
+  db_query(NULL, "CREATE RELATION samples;");
+  db_query(NULL, "CREATE ATTRIBUTE time DOMAIN LONG IN samples;");
+  db_query(NULL, "CREATE ATTRIBUTE value DOMAIN INT IN samples;");
+
+  start = usec_now();
+  errors = insert_samples(0, SAMPLES);
+  printf("antelope-bench: %5d samples inserted in %8lu us, %d failed\n",
+         SAMPLES, usec_now() - start, errors);
+
+  scan_rows = run_queries("scan", SAMPLES);
+
+  /* The index is loaded from the relation by the indexer process. */
+  start = usec_now();
+  errors += DB_ERROR(db_query(NULL, "CREATE INDEX samples.time TYPE BTREE;"));
+  while(!index_ready("samples", "time")) {
+    PROCESS_PAUSE();
+  }
+  printf("antelope-bench: %5d samples bulk loaded in %8lu us\n",
+         SAMPLES, usec_now() - start);
+
+  index_rows = run_queries("btree", SAMPLES);
+  errors += scan_rows != index_rows;
+
+  start = usec_now();
+  errors += insert_samples(SAMPLES, APPENDS);
+  printf("antelope-bench: %5d samples appended with the index in %8lu us\n",
+         APPENDS, usec_now() - start);
+
+  index_rows = run_queries("btree", SAMPLES + APPENDS);
+  errors += check_btree_delete();
+  db_query(NULL, "REMOVE INDEX samples.time;");
+  scan_rows = run_queries("scan", SAMPLES + APPENDS);
+  errors += scan_rows != index_rows;
+
+  /* Only one B+-tree index may exist at a time. */
+  errors += check_btree_duplicates();
+
+  /* Every sample refers to a sensor, and one in every fifty samples
+     coincides with an event. Both metadata relations are sorted on the
+     join attribute and have an inline index. */
+  db_query(NULL, "CREATE RELATION sensors;");
+  db_query(NULL, "CREATE ATTRIBUTE value DOMAIN INT IN sensors;");
+  db_query(NULL, "CREATE ATTRIBUTE location DOMAIN INT IN sensors;");
+  db_query(NULL, "CREATE INDEX sensors.value TYPE INLINE;");
+  for(start = 0; start < SENSORS; start++) {
+    errors += DB_ERROR(db_query(NULL, "INSERT (%lu, %lu) INTO sensors;",
+                                start, start / 10));
+  }
+  db_query(NULL, "CREATE RELATION events;");
+  db_query(NULL, "CREATE ATTRIBUTE time DOMAIN LONG IN events;");
+  db_query(NULL, "CREATE ATTRIBUTE kind DOMAIN INT IN events;");
+  db_query(NULL, "CREATE INDEX events.time TYPE INLINE;");
+  for(start = 0; start < EVENTS; start++) {
+    errors += DB_ERROR(db_query(NULL, "INSERT (%lu, %lu) INTO events;",
+                                start * 50 * PERIOD, start % 3));
+  }
+
+  /* A hash join, or an index nested-loop join if the join area is
+     disabled. */
+  errors += run_join(DB_JOIN_AREA_SIZE > 0 ? "hash" : "index",
+                     "JOIN samples, sensors ON value PROJECT time, location;")
+            != SAMPLES + APPENDS;
+
+#if DB_JOIN_AREA_SIZE > 0
+  /* The events are fewer than the samples, so this hash join builds
+     its table from the left relation. */
+  hash_rows = run_join("hash", EVENT_JOIN);
+#endif /* DB_JOIN_AREA_SIZE > 0 */
+
+  /* A merge join, since both relations are sorted on the time. */
+  errors += DB_ERROR(db_query(NULL, "CREATE INDEX samples.time TYPE INLINE;"));
+  while(!index_ready("samples", "time")) {
+    PROCESS_PAUSE();
+  }
+  errors += run_join("merge",
+                     "JOIN samples, events ON time PROJECT time, value, kind;")
+            != EVENTS;
+
+  /* Now that the samples are indexed, the events are looked up in the
+     inline index instead, which must find the same rows. */
+  join_rows = run_join("index", EVENT_JOIN);
+  errors += join_rows != EVENTS;
+#if DB_JOIN_AREA_SIZE > 0
+  errors += hash_rows != join_rows;
+#endif /* DB_JOIN_AREA_SIZE > 0 */
+
+  printf("antelope-bench: %s\n", errors == 0 ? "consistent" : "INCONSISTENT");
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of file lookups in Coffee on the native platform,
+ *         which keeps the file system in a RAM flash emulation. Build
+ *         once as is and once with DEFINES=COFFEE_CONF_NAME_INDEX=1 to
+ *         compare the header scan with the in-RAM name index.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs/cfs-coffee.h"
+#include "cfs-coffee-arch.h"
+#include "dev/xmem.h"
+#include "lib/crc16.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define LOOKUPS    20000
+#define FILE_SIZE  200
+
+#define LOG_RECORDS 4000
+#define RECORD_SIZE 16
+
+static const int sizes[] = { 32, 256, 1024 };
+
+PROCESS(coffee_bench_process, "Coffee benchmark");
+AUTOSTART_PROCESSES(&coffee_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_name(char *name, int i)
+{
+  memset(name, 0, 16);
+  sprintf(name, "file%05d", i);
+}
+/*---------------------------------------------------------------------------*/
+static int
+create(int i)
+{
+  char name[16];
+  int fd, n;
+
+  make_name(name, i);
+  if(cfs_coffee_reserve(name, FILE_SIZE) < 0) {
+    return -1;
+  }
+  fd = cfs_open(name, CFS_WRITE);
+  if(fd < 0) {
+    return -1;
+  }
+  n = cfs_write(fd, name, sizeof(name));
+  cfs_close(fd);
+  return n == sizeof(name) ? 0 : -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Check that file i exists with the right contents, or does not exist */
+static int
+check(int i, int exists)
+{
+  char name[16], buf[16];
+  int fd, n;
+
+  make_name(name, i);
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return !exists;
+  }
+  n = cfs_read(fd, buf, sizeof(buf));
+  cfs_close(fd);
+  /* Coffee does not count trailing zero bytes in the size of a file
+     that is not open, so only the name itself is compared */
+  return exists && n >= (int)strlen(name) &&
+         memcmp(name, buf, strlen(name)) == 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Digest of the storage, which must not depend on the lookup mode */
+static unsigned
+image_digest(void)
+{
+  unsigned char buf[256];
+  unsigned long offset;
+  unsigned short crc;
+
+  crc = 0;
+  for(offset = 0; offset < COFFEE_SIZE; offset += sizeof(buf)) {
+    xmem_pread(buf, sizeof(buf), COFFEE_START + offset);
+    crc = crc16_data(buf, sizeof(buf), crc);
+  }
+  return crc;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+run_opens(int files, int first, int *failed)
+{
+  char name[16];
+  unsigned long start;
+  long i;
+  int fd;
+
+  *failed = 0;
+  start = usec_now();
+  for(i = 0; i < LOOKUPS; i++) {
+    make_name(name, first + random_rand() % files);
+    fd = cfs_open(name, CFS_READ);
+    if(fd < 0) {
+      (*failed)++;
+    } else {
+      cfs_close(fd);
+    }
+  }
+  return usec_now() - start;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(int files)
+{
+  unsigned long start, elapsed;
+  int i, first, failed, errors;
+
+  cfs_coffee_format();
+
+  start = usec_now();
+  errors = 0;
+  for(i = 0; i < files; i++) {
+    errors += create(i) < 0;
+  }
+  elapsed = usec_now() - start;
+  printf("coffee-bench: %4d files: created in %7lu us (%lu ns/file), %d failed\n",
+         files, elapsed, elapsed * 1000 / files, errors);
+
+  elapsed = run_opens(files, 0, &failed);
+  printf("coffee-bench: %4d files: %d opens in %7lu us (%lu ns/open), %d failed\n",
+         files, LOOKUPS, elapsed, elapsed * 1000 / LOOKUPS, failed);
+
+  elapsed = run_opens(files, files, &failed);
+  printf("coffee-bench: %4d files: %d misses in %7lu us (%lu ns/miss), %d found\n",
+         files, LOOKUPS, elapsed, elapsed * 1000 / LOOKUPS, LOOKUPS - failed);
+
+  /* Replace the oldest files with new ones, four times over, so that the
+     garbage collector erases the sectors of the removed files. */
+  start = usec_now();
+  for(first = 0; first < 4 * files; first++) {
+    char name[16];
+
+    make_name(name, first);
+    errors += cfs_remove(name) < 0;
+    errors += create(first + files) < 0;
+  }
+  elapsed = usec_now() - start;
+  printf("coffee-bench: %4d files: %d replaced in %7lu us (%lu ns/file), %d failed\n",
+         files, 4 * files, elapsed, elapsed * 1000 / (4 * files), errors);
+
+  for(i = 0; i < 5 * files; i++) {
+    if(!check(i, i >= first)) {
+      errors++;
+    }
+  }
+  printf("coffee-bench: %4d files: %s, image digest %04x\n",
+         files, errors == 0 ? "consistent" : "INCONSISTENT", image_digest());
+}
+/*---------------------------------------------------------------------------*/
+/* A sensor log: small records appended to one file and read back in
+   order, with the number of storage operations that they take. */
+static void
+run_log(void)
+{
+  struct cfs_coffee_cache_stats before, after;
+  unsigned char record[RECORD_SIZE], expected[RECORD_SIZE];
+  unsigned long start, elapsed;
+  int fd, i, errors;
+
+  cfs_coffee_format();
+  errors = cfs_coffee_reserve("log", LOG_RECORDS * RECORD_SIZE) < 0;
+
+  cfs_coffee_get_cache_stats(&before);
+  start = usec_now();
+  fd = cfs_open("log", CFS_WRITE);
+  for(i = 0; i < LOG_RECORDS; i++) {
+    memset(record, 1 + i % 255, sizeof(record));
+    errors += cfs_write(fd, record, sizeof(record)) != sizeof(record);
+  }
+  cfs_close(fd);
+  elapsed = usec_now() - start;
+  cfs_coffee_get_cache_stats(&after);
+  printf("coffee-bench: log: %d appends in %7lu us, %lu flash reads, %lu flash writes\n",
+         LOG_RECORDS, elapsed, after.flash_reads - before.flash_reads,
+         after.flash_writes - before.flash_writes);
+
+  before = after;
+  start = usec_now();
+  fd = cfs_open("log", CFS_READ);
+  for(i = 0; i < LOG_RECORDS; i++) {
+    memset(expected, 1 + i % 255, sizeof(expected));
+    if(cfs_read(fd, record, sizeof(record)) != sizeof(record) ||
+       memcmp(record, expected, sizeof(record)) != 0) {
+      errors++;
+    }
+  }
+  cfs_close(fd);
+  elapsed = usec_now() - start;
+  cfs_coffee_get_cache_stats(&after);
+  printf("coffee-bench: log: %d reads in   %7lu us, %lu flash reads, %lu hits, %lu misses, %lu read ahead\n",
+         LOG_RECORDS, elapsed, after.flash_reads - before.flash_reads,
+         after.hits - before.hits, after.misses - before.misses,
+         after.read_aheads - before.read_aheads);
+  printf("coffee-bench: log: %s, image digest %04x\n",
+         errors == 0 ? "consistent" : "INCONSISTENT", image_digest());
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coffee_bench_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("coffee-bench: %s, %u cached pages\n",
+#if COFFEE_NAME_INDEX
+         "name index",
+#else
+         "header scan",
+#endif
+         (unsigned)COFFEE_PAGE_CACHE_SIZE);
+
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    run(sizes[i]);
+  }
+  run_log();
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
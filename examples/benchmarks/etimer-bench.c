@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of etimer insertion, removal and expiry with
+ *         thousands of pending event timers.
+ */
+
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define MAX_TIMERS 10000
+
+static struct etimer timers[MAX_TIMERS];
+static const int sizes[] = { 100, 1000, 10000 };
+static int size_index;
+static int num_timers;
+static int fired, fired_synch;
+static unsigned long start, elapsed;
+
+PROCESS(etimer_bench_process, "etimer benchmark");
+AUTOSTART_PROCESSES(&etimer_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_result(const char *what, unsigned long usec, int count)
+{
+  printf("etimer-bench: n %5d: %-6s %5d timers in %7lu us (%lu ns/timer)\n",
+         num_timers, what, count, usec, count > 0 ? usec * 1000 / count : 0);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(etimer_bench_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  for(size_index = 0; size_index < sizeof(sizes) / sizeof(sizes[0]);
+      size_index++) {
+    num_timers = sizes[size_index];
+
+    /* Insert timers with random intervals far in the future, then
+       stop them in insertion order. */
+    start = usec_now();
+    for(i = 0; i < num_timers; i++) {
+      etimer_set(&timers[i], CLOCK_SECOND * 3600 + random_rand());
+    }
+    print_result("set", usec_now() - start, num_timers);
+
+    start = usec_now();
+    for(i = 0; i < num_timers; i++) {
+      etimer_stop(&timers[i]);
+    }
+    print_result("stop", usec_now() - start, num_timers);
+
+    /* Let all timers expire at once. Only the expiry runs started here
+       are timed, not the main loop that delivers the events: the event
+       queue limits each run to a handful of timers. */
+    for(i = 0; i < num_timers; i++) {
+      etimer_set(&timers[i], 0);
+    }
+    elapsed = 0;
+    fired = 0;
+    fired_synch = 0;
+    while(fired < num_timers) {
+      i = process_nevents();
+      start = usec_now();
+      process_post_synch(&etimer_process, PROCESS_EVENT_POLL, NULL);
+      elapsed += usec_now() - start;
+      fired_synch += process_nevents() - i;
+      do {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+        fired++;
+      } while(process_nevents() > 0 && fired < num_timers);
+    }
+    print_result("expire", elapsed, fired_synch);
+
+    for(i = 0; i < num_timers; i++) {
+      if(!etimer_expired(&timers[i])) {
+        printf("etimer-bench: timer %d did not expire\n", i);
+      }
+    }
+  }
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
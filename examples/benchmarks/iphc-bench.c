@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark and equivalence check of the 6LoWPAN IPHC codec.
+ *         Every header of a corpus is compressed through the
+ *         6LoWPAN output path, decompressed through the input path
+ *         and compared with the original. The built-in corpus covers
+ *         all combinations of traffic class, flow label, hop limit,
+ *         next header, UDP port and address compression cases, and
+ *         the digest of its compressed frames must match the one
+ *         recorded with the byte-at-a-time codec. A pcap file of
+ *         IPv6 traffic (Ethernet, raw IP or IPv6 link type) can be
+ *         given as argument to run its headers as well.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/rime/rime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define ROUNDS      20
+#define HDR_MAX     64
+#define FRAME_MAX   PACKETBUF_SIZE
+#define PCAP_MAX    100000
+
+/* FNV-1a digest of the compressed frames of the built-in corpus, as
+   produced by the byte-at-a-time codec */
+#define BUILTIN_DIGEST 0x37efae41UL
+
+#define UIP_IP_BUF   ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+struct header {
+  uip_lladdr_t dest;
+  uint8_t len;
+  uint8_t data[HDR_MAX];
+};
+
+struct frame {
+  uint8_t len;
+  uint8_t data[FRAME_MAX];
+};
+
+static struct header *corpus;
+static struct frame *frames;
+static int corpus_len;
+static int corpus_size;
+
+static struct frame *current_frame;
+static uint8_t decoded[HDR_MAX];
+static uint16_t decoded_len;
+
+PROCESS(iphc_bench_process, "IPHC benchmark");
+AUTOSTART_PROCESSES(&iphc_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sniffer_input(void)
+{
+  decoded_len = uip_len < HDR_MAX ? uip_len : HDR_MAX;
+  memcpy(decoded, UIP_IP_BUF, decoded_len);
+  /* Keep the packet away from the IP stack */
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+static void
+sniffer_output(int mac_status)
+{
+  /* The frame is still in packetbuf, behind the MAC header */
+  if(current_frame != NULL) {
+    current_frame->len = packetbuf_datalen();
+    memcpy(current_frame->data, packetbuf_dataptr(), packetbuf_datalen());
+  }
+}
+RIME_SNIFFER(sniffer, sniffer_input, sniffer_output);
+/*---------------------------------------------------------------------------*/
+static struct header *
+new_header(void)
+{
+  if(corpus_len == corpus_size) {
+    corpus_size = corpus_size == 0 ? 1024 : corpus_size * 2;
+    corpus = realloc(corpus, corpus_size * sizeof(struct header));
+    if(corpus == NULL) {
+      printf("iphc-bench: out of memory\n");
+      exit(1);
+    }
+  }
+  memset(&corpus[corpus_len], 0, sizeof(struct header));
+  return &corpus[corpus_len++];
+}
+/*---------------------------------------------------------------------------*/
+/* Set the length fields the way the decompressor infers them */
+static void
+set_lengths(struct header *h)
+{
+  struct uip_ip_hdr *ip = (struct uip_ip_hdr *)h->data;
+
+  ip->len[0] = (h->len - UIP_IPH_LEN) >> 8;
+  ip->len[1] = (h->len - UIP_IPH_LEN) & 0xff;
+  if(ip->proto == UIP_PROTO_UDP && h->len >= UIP_IPH_LEN + UIP_UDPH_LEN) {
+    memcpy(&h->data[UIP_IPH_LEN + 4], ip->len, 2);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+lladdr_from_iid(uip_lladdr_t *lladdr, const uip_ipaddr_t *addr)
+{
+  memcpy(lladdr, &addr->u8[8], sizeof(uip_lladdr_t));
+  lladdr->addr[0] ^= 0x02;
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_src(uip_ipaddr_t *a, int c)
+{
+  switch(c) {
+  case 0: uip_create_unspecified(a); break;
+  case 1: uip_ip6addr(a, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(a, &uip_lladdr); break;
+  case 2: uip_ip6addr(a, 0xfe80, 0, 0, 0, 0, 0x00ff, 0xfe00, 0x1234); break;
+  case 3: uip_ip6addr(a, 0xfe80, 0, 0, 0, 0x0212, 0x7401, 0x0001, 0x0101); break;
+  case 4: uip_ip6addr(a, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(a, &uip_lladdr); break;
+  case 5: uip_ip6addr(a, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0x00ff, 0xfe00, 0x00aa); break;
+  case 6: uip_ip6addr(a, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0x0212, 0x7402, 0x0002, 0x0202); break;
+  case 7: uip_ip6addr(a, 0x2001, 0x0db8, 0, 0, 0, 0, 0, 0x0001); break;
+  default: uip_ip6addr(a, 0x2001, 0x0db8, 0, 0x0001, 0, 0, 0, 0x0001); break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_dest(uip_ipaddr_t *a, uip_lladdr_t *lladdr, int c)
+{
+  memset(lladdr, 0, sizeof(*lladdr));
+  lladdr->addr[0] = 0x02;
+  lladdr->addr[sizeof(*lladdr) - 1] = 0x77;
+  switch(c) {
+  case 0: uip_ip6addr(a, 0xff02, 0, 0, 0, 0, 0, 0, 0x001a); break;
+  case 1: uip_ip6addr(a, 0xff02, 0, 0, 0, 0, 0, 0x0012, 0x3456); break;
+  case 2: uip_ip6addr(a, 0xff05, 0, 0, 0, 0, 0x0012, 0x3456, 0x789a); break;
+  case 3: uip_ip6addr(a, 0xff0e, 0, 0, 0, 0, 0, 0, 0x0101); break;
+  case 4: uip_ip6addr(a, 0xfe80, 0, 0, 0, 0x0212, 0x7403, 0x0003, 0x0303);
+    lladdr_from_iid(lladdr, a); break;
+  case 5: uip_ip6addr(a, 0xfe80, 0, 0, 0, 0, 0x00ff, 0xfe00, 0x0001); break;
+  case 6: uip_ip6addr(a, 0xfe80, 0, 0, 0, 0x1111, 0x2222, 0x3333, 0x4444); break;
+  case 7: uip_ip6addr(a, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0x0212, 0x7404, 0x0004, 0x0404);
+    lladdr_from_iid(lladdr, a); break;
+  case 8: uip_ip6addr(a, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0x1111, 0x2222, 0x3333, 0x4444); break;
+  case 9: uip_ip6addr(a, 0x2001, 0x0db8, 0, 0, 0, 0, 0, 0x0002); break;
+  default: uip_ip6addr(a, 0x2001, 0x0db8, 0, 0x0001, 0, 0, 0, 0x0002); break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+build_corpus(void)
+{
+  static const uint8_t ttls[] = { 1, 64, 255, 17 };
+  static const uint16_t ports[][2] = {
+    { 0xf0b1, 0xf0b2 }, { 1234, 0xf012 }, { 0xf034, 5683 }, { 5683, 1234 }
+  };
+  struct header *h;
+  struct uip_ip_hdr *ip;
+  int tf, t, nh, s, d, i;
+
+  for(tf = 0; tf < 4; tf++) {
+    for(t = 0; t < sizeof(ttls); t++) {
+      for(nh = 0; nh < 6; nh++) {
+        for(s = 0; s < 9; s++) {
+          for(d = 0; d < 11; d++) {
+            h = new_header();
+            ip = (struct uip_ip_hdr *)h->data;
+            /* Traffic class (DSCP 46, ECN 1) and flow label */
+            ip->vtc = 0x60 | ((tf & 1) ? 0x0b : 0);
+            ip->tcflow = ((tf & 1) ? 0x90 : 0) | ((tf & 2) ? 0x0a : 0);
+            ip->flow = (tf & 2) ? UIP_HTONS(0xbcde) : 0;
+            ip->ttl = ttls[t];
+            make_src(&ip->srcipaddr, s);
+            make_dest(&ip->destipaddr, &h->dest, d);
+            if(nh < 4) {
+              ip->proto = UIP_PROTO_UDP;
+              h->data[UIP_IPH_LEN] = ports[nh][0] >> 8;
+              h->data[UIP_IPH_LEN + 1] = ports[nh][0] & 0xff;
+              h->data[UIP_IPH_LEN + 2] = ports[nh][1] >> 8;
+              h->data[UIP_IPH_LEN + 3] = ports[nh][1] & 0xff;
+              h->data[UIP_IPH_LEN + 6] = 0x5a;
+              h->data[UIP_IPH_LEN + 7] = nh;
+            } else {
+              ip->proto = nh == 4 ? UIP_PROTO_ICMP6 : UIP_PROTO_TCP;
+            }
+            h->len = UIP_IPH_LEN + UIP_UDPH_LEN + 8;
+            for(i = UIP_IPH_LEN + UIP_UDPH_LEN; i < h->len; i++) {
+              h->data[i] = i * 13 + corpus_len;
+            }
+            set_lengths(h);
+          }
+        }
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get32(const uint8_t *p, int swapped)
+{
+  if(swapped) {
+    return p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+  }
+  return p[3] << 24 | p[2] << 16 | p[1] << 8 | p[0];
+}
+/*---------------------------------------------------------------------------*/
+static int
+load_pcap(const char *name)
+{
+  static uint8_t pkt[65536];
+  uint8_t hdr[24];
+  uint32_t magic, linktype, caplen;
+  struct header *h;
+  struct uip_ip_hdr *ip;
+  int swapped, off, count;
+  uint16_t type;
+  FILE *f;
+
+  f = fopen(name, "rb");
+  if(f == NULL || fread(hdr, 1, 24, f) != 24) {
+    printf("iphc-bench: cannot read %s\n", name);
+    return -1;
+  }
+  magic = get32(hdr, 0);
+  swapped = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+  if(!swapped && magic != 0xa1b2c3d4 && magic != 0xa1b23c4d) {
+    printf("iphc-bench: %s is not a pcap file\n", name);
+    fclose(f);
+    return -1;
+  }
+  linktype = get32(&hdr[20], swapped);
+
+  count = 0;
+  while(count < PCAP_MAX && fread(hdr, 1, 16, f) == 16) {
+    caplen = get32(&hdr[8], swapped);
+    if(caplen > sizeof(pkt) || fread(pkt, 1, caplen, f) != caplen) {
+      break;
+    }
+    off = -1;
+    if(linktype == 1 && caplen >= 14) {
+      /* Ethernet, possibly with one VLAN tag */
+      off = 14;
+      type = pkt[12] << 8 | pkt[13];
+      if(type == 0x8100 && caplen >= 18) {
+        type = pkt[16] << 8 | pkt[17];
+        off = 18;
+      }
+      if(type != 0x86dd) {
+        off = -1;
+      }
+    } else if(linktype == 101 || linktype == 229) {
+      off = 0;
+    }
+    if(off < 0 || caplen < off + UIP_IPH_LEN || (pkt[off] & 0xf0) != 0x60) {
+      continue;
+    }
+
+    h = new_header();
+    h->len = caplen - off < HDR_MAX ? caplen - off : HDR_MAX;
+    memcpy(h->data, &pkt[off], h->len);
+    ip = (struct uip_ip_hdr *)h->data;
+    if(ip->proto == UIP_PROTO_UDP && h->len < UIP_IPH_LEN + UIP_UDPH_LEN) {
+      /* Truncated UDP header, keep it as an unknown next header */
+      ip->proto = 253;
+    }
+    /* One link-layer destination for all, as every new one would
+       take a slot in the neighbor table */
+    h->dest.addr[0] = 0x02;
+    h->dest.addr[sizeof(h->dest) - 1] = 0x77;
+    set_lengths(h);
+    count++;
+  }
+  fclose(f);
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+compress_all(int first, int n)
+{
+  unsigned long start;
+  int i;
+
+  start = usec_now();
+  for(i = first; i < first + n; i++) {
+    memcpy(UIP_IP_BUF, corpus[i].data, corpus[i].len);
+    uip_len = corpus[i].len;
+    current_frame = &frames[i];
+    current_frame->len = 0;
+    tcpip_output(&corpus[i].dest);
+  }
+  current_frame = NULL;
+  return usec_now() - start;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+decompress_all(int first, int n, int *mismatches)
+{
+  unsigned long start, elapsed;
+  int i;
+
+  elapsed = 0;
+  *mismatches = 0;
+  for(i = first; i < first + n; i++) {
+    start = usec_now();
+    packetbuf_copyfrom(frames[i].data, frames[i].len);
+    packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER,
+                       (linkaddr_t *)&corpus[i].dest);
+    decoded_len = 0;
+    NETSTACK_NETWORK.input();
+    elapsed += usec_now() - start;
+    if(decoded_len != corpus[i].len ||
+       memcmp(decoded, corpus[i].data, decoded_len) != 0) {
+      (*mismatches)++;
+    }
+  }
+  return elapsed;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+digest(int first, int n, unsigned *bytes)
+{
+  uint32_t hash;
+  int i, j;
+
+  hash = 2166136261UL;
+  *bytes = 0;
+  for(i = first; i < first + n; i++) {
+    hash = (hash ^ frames[i].len) * 16777619UL;
+    for(j = 0; j < frames[i].len; j++) {
+      hash = (hash ^ frames[i].data[j]) * 16777619UL;
+    }
+    *bytes += frames[i].len;
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static int
+run(const char *name, int first, int n, int check_digest)
+{
+  unsigned long ctime, dtime, t;
+  unsigned bytes, hdr_bytes;
+  int r, mismatches, i;
+  uint32_t d;
+
+  /* Keep the fastest round, to filter out noise from the host */
+  ctime = dtime = ~0UL;
+  for(r = 0; r < ROUNDS; r++) {
+    t = compress_all(first, n);
+    ctime = t < ctime ? t : ctime;
+    t = decompress_all(first, n, &mismatches);
+    dtime = t < dtime ? t : dtime;
+  }
+  d = digest(first, n, &bytes);
+  hdr_bytes = 0;
+  for(i = first; i < first + n; i++) {
+    hdr_bytes += corpus[i].len;
+  }
+
+  printf("iphc-bench: %s: %d headers, %u -> %u bytes\n",
+         name, n, hdr_bytes, bytes);
+  printf("iphc-bench: %s: compress %lu ns, decompress %lu ns per header\n",
+         name, ctime * 1000 / n, dtime * 1000 / n);
+  printf("iphc-bench: %s: digest %08lx, %d round-trip mismatches\n",
+         name, (unsigned long)d, mismatches);
+  if(check_digest && d != BUILTIN_DIGEST) {
+    printf("iphc-bench: %s: digest differs from the reference %08lx\n",
+           name, (unsigned long)BUILTIN_DIGEST);
+    return 1;
+  }
+  return mismatches > 0;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(iphc_bench_process, ev, data)
+{
+  int builtin, loaded, failed;
+
+  PROCESS_BEGIN();
+
+  rime_sniffer_add(&sniffer);
+
+  build_corpus();
+  builtin = corpus_len;
+  loaded = 0;
+  if(contiki_argc > 1) {
+    loaded = load_pcap(contiki_argv[1]);
+    if(loaded < 0) {
+      exit(1);
+    }
+  }
+  frames = malloc(corpus_len * sizeof(struct frame));
+  if(frames == NULL) {
+    printf("iphc-bench: out of memory\n");
+    exit(1);
+  }
+
+  failed = run("built-in", 0, builtin, 1);
+  if(loaded > 0) {
+    failed |= run(contiki_argv[1], builtin, loaded, 0);
+  }
+
+  printf("iphc-bench: %s\n", failed ? "FAILED" : "OK");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
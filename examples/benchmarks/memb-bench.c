@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of memb_alloc()/memb_free() for different pool sizes.
+ *         Build once as is and once with DEFINES=MEMB_CONF_FREELIST=1
+ *         to compare the scanning and the free-list allocation modes.
+ */
+
+#include "contiki.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ROUNDS 200000
+
+struct block {
+  uint8_t payload[32];
+};
+
+MEMB(pool16, struct block, 16);
+MEMB(pool64, struct block, 64);
+MEMB(pool256, struct block, 256);
+MEMB(pool1024, struct block, 1024);
+
+static void *allocated[1024];
+
+PROCESS(memb_bench_process, "memb benchmark");
+AUTOSTART_PROCESSES(&memb_bench_process);
+/*---------------------------------------------------------------------------*/
+static void
+run(struct memb *m)
+{
+  clock_time_t start, elapsed;
+  unsigned long i;
+  int j, num_free;
+
+  memb_init(m);
+
+  /* Fill the pool, then keep it full by freeing a random block and
+     allocating a new one, which is the worst case for a scanning
+     allocator. */
+  for(j = 0; j < m->num; j++) {
+    allocated[j] = memb_alloc(m);
+  }
+
+  start = clock_time();
+  num_free = 0;
+  for(i = 0; i < ROUNDS; i++) {
+    j = random_rand() % m->num;
+    memb_free(m, allocated[j]);
+    num_free += memb_numfree(m);
+    allocated[j] = memb_alloc(m);
+    if(allocated[j] == NULL) {
+      printf("memb-bench: allocation failed in pool of %u\n", m->num);
+      exit(1);
+    }
+  }
+  elapsed = clock_time() - start;
+
+  printf("memb-bench: num %4u: %lu alloc/free/numfree rounds in %lu ms (%lu ns/round)\n",
+         m->num, (unsigned long)ROUNDS, (unsigned long)elapsed,
+         (unsigned long)(elapsed * (1000000000UL / CLOCK_SECOND) / ROUNDS));
+  if(num_free != ROUNDS) {
+    printf("memb-bench: unexpected free count %d\n", num_free);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(memb_bench_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("memb-bench: %s mode\n", MEMB_FREELIST ? "free-list" : "scanning");
+
+  run(&pool16);
+  run(&pool64);
+  run(&pool256);
+  run(&pool1024);
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of mmem_alloc()/mmem_free() under random churn.
+ *         Build once as is and once with DEFINES=MMEM_CONF_BUDDY=1
+ *         to compare the compacting and the buddy allocation modes.
+ */
+
+#include "contiki.h"
+#include "lib/mmem.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define ROUNDS     200000
+#define MAX_BLOCKS 256
+
+static struct mmem blocks[MAX_BLOCKS];
+static char live[MAX_BLOCKS];
+static const unsigned int max_sizes[] = { 16, 64, 128 };
+
+PROCESS(mmem_bench_process, "mmem benchmark");
+AUTOSTART_PROCESSES(&mmem_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned int
+random_size(unsigned int max_size)
+{
+  return 1 + random_rand() % max_size;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(unsigned int max_size)
+{
+  unsigned long i, start, elapsed;
+  unsigned long frees, failed;
+  struct mmem_stats stats;
+  int j;
+
+  /* Fill the heap as far as it goes, then keep it under pressure by
+     freeing a random block and allocating a new one of random size.
+     With the compactor, every free moves all blocks above the freed
+     one. */
+  for(j = 0; j < MAX_BLOCKS; j++) {
+    live[j] = mmem_alloc(&blocks[j], random_size(max_size));
+  }
+
+  frees = failed = 0;
+  start = usec_now();
+  for(i = 0; i < ROUNDS; i++) {
+    j = random_rand() % MAX_BLOCKS;
+    if(live[j]) {
+      mmem_free(&blocks[j]);
+      frees++;
+    }
+    live[j] = mmem_alloc(&blocks[j], random_size(max_size));
+    if(!live[j]) {
+      failed++;
+    }
+  }
+  elapsed = usec_now() - start;
+
+  mmem_get_stats(&stats);
+  printf("mmem-bench: size 1-%3u: %lu rounds in %7lu us (%lu ns/round), %lu failed\n",
+         max_size, (unsigned long)ROUNDS, elapsed,
+         elapsed * 1000 / ROUNDS, failed);
+  printf("mmem-bench:   peak %u used %u wasted %u largest free %u moved %lu bytes (%lu/free)\n",
+         stats.peak_used, stats.used, stats.wasted, stats.largest_free,
+         stats.bytes_moved, frees > 0 ? stats.bytes_moved / frees : 0);
+
+  for(j = 0; j < MAX_BLOCKS; j++) {
+    if(live[j]) {
+      mmem_free(&blocks[j]);
+      live[j] = 0;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mmem_bench_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("mmem-bench: %s mode\n", MMEM_BUDDY ? "buddy" : "compacting");
+
+  mmem_init();
+  for(i = 0; i < sizeof(max_sizes) / sizeof(max_sizes[0]); i++) {
+    run(max_sizes[i]);
+  }
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
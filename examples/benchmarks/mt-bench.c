@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of CPU bound mt threads. Build once as is and once
+ *         with DEFINES=MTARCH_CONF_PTHREADS=1 to compare running the
+ *         threads on the Contiki main loop and on a pool of POSIX
+ *         threads.
+ */
+
+#include "contiki.h"
+#include "sys/mt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define NUM_THREADS 8
+#define ROUNDS      10
+#define WORK        20000000UL
+
+static struct mt_thread threads[NUM_THREADS];
+static volatile unsigned long results[NUM_THREADS];
+static process_event_t done_event;
+
+PROCESS(mt_bench_process, "mt benchmark");
+AUTOSTART_PROCESSES(&mt_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+thread_main(void *data)
+{
+  int index = (int)(long)data;
+  unsigned long i, x;
+
+  x = index;
+  while(1) {
+    /* Some work that does not touch any shared state. */
+    for(i = 0; i < WORK; i++) {
+      x = x * 1103515245UL + 12345;
+    }
+    results[index] = x;
+    process_post(&mt_bench_process, done_event, NULL);
+    mt_yield();
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mt_bench_process, ev, data)
+{
+  static unsigned long start;
+  static int round, done;
+  int i;
+
+  PROCESS_BEGIN();
+
+  printf("mt-bench: %s backend\n",
+         MTARCH_PTHREADS ? "POSIX threads" : "cooperative");
+
+  done_event = process_alloc_event();
+  mt_init();
+  for(i = 0; i < NUM_THREADS; i++) {
+    mt_start(&threads[i], thread_main, (void *)(long)i);
+  }
+
+  start = usec_now();
+  for(round = 0; round < ROUNDS; round++) {
+    for(i = 0; i < NUM_THREADS; i++) {
+      mt_exec(&threads[i]);
+    }
+    done = 0;
+    while(done < NUM_THREADS) {
+      PROCESS_WAIT_EVENT_UNTIL(ev == done_event);
+      done++;
+    }
+  }
+
+  printf("mt-bench: %d threads, %d rounds in %lu ms\n",
+         NUM_THREADS, ROUNDS, (usec_now() - start) / 1000);
+
+  for(i = 0; i < NUM_THREADS; i++) {
+    mt_stop(&threads[i]);
+  }
+  mt_remove();
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
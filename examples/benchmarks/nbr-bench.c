@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of neighbor table lookups by link-layer address.
+ *         Build once as is and once with DEFINES=NBR_TABLE_CONF_WITH_HASH=1
+ *         to compare the list walk with the hash index.
+ */
+
+#include "contiki.h"
+#include "net/nbr-table.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define LOOKUPS 200000
+
+struct entry {
+  uint16_t value;
+};
+
+NBR_TABLE(struct entry, bench_table);
+
+static const int sizes[] = { 16, 128, 500 };
+
+PROCESS(nbr_bench_process, "nbr-table benchmark");
+AUTOSTART_PROCESSES(&nbr_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_lladdr(linkaddr_t *lladdr, int i)
+{
+  memset(lladdr, 0, sizeof(linkaddr_t));
+  lladdr->u8[0] = 0x02;
+  lladdr->u8[LINKADDR_SIZE - 2] = i >> 8;
+  lladdr->u8[LINKADDR_SIZE - 1] = i & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(nbr_bench_process, ev, data)
+{
+  static int n, s;
+  linkaddr_t lladdr;
+  struct entry *e;
+  unsigned long start, elapsed;
+  long i;
+  int misses;
+
+  PROCESS_BEGIN();
+
+  printf("nbr-bench: %s lookup, %d max neighbors\n",
+         NBR_TABLE_WITH_HASH ? "hash" : "list", NBR_TABLE_MAX_NEIGHBORS);
+
+  nbr_table_register(bench_table, NULL);
+
+  n = 0;
+  for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for(; n < sizes[s]; n++) {
+      make_lladdr(&lladdr, n);
+      e = nbr_table_add_lladdr(bench_table, &lladdr, NBR_TABLE_REASON_UNDEFINED, NULL);
+      if(e == NULL) {
+        printf("nbr-bench: could not add neighbor %d\n", n);
+        exit(1);
+      }
+      e->value = n;
+    }
+
+    misses = 0;
+    start = usec_now();
+    for(i = 0; i < LOOKUPS; i++) {
+      make_lladdr(&lladdr, random_rand() % n);
+      e = nbr_table_get_from_lladdr(bench_table, &lladdr);
+      if(e == NULL) {
+        misses++;
+      }
+    }
+    elapsed = usec_now() - start;
+    printf("nbr-bench: %3d neighbors: %d lookups in %lu us (%lu ns/lookup)\n",
+           n, LOOKUPS, elapsed, elapsed * 1000 / LOOKUPS);
+    if(misses > 0) {
+      printf("nbr-bench: %d lookups failed\n", misses);
+    }
+  }
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
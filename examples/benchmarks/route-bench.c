@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark of forwarding lookups in the IPv6 routing table.
+ *         Build once as is and once with
+ *         DEFINES=UIP_DS6_ROUTE_CONF_WITH_HASH=1 to compare the list
+ *         walk with the hash index.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define LOOKUPS   20000
+#define NEXTHOPS  8
+
+static const int sizes[] = { 1000, 5000, 10000 };
+
+PROCESS(route_bench_process, "Route lookup benchmark");
+AUTOSTART_PROCESSES(&route_bench_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long
+usec_now(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_host(uip_ipaddr_t *addr, int i)
+{
+  uip_ip6addr(addr, 0xfd00, 0, 0, 0, 0x0212, 0x7400, i >> 16, i & 0xffff);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+run_lookups(int n, int hosts, int *misses)
+{
+  uip_ipaddr_t addr;
+  uip_ds6_route_t *r;
+  unsigned long start;
+  long i;
+
+  *misses = 0;
+  start = usec_now();
+  for(i = 0; i < LOOKUPS; i++) {
+    if(hosts) {
+      make_host(&addr, (random_rand() << 8 ^ random_rand()) % n);
+    } else {
+      /* Destinations that only match the on-link prefix route */
+      uip_ip6addr(&addr, 0xfd01, 0, 0, 0, 0, 0, 0, random_rand());
+    }
+    r = uip_ds6_route_lookup(&addr);
+    if(r == NULL || uip_ds6_route_nexthop(r) == NULL) {
+      (*misses)++;
+    }
+  }
+  return usec_now() - start;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(route_bench_process, ev, data)
+{
+  static uip_ipaddr_t nexthops[NEXTHOPS];
+  static int n, s;
+  uip_ipaddr_t addr;
+  uip_lladdr_t lladdr;
+  unsigned long start, elapsed;
+  int i, misses;
+
+  PROCESS_BEGIN();
+
+  printf("route-bench: %s lookup, %d max routes\n",
+         UIP_DS6_ROUTE_WITH_HASH ? "hash" : "list", UIP_DS6_ROUTE_NB);
+
+  for(i = 0; i < NEXTHOPS; i++) {
+    uip_ip6addr(&nexthops[i], 0xfe80, 0, 0, 0, 0x0212, 0x7400, 0, i + 1);
+    memset(&lladdr, 0, sizeof(lladdr));
+    lladdr.addr[0] = 0x02;
+    lladdr.addr[sizeof(lladdr) - 1] = i + 1;
+    if(uip_ds6_nbr_add(&nexthops[i], &lladdr, 1, NBR_REACHABLE,
+                       NBR_TABLE_REASON_UNDEFINED, NULL) == NULL) {
+      printf("route-bench: could not add neighbor %d\n", i);
+      exit(1);
+    }
+  }
+
+  uip_ip6addr(&addr, 0xfd01, 0, 0, 0, 0, 0, 0, 0);
+  if(uip_ds6_route_add(&addr, 64, &nexthops[0]) == NULL) {
+    printf("route-bench: could not add prefix route\n");
+    exit(1);
+  }
+
+  n = 0;
+  for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    if(sizes[s] >= UIP_DS6_ROUTE_NB) {
+      printf("route-bench: %d routes do not fit in the routing table\n",
+             sizes[s]);
+      break;
+    }
+    start = usec_now();
+    for(i = n; i < sizes[s]; i++) {
+      make_host(&addr, i);
+      if(uip_ds6_route_add(&addr, 128, &nexthops[i % NEXTHOPS]) == NULL) {
+        printf("route-bench: could not add route %d\n", i);
+        exit(1);
+      }
+    }
+    elapsed = usec_now() - start;
+    printf("route-bench: %5d routes: %d added in %lu us\n",
+           sizes[s], sizes[s] - n, elapsed);
+    n = sizes[s];
+
+    elapsed = run_lookups(n, 1, &misses);
+    printf("route-bench: %5d routes: %d host lookups in %lu us (%lu ns/lookup)\n",
+           n, LOOKUPS, elapsed, elapsed * 1000 / LOOKUPS);
+    if(misses > 0) {
+      printf("route-bench: %d host lookups failed\n", misses);
+    }
+
+    elapsed = run_lookups(n, 0, &misses);
+    printf("route-bench: %5d routes: %d prefix lookups in %lu us (%lu ns/lookup)\n",
+           n, LOOKUPS, elapsed, elapsed * 1000 / LOOKUPS);
+    if(misses > 0) {
+      printf("route-bench: %d prefix lookups failed\n", misses);
+    }
+  }
+
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
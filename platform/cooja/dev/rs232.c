@@ -96,9 +96,8 @@ doInterfaceActionsBeforeTick(void)
     }
   } else {
     /* Notify serial process */
-    for (i=0; i < simSerialReceivingLength; i++) {
-      serial_line_input_byte(simSerialReceivingData[i]);
-    }
+    serial_line_input_bytes((unsigned char *)simSerialReceivingData,
+                            simSerialReceivingLength);
     serial_line_input_byte(0x0a);
   }
 
@@ -55,6 +55,36 @@
 #define COFFEE_LOG_SIZE			8192
 #define COFFEE_LOG_TABLE_LIMIT		256
 #define COFFEE_MICRO_LOGS		0
+#ifdef COFFEE_CONF_PAGE_CACHE_SIZE
+#define COFFEE_PAGE_CACHE_SIZE		COFFEE_CONF_PAGE_CACHE_SIZE
+#else
+#define COFFEE_PAGE_CACHE_SIZE		8
+#endif
+#ifdef COFFEE_CONF_NAME_INDEX
+#define COFFEE_NAME_INDEX		COFFEE_CONF_NAME_INDEX
+#else
+#define COFFEE_NAME_INDEX		0
+#endif
+#ifdef COFFEE_CONF_NAME_INDEX_SIZE
+#define COFFEE_NAME_INDEX_SIZE		COFFEE_CONF_NAME_INDEX_SIZE
+#else
+#define COFFEE_NAME_INDEX_SIZE		32
+#endif
+#ifdef COFFEE_CONF_GC_PROCESS
+#define COFFEE_GC_PROCESS		COFFEE_CONF_GC_PROCESS
+#else
+#define COFFEE_GC_PROCESS		0
+#endif
+#ifdef COFFEE_CONF_GC_WATERMARK
+#define COFFEE_GC_WATERMARK		COFFEE_CONF_GC_WATERMARK
+#else
+#define COFFEE_GC_WATERMARK		2
+#endif
+#ifdef COFFEE_CONF_GC_INTERVAL
+#define COFFEE_GC_INTERVAL		COFFEE_CONF_GC_INTERVAL
+#else
+#define COFFEE_GC_INTERVAL		(CLOCK_SECOND / 8)
+#endif
 
 #define COFFEE_WRITE(buf, size, offset)				\
 		xmem_pwrite((char *)(buf), (size), COFFEE_START + (offset))
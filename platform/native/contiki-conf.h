@@ -272,4 +272,12 @@ int strcasecmp(const char*, const char*);
 #include PROJECT_CONF_H
 #endif /* PROJECT_CONF_H */
 
+#if MTARCH_CONF_PTHREADS
+/* mt threads run on POSIX threads and may post events concurrently */
+void mtarch_lock(void);
+void mtarch_unlock(void);
+#define PROCESS_CONF_LOCK()   mtarch_lock()
+#define PROCESS_CONF_UNLOCK() mtarch_unlock()
+#endif /* MTARCH_CONF_PTHREADS */
+
 #endif /* CONTIKI_CONF_H_ */
@@ -129,10 +129,12 @@ stdin_set_fd(fd_set *rset, fd_set *wset)
 static void
 stdin_handle_fd(fd_set *rset, fd_set *wset)
 {
-  char c;
+  unsigned char buf[32];
+  int len;
   if(FD_ISSET(STDIN_FILENO, rset)) {
-    if(read(STDIN_FILENO, &c, 1) > 0) {
-      serial_line_input_byte(c);
+    len = read(STDIN_FILENO, buf, sizeof(buf));
+    if(len > 0) {
+      serial_line_input_bytes(buf, len);
     }
   }
 }
@@ -34,4 +34,7 @@
 
 #define UNIT_TEST_PRINT_FUNCTION test_print_report
 
+/* Deliver subscribed broadcast events to their subscribers only */
+#define PROCESS_CONF_SUBSCRIPTIONS 1
+
 #endif /* !_PROJECT_CONF_H_ */
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "unit-test.h"
+
+#include "dev/serial-line.h"
+
+PROCESS(test_process, "process subscriptions test");
+PROCESS(listener_process, "listener");
+PROCESS(subscriber_process, "subscriber");
+AUTOSTART_PROCESSES(&test_process);
+
+static process_event_t test_event;
+static struct process_subscription subscription;
+
+/* Events received by the listener, which never subscribes, and by the
+   subscriber, which subscribes to test_event only */
+static int listener_lines, listener_tests;
+static int subscriber_lines, subscriber_tests;
+
+static void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+
+PROCESS_THREAD(listener_process, ev, data)
+{
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    if(ev == serial_line_event_message) {
+      listener_lines++;
+    } else if(ev == test_event) {
+      listener_tests++;
+    }
+  }
+  PROCESS_END();
+}
+
+PROCESS_THREAD(subscriber_process, ev, data)
+{
+  PROCESS_BEGIN();
+  process_subscribe(&subscription, test_event);
+  while(1) {
+    PROCESS_WAIT_EVENT();
+    if(ev == serial_line_event_message) {
+      subscriber_lines++;
+    } else if(ev == test_event) {
+      subscriber_tests++;
+    }
+  }
+  PROCESS_END();
+}
+
+UNIT_TEST_REGISTER(test_unsubscribed_event,
+                   "A stock event without subscribers reaches every process");
+UNIT_TEST(test_unsubscribed_event)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(listener_lines == 1 && subscriber_lines == 1);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(test_subscribed_event,
+                   "A subscribed event only reaches its subscribers");
+UNIT_TEST(test_subscribed_event)
+{
+  UNIT_TEST_BEGIN();
+
+  UNIT_TEST_ASSERT(subscriber_tests == 1 && listener_tests == 0);
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  test_event = process_alloc_event();
+  process_start(&listener_process, NULL);
+  process_start(&subscriber_process, NULL);
+
+  process_post(PROCESS_BROADCAST, serial_line_event_message, "test");
+  process_post(PROCESS_BROADCAST, test_event, NULL);
+  /* Both broadcasts are delivered before the continue event */
+  PROCESS_PAUSE();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_unsubscribed_event);
+  UNIT_TEST_RUN(test_subscribed_event);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2017, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "unit-test.h"
+
+#include "lib/ringbuf.h"
+#include "lib/ringbufelem.h"
+
+PROCESS(test_process, "ringbuf bulk and ringbufelem test");
+AUTOSTART_PROCESSES(&test_process);
+
+static struct ringbuf r;
+static uint8_t r_data[8];
+
+struct elem {
+  uint16_t a;
+  uint8_t b;
+};
+
+static struct ringbufelem re;
+static struct elem re_data[4];
+
+static void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+
+UNIT_TEST_REGISTER(test_ringbuf_put_bulk, "Put bulk");
+UNIT_TEST(test_ringbuf_put_bulk)
+{
+  static const uint8_t in[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  int ret;
+
+  UNIT_TEST_BEGIN();
+
+  ringbuf_init(&r, r_data, sizeof(r_data));
+
+  /* Only size - 1 bytes fit */
+  ret = ringbuf_put_bulk(&r, in, sizeof(in));
+  UNIT_TEST_ASSERT(ret == 7 && ringbuf_elements(&r) == 7);
+
+  /* Full */
+  ret = ringbuf_put_bulk(&r, in, 1);
+  UNIT_TEST_ASSERT(ret == 0 && ringbuf_put(&r, 0) == 0);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(test_ringbuf_get_bulk, "Get bulk");
+UNIT_TEST(test_ringbuf_get_bulk)
+{
+  static const uint8_t in[] = { 1, 2, 3, 4, 5, 6 };
+  uint8_t out[8];
+  int ret;
+
+  UNIT_TEST_BEGIN();
+
+  ringbuf_init(&r, r_data, sizeof(r_data));
+
+  /* Move the pointers close to the end of the array */
+  ret = ringbuf_put_bulk(&r, in, 5);
+  UNIT_TEST_ASSERT(ret == 5);
+  ret = ringbuf_get_bulk(&r, out, 5);
+  UNIT_TEST_ASSERT(ret == 5 && memcmp(out, in, 5) == 0);
+
+  /* Put and get across the end of the array */
+  ret = ringbuf_put_bulk(&r, in, 6);
+  UNIT_TEST_ASSERT(ret == 6 && r.put_ptr == 3);
+  ret = ringbuf_get(&r);
+  UNIT_TEST_ASSERT(ret == 1);
+  ret = ringbuf_get_bulk(&r, out, sizeof(out));
+  UNIT_TEST_ASSERT(ret == 5 && memcmp(out, &in[1], 5) == 0);
+
+  /* Empty */
+  ret = ringbuf_get_bulk(&r, out, sizeof(out));
+  UNIT_TEST_ASSERT(ret == 0 && ringbuf_get(&r) == -1);
+
+  UNIT_TEST_END();
+}
+
+UNIT_TEST_REGISTER(test_ringbufelem, "Elements");
+UNIT_TEST(test_ringbufelem)
+{
+  struct elem in[3] = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+  struct elem out[4];
+  int ret;
+
+  UNIT_TEST_BEGIN();
+
+  ringbufelem_init(&re, re_data, sizeof(struct elem), 4);
+  UNIT_TEST_ASSERT(ringbufelem_size(&re) == 4 &&
+                   ringbufelem_elements(&re) == 0);
+
+  ret = ringbufelem_put(&re, &in[0]);
+  UNIT_TEST_ASSERT(ret == 1);
+  ret = ringbufelem_get(&re, &out[0]);
+  UNIT_TEST_ASSERT(ret == 1 && out[0].a == 1 && out[0].b == 2);
+
+  /* Wraps around, and only three elements fit */
+  ret = ringbufelem_put_bulk(&re, in, 3);
+  UNIT_TEST_ASSERT(ret == 3 && ringbufelem_put(&re, &in[0]) == 0);
+  ret = ringbufelem_get_bulk(&re, out, 4);
+  UNIT_TEST_ASSERT(ret == 3 && memcmp(out, in, sizeof(in)) == 0);
+  ret = ringbufelem_get(&re, &out[0]);
+  UNIT_TEST_ASSERT(ret == 0 && ringbufelem_elements(&re) == 0);
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_ringbuf_put_bulk);
+  UNIT_TEST_RUN(test_ringbuf_get_bulk);
+  UNIT_TEST_RUN(test_ringbufelem);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}
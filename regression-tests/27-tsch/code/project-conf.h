@@ -38,6 +38,13 @@
 #undef QUEUEBUF_CONF_NUM
 #define QUEUEBUF_CONF_NUM   1
 
+/* Queue control traffic apart from data for the traffic_class test, and
+   let data use the single packet as well */
+#undef TSCH_QUEUE_CONF_WITH_PRIORITIES
+#define TSCH_QUEUE_CONF_WITH_PRIORITIES 1
+#undef TSCH_QUEUE_CONF_CONTROL_RESERVE
+#define TSCH_QUEUE_CONF_CONTROL_RESERVE 0
+
 #undef TSCH_LOG_CONF_LEVEL
 #define TSCH_LOG_CONF_LEVEL 2
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "contiki-lib.h"
+#include "lib/assert.h"
+#include "lib/ringbufindex.h"
+
+#include "net/ipv6/uip-icmp6.h"
+#include "net/rpl/rpl-private.h"
+#include "net/mac/tsch/tsch.h"
+#include "net/mac/tsch/tsch-queue.h"
+
+#include "unit-test.h"
+#include "common.h"
+
+PROCESS(test_process, "TSCH traffic class test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define UIP_ICMP_PAYLOAD ((unsigned char *)&uip_buf[uip_l2_l3_icmp_hdr_len])
+#define TEST_PAYLOAD_LEN 24
+
+static int
+queued(uint8_t traffic_class)
+{
+  return ringbufindex_elements(&n_broadcast->tx_ringbuf[traffic_class]);
+}
+
+/* Send an ICMPv6 message to all RPL nodes through sicslowpan */
+static void
+send_icmp6(uint8_t type, uint8_t code)
+{
+  uip_ipaddr_t dest;
+
+  uip_ip6addr(&dest, 0xff02, 0, 0, 0, 0, 0, 0, 0x001a);
+  uip_ext_len = 0;
+  memset(UIP_ICMP_PAYLOAD, 0, TEST_PAYLOAD_LEN);
+  uip_icmp6_send(&dest, type, code, TEST_PAYLOAD_LEN);
+}
+
+UNIT_TEST_REGISTER(test,
+                   "a DIO should be queued as control and an echo as data");
+UNIT_TEST(test)
+{
+  UNIT_TEST_BEGIN();
+
+  /* Drop anything RPL may have queued in the meantime */
+  tsch_queue_reset();
+  UNIT_TEST_ASSERT(n_broadcast != NULL);
+
+  send_icmp6(ICMP6_RPL, RPL_CODE_DIO);
+  UNIT_TEST_ASSERT(queued(TSCH_QUEUE_CLASS_CONTROL) == 1);
+  UNIT_TEST_ASSERT(queued(TSCH_QUEUE_CLASS_DATA) == 0);
+
+  /* QUEUEBUF_CONF_NUM is set with 1; free the packet for the echo */
+  tsch_queue_reset();
+
+  send_icmp6(ICMP6_ECHO_REQUEST, 0);
+  UNIT_TEST_ASSERT(queued(TSCH_QUEUE_CLASS_CONTROL) == 0);
+  UNIT_TEST_ASSERT(queued(TSCH_QUEUE_CLASS_DATA) == 1);
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  tsch_set_coordinator(1);
+
+  etimer_set(&et, CLOCK_SECOND);
+  while(tsch_is_associated == 0) {
+    PROCESS_YIELD_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+  }
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}